@@ -29,6 +29,7 @@ import java.util.Comparator;
 public class Parameters extends ParameterComponent {
   public final ServerVersionParameter serverVersion;
   public final ClientPriorityParameter clientPriority;
+  public final ClientStatisticsParameter clientStatistics;
   public final DriverNameParameter driverName;
   public final DriverCodeParameter driverCode;
   public final DriverVersionParameter driverVersion;
@@ -65,6 +66,7 @@ public class Parameters extends ParameterComponent {
 
     serverVersion = new ServerVersionParameter(connection);
     clientPriority = new ClientPriorityParameter(connection);
+    clientStatistics = new ClientStatisticsParameter(connection);
     driverName = new DriverNameParameter(connection);
     driverCode = new DriverCodeParameter(connection);
     driverVersion = new DriverVersionParameter(connection);
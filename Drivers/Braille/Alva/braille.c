@@ -589,6 +589,7 @@ typedef struct {
 
   int (*readCommand) (BrailleDisplay *brl);
   int (*writeBraille) (BrailleDisplay *brl, const unsigned char *cells, int start, int count);
+  CellWriteCost writeCost;
 } ProtocolOperations;
 static const ProtocolOperations *protocol;
 
@@ -1161,7 +1162,12 @@ static const ProtocolOperations protocol1Operations = {
   .detectModel = detectModel1,
 
   .readCommand = readCommand1,
-  .writeBraille = writeBraille1
+  .writeBraille = writeBraille1,
+
+  .writeCost = {
+    .packetBytes = 6,
+    .cellBytes = 1
+  }
 };
 
 static void
@@ -1646,7 +1652,12 @@ static const ProtocolOperations protocol2sOperations = {
   .detectModel = detectModel2s,
 
   .readCommand = readCommand2s,
-  .writeBraille = writeBraille2s
+  .writeBraille = writeBraille2s,
+
+  .writeCost = {
+    .packetBytes = 4,
+    .cellBytes = 1
+  }
 };
 
 static BraillePacketVerifierResult
@@ -1839,7 +1850,12 @@ static const ProtocolOperations protocol2uOperations = {
   .detectModel = detectModel2u,
 
   .readCommand = readCommand2u,
-  .writeBraille = writeBraille2u
+  .writeBraille = writeBraille2u,
+
+  .writeCost = {
+    .packetBytes = 3,
+    .cellBytes = 1
+  }
 };
 
 static BrailleDisplay *brailleDisplay = NULL;
@@ -1991,20 +2007,33 @@ brl_destruct (BrailleDisplay *brl) {
   }
 }
 
+static int
+writeTextCells (BrailleDisplay *brl, unsigned int from, unsigned int to) {
+  size_t count = to - from;
+  unsigned char cells[count];
+
+  translateOutputCells(cells, &brl->buffer[from], count);
+  return protocol->writeBraille(brl, cells, textOffset+from, count);
+}
+
 static int
 brl_writeWindow (BrailleDisplay *brl, const wchar_t *text) {
-  unsigned int from;
-  unsigned int to;
+  if (model->flags & MOD_FLAG_FORCE_FROM_0) {
+    unsigned int to;
 
-  if (cellsHaveChanged(previousText, brl->buffer, brl->textColumns, &from, &to, &textRewriteRequired)) {
-    if (model->flags & MOD_FLAG_FORCE_FROM_0) from = 0;
+    if (cellsHaveChanged(previousText, brl->buffer, brl->textColumns, NULL, &to, &textRewriteRequired)) {
+      if (!writeTextCells(brl, 0, to)) return 0;
+    }
+  } else {
+    CellSpan spans[4];
+    unsigned int count = planCellWrites(previousText, brl->buffer, brl->textColumns,
+                                        spans, ARRAY_COUNT(spans),
+                                        &protocol->writeCost, &textRewriteRequired);
 
-    {
-      size_t count = to - from;
-      unsigned char cells[count];
+    for (unsigned int index=0; index<count; index+=1) {
+      const CellSpan *span = &spans[index];
 
-      translateOutputCells(cells, &brl->buffer[from], count);
-      if (!protocol->writeBraille(brl, cells, textOffset+from, count)) return 0;
+      if (!writeTextCells(brl, span->from, span->to)) return 0;
     }
   }
 
@@ -27,6 +27,7 @@
 #include "async_alarm.h"
 #include "timing.h"
 
+#define BRL_HAVE_WINDOW_ROWS
 #include "brl_driver.h"
 #include "brldefs-cn.h"
 
@@ -598,19 +599,31 @@ brl_destruct (BrailleDisplay *brl) {
   brl->data = NULL;
 }
 
-static int
-brl_writeWindow (BrailleDisplay *brl, const wchar_t *text) {
+static void
+updateRow (BrailleDisplay *brl, unsigned int index) {
   unsigned int length = brl->textColumns;
-  const unsigned char *cells = brl->buffer;
+  RowEntry *row = getRowEntry(brl, index);
+
+  if (cellsHaveChanged(row->cells, &brl->buffer[index * length], length, NULL, NULL, &row->force)) {
+    setRowHasChanged(brl, index);
+  }
+}
 
+static int
+brl_writeWindow (BrailleDisplay *brl, const wchar_t *text) {
   for (unsigned int index=0; index<brl->textRows; index+=1) {
-    RowEntry *row = getRowEntry(brl, index);
+    updateRow(brl, index);
+  }
 
-    if (cellsHaveChanged(row->cells, cells, length, NULL, NULL, &row->force)) {
-      setRowHasChanged(brl, index);
-    }
+  return 1;
+}
 
-    cells += length;
+static int
+brl_writeWindowRows (BrailleDisplay *brl, const wchar_t *text, const unsigned char *changedRows) {
+  for (unsigned int index=0; index<brl->textRows; index+=1) {
+    if (changedRows[index] || getRowEntry(brl, index)->force) {
+      updateRow(brl, index);
+    }
   }
 
   return 1;
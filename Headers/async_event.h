@@ -39,6 +39,8 @@ extern AsyncEvent *asyncNewEvent (AsyncEventCallback *callback, void *data);
 extern void asyncDiscardEvent (AsyncEvent *event);
 extern int asyncSignalEvent (AsyncEvent *event, void *data);
 
+extern int asyncSetEventQueueing (int enabled);
+
 typedef AsyncEvent *AsyncEventCreator (void *data);
 
 extern AsyncEvent *asyncGetProgramEvent (
@@ -57,6 +57,12 @@ static int brl_writeStatus (BrailleDisplay *brl, const unsigned char *cells);
 #define brl_writeStatus NULL
 #endif /* BRL_HAVE_STATUS_CELLS */
 
+#ifdef BRL_HAVE_WINDOW_ROWS
+static int brl_writeWindowRows (BrailleDisplay *brl, const wchar_t *characters, const unsigned char *changedRows);
+#else /* BRL_HAVE_WINDOW_ROWS */
+#define brl_writeWindowRows NULL
+#endif /* BRL_HAVE_WINDOW_ROWS */
+
 #ifdef BRL_HAVE_PACKET_IO
 static ssize_t brl_readPacket (BrailleDisplay *brl, void *buffer, size_t size);
 static ssize_t brl_writePacket (BrailleDisplay *brl, const void *buffer, size_t size);
@@ -84,6 +90,7 @@ const BrailleDriver BRLSYMBOL = {
   brl_readCommand,
   brl_writeWindow,
   brl_writeStatus,
+  brl_writeWindowRows,
 
   brl_readPacket,
   brl_writePacket,
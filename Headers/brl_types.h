@@ -89,6 +89,12 @@ struct BrailleDisplayStruct {
   unsigned char quality;
   unsigned char isCoreBuffer:1;
 
+  struct {
+    unsigned char *cells;
+    unsigned char *changed;
+    unsigned char force;
+  } rows;
+
   void (*bufferResized) (unsigned int rows, unsigned int columns);
   unsigned char resizeRequired:1;
 
@@ -134,6 +140,7 @@ typedef struct {
   int (*readCommand) (BrailleDisplay *brl, KeyTableCommandContext context);
   int (*writeWindow) (BrailleDisplay *brl, const wchar_t *characters);
   int (*writeStatus) (BrailleDisplay *brl, const unsigned char *cells);
+  int (*writeWindowRows) (BrailleDisplay *brl, const wchar_t *characters, const unsigned char *changedRows);
 
   ssize_t (*readPacket) (BrailleDisplay *brl, void *buffer, size_t size);
   ssize_t (*writePacket) (BrailleDisplay *brl, const void *packet, size_t size);
@@ -38,6 +38,38 @@ extern int cellsHaveChanged (
   unsigned int *from, unsigned int *to, unsigned char *force
 );
 
+typedef struct {
+  unsigned int from;
+  unsigned int to;
+} CellSpan;
+
+extern unsigned int cellsHaveChangedSpans (
+  unsigned char *cells, const unsigned char *new, unsigned int count,
+  CellSpan *spans, unsigned int limit, unsigned int gap, unsigned char *force
+);
+
+typedef struct {
+  unsigned int packetBytes; /* bytes added to each write (header, start, count, trailer) */
+  unsigned int cellBytes; /* bytes needed for each cell */
+  unsigned int escapeBytes; /* bytes added for each cell equal to escapeCell */
+  unsigned char escapeCell;
+} CellWriteCost;
+
+extern unsigned int getCellWriteBytes (
+  const unsigned char *cells, const CellSpan *span, const CellWriteCost *cost
+);
+
+extern unsigned int planCellWrites (
+  unsigned char *cells, const unsigned char *new, unsigned int count,
+  CellSpan *spans, unsigned int limit, const CellWriteCost *cost, unsigned char *force
+);
+
+extern unsigned int cellRowsHaveChanged (
+  unsigned char *cells, const unsigned char *new,
+  unsigned int columns, unsigned int rows,
+  unsigned char *changedRows, unsigned char *force
+);
+
 extern int textHasChanged (
   wchar_t *text, const wchar_t *new, unsigned int count,
   unsigned int *from, unsigned int *to, unsigned char *force
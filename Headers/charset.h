@@ -33,9 +33,11 @@ extern int isPosixLocale (const char *locale);
 
 extern const char *setCharset (const char *name);
 extern const char *getCharset (void);
+extern unsigned int getCharsetGeneration (void);
 
 extern const char *getLocaleCharset (void);
 extern const char *getWcharCharset (void);
+extern int isCharsetWchar (const char *name);
 
 extern size_t convertCharToUtf8 (char c, Utf8Buffer utf8);
 extern int convertUtf8ToChar (const char **utf8, size_t *utfs);
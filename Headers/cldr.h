@@ -60,6 +60,24 @@ extern int cldrParseFile (
   CLDR_AnnotationHandler *handler, void *data
 );
 
+extern const char cldrIndexExtension[];
+typedef struct CLDR_AnnotationIndexStruct CLDR_AnnotationIndex;
+
+extern CLDR_AnnotationIndex *cldrOpenAnnotationIndex (const char *name);
+extern void cldrCloseAnnotationIndex (CLDR_AnnotationIndex *index);
+extern unsigned int cldrGetAnnotationCount (const CLDR_AnnotationIndex *index);
+
+extern const char *cldrFindAnnotation (
+  const CLDR_AnnotationIndex *index, const char *sequence
+);
+
+extern int cldrProcessAnnotationIndex (
+  const CLDR_AnnotationIndex *index,
+  CLDR_AnnotationHandler *handler, void *data
+);
+
+extern int cldrMakeAnnotationIndex (const char *name, const char *indexPath);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
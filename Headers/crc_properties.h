@@ -28,6 +28,8 @@ extern "C" {
 
 #define CRC_BYTE_WIDTH 8
 #define CRC_BYTE_INDEXED_TABLE_SIZE (UINT8_MAX + 1)
+#define CRC_SLICE_TABLE_COUNT 16
+#define CRC_FOLDING_CONSTANT_COUNT 7
 
 extern crc_t crcMostSignificantBit (unsigned int width);
 extern crc_t crcReflectBits (crc_t fromValue, unsigned int width);
@@ -42,6 +44,19 @@ typedef struct {
 
   // for preevaluating a common calculation on each data byte
   crc_t remainderCache[CRC_BYTE_INDEXED_TABLE_SIZE];
+
+  /* for processing eight or sixteen data bytes at a time
+   * (table n is the remainder for a byte followed by n zero bytes)
+   * the tables are shared by all of the generators for the same algorithm
+   */
+  unsigned int sliceShift; /* the bit offset of the value within a slicing register */
+  const crc_t (*sliceTables)[CRC_BYTE_INDEXED_TABLE_SIZE]; /* NULL if they couldn't be made */
+
+  /* for folding sixteen-byte blocks via carry-less multiplication
+   * (only for reflected 32-bit algorithms when the processor supports it)
+   */
+  unsigned char canFold;
+  uint64_t foldingConstants[CRC_FOLDING_CONSTANT_COUNT];
 } CRCProperties;
 
 extern void crcMakeProperties (
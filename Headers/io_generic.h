@@ -56,6 +56,7 @@ extern int gioReconfigureResource (
 
 extern unsigned int gioGetBytesPerSecond (GioEndpoint *endpoint);
 extern unsigned int gioGetMillisecondsToTransfer (GioEndpoint *endpoint, size_t bytes);
+extern ssize_t gioGetPendingOutput (GioEndpoint *endpoint);
 
 extern ssize_t gioTellResource (
   GioEndpoint *endpoint,
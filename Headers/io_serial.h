@@ -50,6 +50,7 @@ extern int serialFlushOutput (SerialDevice *serial);
 extern int serialMonitorInput (SerialDevice *serial, AsyncMonitorCallback *callback, void *data);
 extern int serialAwaitInput (SerialDevice *serial, int timeout);
 extern int serialAwaitOutput (SerialDevice *serial);
+extern ssize_t serialGetPendingOutput (SerialDevice *serial);
 
 extern ssize_t serialReadData (
   SerialDevice *serial,
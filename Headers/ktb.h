@@ -44,6 +44,11 @@ typedef struct {
 } KeyTableListMethods;
 
 extern int listKeyTable (KeyTable *table, const KeyTableListMethods *methods, KeyTableWriteLineMethod *writeLine, void *data);
+
+typedef struct KeyTableListerStruct KeyTableLister;
+extern KeyTableLister *newKeyTableLister (KeyTable *table, const KeyTableListMethods *methods, KeyTableWriteLineMethod *writeLine, void *data);
+extern void destroyKeyTableLister (KeyTableLister *ktl);
+extern int listKeyTableSection (KeyTableLister *ktl, int *done);
 extern int listKeyNames (KEY_NAME_TABLES_REFERENCE keys, KeyTableWriteLineMethod *writeLine, void *data);
 extern int auditKeyTable (KeyTable *table, const char *path);
 
@@ -61,6 +66,17 @@ extern KeyTableState processKeyEvent (
   KeyGroup keyGroup, KeyNumber keyNumber, int press
 );
 
+typedef struct {
+  KeyGroup group;
+  KeyNumber number;
+  unsigned char press;
+} KeyTableEvent;
+
+extern KeyTableState processKeyEvents (
+  KeyTable *table, unsigned char context,
+  const KeyTableEvent *events, unsigned int count
+);
+
 extern void setKeyTableLogLabel (KeyTable *table, const char *label);
 extern void setLogKeyEventsFlag (KeyTable *table, const unsigned char *flag);
 extern void setKeyboardEnabledFlag (KeyTable *table, const unsigned char *flag);
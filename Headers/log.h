@@ -71,6 +71,8 @@ typedef enum {
   LOG_CATEGORY_INDEX(SPEECH_EVENTS),
   LOG_CATEGORY_INDEX(ASYNC_EVENTS),
   LOG_CATEGORY_INDEX(SERVER_EVENTS),
+  LOG_CATEGORY_INDEX(STARTUP_EVENTS),
+  LOG_CATEGORY_INDEX(QUEUE_EVENTS),
 
   LOG_CATEGORY_INDEX(SERIAL_IO),
   LOG_CATEGORY_INDEX(USB_IO),
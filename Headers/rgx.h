@@ -155,6 +155,11 @@ extern int rgxMatchOption (
   RGX_MatchOption option
 );
 
+extern int rgxCombinePatterns (
+  RGX_Object *rgx,
+  RGX_OptionAction action
+);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -83,6 +83,7 @@ extern long int millisecondsTillNextMinute (const TimeValue *reference);
 
 extern void getMonotonicTime (TimeValue *now);
 extern long int getMonotonicElapsed (const TimeValue *start);
+extern int64_t getMonotonicNanosecondsElapsed (const TimeValue *start);
 
 typedef struct {
   TimeValue start;
@@ -39,10 +39,12 @@ extern char *getTextTableForLocale (const char *directory);
 extern int replaceTextTable (const char *directory, const char *name);
 
 extern unsigned char convertCharacterToDots (TextTable *table, wchar_t character);
+extern void convertCharactersToDots (TextTable *table, const wchar_t *characters, unsigned char *cells, size_t count);
 extern wchar_t convertDotsToCharacter (TextTable *table, unsigned char dots);
 extern wchar_t convertInputToCharacter (unsigned char dots);
 
 extern void setTryBaseCharacter (TextTable *table, unsigned char yes);
+extern unsigned int getTextTableGeneration (void);
 
 extern size_t getTextTableRowsMask (TextTable *table, uint8_t *mask, size_t size);
 extern int getTextTableRowCells (TextTable *table, uint32_t rowIndex, uint8_t *cells, uint8_t *defined);
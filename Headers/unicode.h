@@ -79,6 +79,14 @@ extern int getCharacterByName (wchar_t *character, const char *name);
 extern int getCharacterAlias (wchar_t character, char *buffer, size_t size);
 extern int getCharacterByAlias (wchar_t *character, const char *alias);
 
+typedef enum {
+  UNICODE_PROPERTY_IDEOGRAPHIC  = 0X01,
+  UNICODE_PROPERTY_EMOJI        = 0X02,
+  UNICODE_PROPERTY_COMBINING    = 0X04,
+  UNICODE_PROPERTY_NFC_UNSTABLE = 0X08, /* NFC_Quick_Check is No or Maybe */
+} UnicodeProperty;
+
+extern unsigned int getCharacterProperties (wchar_t character);
 extern int getCharacterWidth (wchar_t character);
 
 extern int isBrailleCharacter (wchar_t character);
@@ -91,6 +99,16 @@ extern int normalizeCharacters (
   wchar_t *buffer, unsigned int *map
 );
 
+typedef struct {
+  unsigned long int calls;
+  unsigned long int skipped;
+  unsigned long int changed;
+  unsigned long int spans;
+  unsigned long int characters;
+} NormalizationStatistics;
+
+extern void getNormalizationStatistics (NormalizationStatistics *statistics);
+
 extern wchar_t getBaseCharacter (wchar_t character);
 extern wchar_t getTransliteratedCharacter (wchar_t character);
 
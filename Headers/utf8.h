@@ -39,6 +39,11 @@ extern wint_t convertUtf8ToWchar (const char **utf8, size_t *utfs);
 
 extern void convertUtf8ToWchars (const char **utf8, wchar_t **characters, size_t count);
 
+extern int convertUtf8TextToWchars (
+  const char **utf8, size_t *utfs,
+  wchar_t **characters, size_t *count
+);
+
 extern size_t makeUtf8FromWchars (const wchar_t *characters, unsigned int count, char *buffer, size_t size);
 extern char *getUtf8FromWchars (const wchar_t *characters, unsigned int count, size_t *length);
 
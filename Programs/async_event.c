@@ -19,6 +19,7 @@
 #include "prologue.h"
 
 #include <string.h>
+#include <errno.h>
 
 #include "log.h"
 #include "async_io.h"
@@ -26,6 +27,24 @@
 #include "async_internal.h"
 #include "file.h"
 
+#if defined(HAVE_SYS_EVENTFD_H) && defined(HAVE_SYS_SIGNALFD_H)
+/* Signals are monitored via a signalfd in this case, which means that
+ * asyncSignalEvent() is never called from a signal handler and may thus
+ * allocate memory.
+ */
+#define ASYNC_EVENT_QUEUE
+#include <sys/eventfd.h>
+
+typedef struct AsyncEventItemStruct AsyncEventItem;
+
+struct AsyncEventItemStruct {
+  AsyncEventItem *next;
+  void *data;
+};
+
+static int eventQueueingEnabled = 1;
+#endif /* ASYNC_EVENT_QUEUE */
+
 struct AsyncEventStruct {
   AsyncEventCallback *callback;
   void *data;
@@ -40,8 +59,35 @@ struct AsyncEventStruct {
   CRITICAL_SECTION criticalSection;
   unsigned int pendingCount;
 #endif /* __MINGW32__ */
+
+#ifdef ASYNC_EVENT_QUEUE
+  /* Any thread pushes onto this list (newest first) without locking, and
+   * the monitoring thread takes all of them at once.
+   */
+  AsyncEventItem *volatile pushedItems;
+
+  /* Only used by the monitoring thread (oldest first). */
+  AsyncEventItem *readyItems;
+
+  unsigned isQueued:1;
+  unsigned isDraining:1;
+  unsigned isDiscarded:1;
+#endif /* ASYNC_EVENT_QUEUE */
 };
 
+static void
+invokeEventCallback (AsyncEvent *event, void *data) {
+  AsyncEventCallback *callback = event->callback;
+
+  const AsyncEventCallbackParameters parameters = {
+    .eventData = event->data,
+    .signalData = data
+  };
+
+  logSymbol(LOG_CATEGORY(ASYNC_EVENTS), callback, "event starting");
+  if (callback) callback(&parameters);
+}
+
 ASYNC_MONITOR_CALLBACK(asyncMonitorEventPipe) {
   AsyncEvent *event = parameters->data;
   void *data;
@@ -54,43 +100,218 @@ ASYNC_MONITOR_CALLBACK(asyncMonitorEventPipe) {
     LeaveCriticalSection(&event->criticalSection);
 #endif /* __MINGW32__ */
 
-    {
-      AsyncEventCallback *callback = event->callback;
+    invokeEventCallback(event, data);
+    return 1;
+  }
+
+  return 0;
+}
+
+#ifdef ASYNC_EVENT_QUEUE
+static void
+freeEventItems (AsyncEventItem *item) {
+  while (item) {
+    AsyncEventItem *next = item->next;
+    free(item);
+    item = next;
+  }
+}
+
+static AsyncEventItem *
+takeEventItems (AsyncEvent *event) {
+  AsyncEventItem *items = event->pushedItems;
+
+  while (items) {
+    AsyncEventItem *old = __sync_val_compare_and_swap(&event->pushedItems, items, NULL);
+    if (old == items) break;
+    items = old;
+  }
+
+  {
+    AsyncEventItem *ready = NULL;
+
+    while (items) {
+      AsyncEventItem *next = items->next;
+      items->next = ready;
+      ready = items;
+      items = next;
+    }
+
+    return ready;
+  }
+}
+
+static int
+pushEventItem (AsyncEvent *event, void *data) {
+  AsyncEventItem *item;
+
+  if (!(item = malloc(sizeof(*item)))) {
+    logMallocError();
+    return 0;
+  }
+
+  item->data = data;
+
+  {
+    AsyncEventItem *head = event->pushedItems;
+
+    while (1) {
+      AsyncEventItem *old;
+
+      item->next = head;
+      old = __sync_val_compare_and_swap(&event->pushedItems, head, item);
+
+      if (old == head) break;
+      head = old;
+    }
+
+    /* The monitoring thread only needs to be woken up for the first item
+     * since it drains all of them.
+     */
+    if (!head) {
+      static const uint64_t increment = 1;
+
+      if (write(event->monitorDescriptor, &increment, sizeof(increment)) == -1) {
+        logSystemError("eventfd write");
+        return 0;
+      }
+    }
+  }
+
+  return 1;
+}
 
-      const AsyncEventCallbackParameters parameters = {
-        .eventData = event->data,
-        .signalData = data
-      };
+static void deallocateEvent (AsyncEvent *event);
 
-      logSymbol(LOG_CATEGORY(ASYNC_EVENTS), callback, "event starting");
-      if (callback) callback(&parameters);
+ASYNC_MONITOR_CALLBACK(asyncMonitorEventQueue) {
+  AsyncEvent *event = parameters->data;
+  uint64_t count;
+
+  /* Reset the counter before draining so that any item pushed from now on
+   * causes another wakeup.
+   */
+  if (read(event->monitorDescriptor, &count, sizeof(count)) == -1) {
+    if (errno != EAGAIN) {
+      logSystemError("eventfd read");
+      return 0;
     }
+  }
+
+  event->isDraining = 1;
+
+  while (!event->isDiscarded) {
+    AsyncEventItem *item = event->readyItems;
+
+    if (!item) {
+      if (!(item = takeEventItems(event))) break;
+    }
+
+    event->readyItems = item->next;
+
+    {
+      void *data = item->data;
+      free(item);
+      invokeEventCallback(event, data);
+    }
+  }
 
+  event->isDraining = 0;
+  if (event->isDiscarded) deallocateEvent(event);
+  return 1;
+}
+
+static int
+openEventQueue (AsyncEvent *event) {
+  int descriptor = eventfd(0, (EFD_NONBLOCK | EFD_CLOEXEC));
+
+  if (descriptor == -1) {
+    logSystemError("eventfd");
+    return 0;
+  }
+
+  if (asyncMonitorFileInput(&event->monitorHandle, descriptor,
+                            asyncMonitorEventQueue, event)) {
+    event->monitorDescriptor = descriptor;
+    event->isQueued = 1;
     return 1;
   }
 
+  close(descriptor);
   return 0;
 }
 
+int
+asyncSetEventQueueing (int enabled) {
+  eventQueueingEnabled = enabled;
+  return 1;
+}
+#else /* ASYNC_EVENT_QUEUE */
+int
+asyncSetEventQueueing (int enabled) {
+  return !enabled;
+}
+#endif /* ASYNC_EVENT_QUEUE */
+
 int
 asyncSignalEvent (AsyncEvent *event, void *data) {
-  const size_t size = sizeof(data);
-  ssize_t result = writeFileDescriptor(event->pipeInput, &data, size);
+#ifdef ASYNC_EVENT_QUEUE
+  if (event->isQueued) return pushEventItem(event, data);
+#endif /* ASYNC_EVENT_QUEUE */
+
+  {
+    const size_t size = sizeof(data);
+    ssize_t result = writeFileDescriptor(event->pipeInput, &data, size);
 
-  if (result == size) {
+    if (result == size) {
 #ifdef __MINGW32__
-    EnterCriticalSection(&event->criticalSection);
-    if (!event->pendingCount++) SetEvent(event->monitorDescriptor);
-    LeaveCriticalSection(&event->criticalSection);
+      EnterCriticalSection(&event->criticalSection);
+      if (!event->pendingCount++) SetEvent(event->monitorDescriptor);
+      LeaveCriticalSection(&event->criticalSection);
 #endif /* __MINGW32__ */
 
-    return 1;
+      return 1;
+    }
+
+    if (result == -1) {
+      logSystemError("write");
+    } else {
+      logMessage(LOG_ERR, "short write"); 
+    }
   }
 
-  if (result == -1) {
-    logSystemError("write");
-  } else {
-    logMessage(LOG_ERR, "short write"); 
+  return 0;
+}
+
+static int
+openEventPipe (AsyncEvent *event) {
+  if (createAnonymousPipe(&event->pipeInput, &event->pipeOutput)) {
+#ifdef __MINGW32__
+    if (!(event->monitorDescriptor = CreateEvent(NULL, TRUE, FALSE, NULL))) {
+      logWindowsSystemError("CreateEvent");
+      event->monitorDescriptor = INVALID_FILE_DESCRIPTOR;
+    }
+#else /* __MINGW32__ */
+    event->monitorDescriptor = event->pipeOutput;
+#endif /* __MINGW32__ */
+
+    if (event->monitorDescriptor != INVALID_FILE_DESCRIPTOR) {
+      if (asyncMonitorFileInput(&event->monitorHandle, event->monitorDescriptor,
+                                asyncMonitorEventPipe, event)) {
+#ifdef __MINGW32__
+        InitializeCriticalSection(&event->criticalSection);
+        event->pendingCount = 0;
+#endif /* __MINGW32__ */
+
+        return 1;
+      }
+
+#ifdef __MINGW32__
+      CloseHandle(event->monitorDescriptor);
+#endif /* __MINGW32__ */
+    }
+
+    closeFileDescriptor(event->pipeInput);
+    closeFileDescriptor(event->pipeOutput);
   }
 
   return 0;
@@ -105,56 +326,65 @@ asyncNewEvent (AsyncEventCallback *callback, void *data) {
     event->callback = callback;
     event->data = data;
 
-    if (createAnonymousPipe(&event->pipeInput, &event->pipeOutput)) {
-#ifdef __MINGW32__
-      if (!(event->monitorDescriptor = CreateEvent(NULL, TRUE, FALSE, NULL))) {
-        logWindowsSystemError("CreateEvent");
-        event->monitorDescriptor = INVALID_FILE_DESCRIPTOR;
-      }
-#else /* __MINGW32__ */
-      event->monitorDescriptor = event->pipeOutput;
-#endif /* __MINGW32__ */
+    event->pipeInput = INVALID_FILE_DESCRIPTOR;
+    event->pipeOutput = INVALID_FILE_DESCRIPTOR;
 
-      if (event->monitorDescriptor != INVALID_FILE_DESCRIPTOR) {
-        if (asyncMonitorFileInput(&event->monitorHandle, event->monitorDescriptor,
-                                  asyncMonitorEventPipe, event)) {
-#ifdef __MINGW32__
-          InitializeCriticalSection(&event->criticalSection);
-          event->pendingCount = 0;
-#endif /* __MINGW32__ */
-
-          logSymbol(LOG_CATEGORY(ASYNC_EVENTS), event->callback, "event added");
-          return event;
-        }
-
-        closeFileDescriptor(event->monitorDescriptor);
-      }
-
-      closeFileDescriptor(event->pipeInput);
-      closeFileDescriptor(event->pipeOutput);
-    }
+#ifdef ASYNC_EVENT_QUEUE
+    if (eventQueueingEnabled && openEventQueue(event)) goto added;
+#endif /* ASYNC_EVENT_QUEUE */
 
+    if (openEventPipe(event)) goto added;
     free(event);
   } else {
     logMallocError();
   }
 
   return NULL;
+
+added:
+  logSymbol(LOG_CATEGORY(ASYNC_EVENTS), event->callback, "event added");
+  return event;
+}
+
+static void
+deallocateEvent (AsyncEvent *event) {
+#ifdef ASYNC_EVENT_QUEUE
+  freeEventItems(event->readyItems);
+  freeEventItems(event->pushedItems);
+#endif /* ASYNC_EVENT_QUEUE */
+
+  free(event);
 }
 
 void
 asyncDiscardEvent (AsyncEvent *event) {
   asyncCancelRequest(event->monitorHandle);
 
-  closeFileDescriptor(event->pipeInput);
-  closeFileDescriptor(event->pipeOutput);
+#ifdef ASYNC_EVENT_QUEUE
+  if (event->isQueued) {
+    closeFileDescriptor(event->monitorDescriptor);
+  } else
+#endif /* ASYNC_EVENT_QUEUE */
+
+  {
+    closeFileDescriptor(event->pipeInput);
+    closeFileDescriptor(event->pipeOutput);
 
 #ifdef __MINGW32__
-  CloseHandle(event->monitorDescriptor);
-  DeleteCriticalSection(&event->criticalSection);
+    CloseHandle(event->monitorDescriptor);
+    DeleteCriticalSection(&event->criticalSection);
 #endif /* __MINGW32__ */
+  }
 
   logSymbol(LOG_CATEGORY(ASYNC_EVENTS), event->callback, "event removed");
-  free(event);
-}
 
+#ifdef ASYNC_EVENT_QUEUE
+  if (event->isDraining) {
+    /* Discarded by one of its own callbacks - the monitor will free it. */
+    event->isDiscarded = 1;
+    return;
+  }
+#endif /* ASYNC_EVENT_QUEUE */
+
+  deallocateEvent(event);
+}
@@ -0,0 +1,1695 @@
+/*
+ * BRLTTY - A background process providing access to the console screen (when in
+ *          text mode) for a blind person using a refreshable braille display.
+ *
+ * Copyright (C) 1995-2021 by The BRLTTY Developers.
+ *
+ * BRLTTY comes with ABSOLUTELY NO WARRANTY.
+ *
+ * This is free software, placed under the terms of the
+ * GNU Lesser General Public License, as published by the Free Software
+ * Foundation; either version 2.1 of the License, or (at your option) any
+ * later version. Please see the file LICENSE-LGPL for details.
+ *
+ * Web Page: http://brltty.app/
+ *
+ * This software is maintained by Dave Mielke <dave@mielke.cc>.
+ */
+
+#include "prologue.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifdef HAVE_POSIX_OPENPT
+#include <termios.h>
+#endif /* HAVE_POSIX_OPENPT */
+
+#include "log.h"
+#include "program.h"
+#include "options.h"
+#include "parse.h"
+#include "timing.h"
+#include "utf8.h"
+#include "crc.h"
+#include "prefs.h"
+#include "brl_dots.h"
+#include "brl_utils.h"
+#include "brl_base.h"
+#include "io_generic.h"
+#include "brl.h"
+#include "scr.h"
+#include "scr_base.h"
+#include "scr_main.h"
+#include "core.h"
+#include "update.h"
+#include "cmd_queue.h"
+#include "ttb.h"
+#include "ctb.h"
+#include "ktb.h"
+#include "ktb_keyboard.h"
+#include "ktb_internal.h"
+#include "ktb_inspect.h"
+#include "async_alarm.h"
+#include "async_wait.h"
+#include "async_event.h"
+#include "thread.h"
+#include "brlapi.h"
+#include "api_server.h"
+
+static char *opt_iterations;
+static char *opt_suite;
+
+BEGIN_OPTION_TABLE(programOptions)
+  { .word = "iterations",
+    .letter = 'i',
+    .argument = "count",
+    .setting.string = &opt_iterations,
+    .description = "the number of times each benchmark case is repeated"
+  },
+
+  { .word = "suite",
+    .letter = 's',
+    .argument = "name",
+    .setting.string = &opt_suite,
+    .description = "only run the named benchmark suite"
+  },
+
+  { .word = "text-table",
+    .letter = 't',
+    .argument = "file",
+    .setting.string = &opt_textTable,
+    .description = "the text table (default is the built-in one)"
+  },
+
+  { .word = "tables-directory",
+    .letter = 'T',
+    .argument = "directory",
+    .setting.string = &opt_tablesDirectory,
+    .internal.setting = TABLES_DIRECTORY,
+    .internal.adjust = fixInstallPath,
+    .description = "path to directory containing tables"
+  },
+END_OPTION_TABLE
+
+static unsigned int iterations = 1000;
+static unsigned int resultCount = 0;
+static volatile unsigned int benchmarkSink;
+
+static void
+putJsonString (const char *string) {
+  putchar('"');
+
+  while (*string) {
+    char character = *string++;
+
+    if ((character == '"') || (character == '\\')) {
+      putchar('\\');
+    } else if ((unsigned char)character < 0X20) {
+      printf("\\u%04X", character);
+      continue;
+    }
+
+    putchar(character);
+  }
+
+  putchar('"');
+}
+
+static void
+beginReport (void) {
+  printf("{\n");
+  printf("  \"program\": \"bench\",\n");
+  printf("  \"version\": \"%s\",\n", PACKAGE_VERSION);
+  printf("  \"iterations\": %u,\n", iterations);
+  printf("  \"results\": [");
+}
+
+static void
+reportResult (const char *suite, const char *name, uint64_t operations, int64_t nanoseconds) {
+  printf("%s\n    {\"suite\": ", (resultCount++? ",": ""));
+  putJsonString(suite);
+  printf(", \"case\": ");
+  putJsonString(name);
+
+  printf(", \"operations\": %" PRIu64 ", \"nanoseconds\": %" PRId64
+         ", \"nanosecondsPerOperation\": %.1f}",
+         operations, nanoseconds,
+         (double)nanoseconds / (operations? operations: 1));
+
+  fflush(stdout);
+}
+
+static void
+endReport (int ok) {
+  printf("\n  ],\n");
+  printf("  \"ok\": %s\n", (ok? "true": "false"));
+  printf("}\n");
+}
+
+static unsigned int
+randomInteger (unsigned int limit) {
+  return rand() % limit;
+}
+
+static const wchar_t englishSample[] =
+  L"The quick brown fox jumps over the lazy dog, and then it runs "
+  L"through the field where the children were playing with their "
+  L"friends. Everyone should have the opportunity to read what they "
+  L"want, whenever they want to, in the form that works for them.";
+
+static const wchar_t germanSample[] =
+  L"Der schnelle braune Fuchs springt über den faulen Hund, und dann "
+  L"läuft er durch das Feld, wo die Kinder mit ihren Freunden spielten. "
+  L"Jeder sollte die Möglichkeit haben, zu lesen, was er möchte.";
+
+static const wchar_t frenchSample[] =
+  L"Le rapide renard brun saute par-dessus le chien paresseux, puis il "
+  L"traverse le champ où les enfants jouaient avec leurs amis. Chacun "
+  L"devrait pouvoir lire ce qu'il veut, quand il le veut.";
+
+static const wchar_t japaneseSample[] =
+  L"\x3059\x3070\x3084\x3044\x8336\x8272\x306E\x72D0\x304C\x6020\x3051"
+  L"\x8005\x306E\x72AC\x3092\x98DB\x3073\x8D8A\x3048\x308B\x3002";
+
+static ContractionTable *
+compileContractionTableName (const char *name) {
+  ContractionTable *table = NULL;
+  char *path = makeContractionTablePath(opt_tablesDirectory, name);
+
+  if (path) {
+    if (!(table = compileContractionTable(path))) {
+      logMessage(LOG_ERR, "cannot compile contraction table: %s", path);
+    }
+
+    free(path);
+  }
+
+  return table;
+}
+
+#define SCREEN_COLUMNS 80
+#define SCREEN_ROWS 25
+
+static wchar_t screenText[SCREEN_ROWS][SCREEN_COLUMNS];
+static short screenColumn;
+static short screenRow;
+
+static void
+fillScreen (void) {
+  const wchar_t *text = englishSample;
+
+  for (unsigned int row=0; row<SCREEN_ROWS; row+=1) {
+    for (unsigned int column=0; column<SCREEN_COLUMNS; column+=1) {
+      if (!*text) text = englishSample;
+      screenText[row][column] = *text++;
+    }
+  }
+
+  screenColumn = 0;
+  screenRow = 0;
+}
+
+static int
+currentVirtualTerminal_BenchScreen (void) {
+  return 1;
+}
+
+static void
+describe_BenchScreen (ScreenDescription *description) {
+  description->cols = SCREEN_COLUMNS;
+  description->rows = SCREEN_ROWS;
+  description->posx = screenColumn;
+  description->posy = screenRow;
+  description->number = currentVirtualTerminal_BenchScreen();
+}
+
+static int
+readCharacters_BenchScreen (const ScreenBox *box, ScreenCharacter *buffer) {
+  if (!validateScreenBox(box, SCREEN_COLUMNS, SCREEN_ROWS)) return 0;
+
+  for (unsigned int row=0; row<box->height; row+=1) {
+    const wchar_t *text = &screenText[box->top + row][box->left];
+
+    for (unsigned int column=0; column<box->width; column+=1) {
+      *buffer++ = (ScreenCharacter){
+        .text = *text++,
+        .attributes = SCR_COLOUR_DEFAULT
+      };
+    }
+  }
+
+  return 1;
+}
+
+static int
+poll_BenchScreen (void) {
+  return 1;
+}
+
+static unsigned int screenRefreshCount;
+
+static int
+refresh_BenchScreen (void) {
+  unsigned int frame = screenRefreshCount++;
+
+  /* type a character every frame and move to the next line now and then */
+  screenText[screenRow][screenColumn] = L'a' + (frame % 26);
+  screenColumn = (screenColumn + 1) % SCREEN_COLUMNS;
+
+  if (!(frame % 0X10)) {
+    screenRow = (screenRow + 1) % SCREEN_ROWS;
+    screenColumn = 0;
+  }
+
+  return 1;
+}
+
+static void
+initialize_BenchScreen (MainScreen *main) {
+  initializeMainScreen(main);
+
+  main->base.poll = poll_BenchScreen;
+  main->base.refresh = refresh_BenchScreen;
+  main->base.describe = describe_BenchScreen;
+  main->base.readCharacters = readCharacters_BenchScreen;
+  main->base.currentVirtualTerminal = currentVirtualTerminal_BenchScreen;
+}
+
+static const ScreenDriver benchScreen = {
+  .definition = {
+    .name = "BenchScreen",
+    .code = "bench",
+    .comment = "a synthetic screen for the update benchmark"
+  },
+
+  .initialize = initialize_BenchScreen
+};
+
+typedef struct {
+  const char *name;
+  unsigned int width;
+  const char *contractionTable;
+} UpdateCase;
+
+static const UpdateCase updateCases[] = {
+  { .name = "40 cells", .width = 40 },
+  { .name = "80 cells", .width = 80 },
+  { .name = "40 cells contracted", .width = 40, .contractionTable = "en-us-g2" },
+};
+
+/* The update scheduler keeps updates at least UPDATE_SCHEDULE_DELAY apart,
+ * so fewer frames are run and only the process's CPU time is counted.
+ */
+#define UPDATE_ITERATION_DIVISOR 10
+
+static int64_t
+getProcessNanoseconds (void) {
+#ifdef CLOCK_PROCESS_CPUTIME_ID
+  struct timespec now;
+
+  if (clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &now) != -1) {
+    return ((int64_t)now.tv_sec * NSECS_PER_SEC) + now.tv_nsec;
+  }
+#endif /* CLOCK_PROCESS_CPUTIME_ID */
+
+  {
+    TimeValue now;
+
+    getMonotonicTime(&now);
+    return ((int64_t)now.seconds * NSECS_PER_SEC) + now.nanoseconds;
+  }
+}
+
+ASYNC_CONDITION_TESTER(testScreenRefreshed) {
+  const unsigned int *count = data;
+  return screenRefreshCount >= *count;
+}
+
+static int
+benchmarkUpdateCase (const UpdateCase *uc) {
+  unsigned int frames = MAX((iterations / UPDATE_ITERATION_DIVISOR), 1);
+  int ok = 1;
+
+  constructBrailleDisplay(&brl);
+  brl.textColumns = uc->width;
+  if (!ensureBrailleBuffer(&brl, LOG_DEBUG)) return 0;
+  reconfigureBrailleWindow();
+
+  fillScreen();
+  screenRefreshCount = 0;
+
+  {
+    int64_t start = getProcessNanoseconds();
+
+    for (unsigned int frame=1; frame<=frames; frame+=1) {
+      scheduleUpdate("bench");
+
+      if (!asyncAwaitCondition(1000, testScreenRefreshed, &frame)) {
+        logMessage(LOG_ERR, "update not done: frame %u", frame);
+        ok = 0;
+        break;
+      }
+    }
+
+    if (ok) {
+      reportResult("update", uc->name, frames, (getProcessNanoseconds() - start));
+    }
+  }
+
+  benchmarkSink = brl.buffer[0];
+  destructBrailleDisplay(&brl);
+  return ok;
+}
+
+static int
+benchmarkUpdate (void) {
+  static char *noParameters[] = {NULL};
+  int ok = 1;
+
+  screen = &benchScreen;
+  if (!constructScreenDriver(noParameters)) return 0;
+  updateSessionAttributes();
+
+  beginUpdates();
+  suspendUpdates();
+  resumeUpdates(1);
+
+  for (unsigned int index=0; index<ARRAY_COUNT(updateCases); index+=1) {
+    const UpdateCase *uc = &updateCases[index];
+
+    if (uc->contractionTable) {
+      if (!(contractionTable = compileContractionTableName(uc->contractionTable))) {
+        ok = 0;
+        break;
+      }
+
+      setContractedBraille(1);
+    }
+
+    if (!benchmarkUpdateCase(uc)) ok = 0;
+
+    if (contractionTable) {
+      setContractedBraille(0);
+      destroyContractionTable(contractionTable);
+      contractionTable = NULL;
+    }
+
+    if (!ok) break;
+  }
+
+  suspendUpdates();
+  destructScreenDriver();
+  return ok;
+}
+
+typedef struct {
+  const char *name;
+  wchar_t first;
+  wchar_t last;
+} CharacterRange;
+
+static const CharacterRange characterRanges[] = {
+  { .name = "Basic Latin", .first = 0X20, .last = 0X7E },
+  { .name = "Latin-1 Supplement", .first = 0XA0, .last = 0XFF },
+  { .name = "Latin Extended-A", .first = 0X100, .last = 0X17F },
+  { .name = "Greek and Coptic", .first = 0X370, .last = 0X3FF },
+  { .name = "Cyrillic", .first = 0X400, .last = 0X4FF },
+  { .name = "General Punctuation", .first = 0X2000, .last = 0X206F },
+  { .name = "Box Drawing", .first = 0X2500, .last = 0X257F },
+  { .name = "Braille Patterns", .first = 0X2800, .last = 0X28FF },
+  { .name = "CJK Unified Ideographs", .first = 0X4E00, .last = 0X4FFF },
+};
+
+static int
+benchmarkTextTable (void) {
+  for (unsigned int index=0; index<ARRAY_COUNT(characterRanges); index+=1) {
+    const CharacterRange *range = &characterRanges[index];
+    unsigned int count = range->last - range->first + 1;
+    unsigned char dots = 0;
+    TimeValue start;
+
+    getMonotonicTime(&start);
+
+    for (unsigned int iteration=0; iteration<iterations; iteration+=1) {
+      for (wchar_t character=range->first; character<=range->last; character+=1) {
+        dots ^= convertCharacterToDots(textTable, character);
+      }
+    }
+
+    reportResult("ttb", range->name, (uint64_t)iterations * count, getMonotonicNanosecondsElapsed(&start));
+    benchmarkSink = dots;
+  }
+
+  return 1;
+}
+
+typedef struct {
+  const char *name;
+  const wchar_t *text;
+} Utf8Sample;
+
+static const Utf8Sample utf8Samples[] = {
+  { .name = "English", .text = englishSample },
+  { .name = "German", .text = germanSample },
+  { .name = "Japanese", .text = japaneseSample },
+};
+
+static int
+benchmarkUtf8 (void) {
+  for (unsigned int index=0; index<ARRAY_COUNT(utf8Samples); index+=1) {
+    const Utf8Sample *sample = &utf8Samples[index];
+    size_t count = wcslen(sample->text);
+    char text[(count * UTF8_LEN_MAX) + 1];
+    size_t length = makeUtf8FromWchars(sample->text, count, text, sizeof(text));
+    char name[0X40];
+
+    {
+      wchar_t characters[count];
+      TimeValue start;
+
+      getMonotonicTime(&start);
+
+      for (unsigned int iteration=0; iteration<iterations; iteration+=1) {
+        const char *utf8 = text;
+        size_t utfs = length;
+        wchar_t *character = characters;
+        size_t left = count;
+
+        if (!convertUtf8TextToWchars(&utf8, &utfs, &character, &left)) {
+          logMessage(LOG_ERR, "UTF-8 sample not decoded: %s", sample->name);
+          return 0;
+        }
+      }
+
+      snprintf(name, sizeof(name), "decode %s", sample->name);
+      reportResult("utf8", name, (uint64_t)iterations * count, getMonotonicNanosecondsElapsed(&start));
+      benchmarkSink = characters[0];
+    }
+
+    {
+      char buffer[sizeof(text)];
+      TimeValue start;
+
+      getMonotonicTime(&start);
+
+      for (unsigned int iteration=0; iteration<iterations; iteration+=1) {
+        makeUtf8FromWchars(sample->text, count, buffer, sizeof(buffer));
+      }
+
+      snprintf(name, sizeof(name), "encode %s", sample->name);
+      reportResult("utf8", name, (uint64_t)iterations * count, getMonotonicNanosecondsElapsed(&start));
+      benchmarkSink = buffer[0];
+    }
+  }
+
+  return 1;
+}
+
+typedef struct {
+  const char *name;
+  unsigned int columns;
+  unsigned int rows;
+} CellsSize;
+
+static const CellsSize cellsSizes[] = {
+  { .name = "20 cells", .columns = 20, .rows = 1 },
+  { .name = "40 cells", .columns = 40, .rows = 1 },
+  { .name = "80 cells", .columns = 80, .rows = 1 },
+  { .name = "40x4 cells", .columns = 40, .rows = 4 },
+};
+
+typedef struct {
+  const char *name;
+  void (*modify) (unsigned char *cells, unsigned int count);
+} CellsChange;
+
+static void
+modifyNoCells (unsigned char *cells, unsigned int count) {
+}
+
+static void
+modifyMiddleCell (unsigned char *cells, unsigned int count) {
+  cells[count / 2] ^= 1;
+}
+
+static void
+modifyEndCells (unsigned char *cells, unsigned int count) {
+  cells[0] ^= 1;
+  cells[count - 1] ^= 1;
+}
+
+static const CellsChange cellsChanges[] = {
+  { .name = "unchanged", .modify = modifyNoCells },
+  { .name = "middle", .modify = modifyMiddleCell },
+  { .name = "ends", .modify = modifyEndCells },
+};
+
+static int
+benchmarkCells (void) {
+  for (unsigned int sizeIndex=0; sizeIndex<ARRAY_COUNT(cellsSizes); sizeIndex+=1) {
+    const CellsSize *size = &cellsSizes[sizeIndex];
+    unsigned int count = size->columns * size->rows;
+
+    for (unsigned int changeIndex=0; changeIndex<ARRAY_COUNT(cellsChanges); changeIndex+=1) {
+      const CellsChange *change = &cellsChanges[changeIndex];
+      unsigned char cells[count];
+      unsigned char new[count];
+      char name[0X40];
+
+      for (unsigned int index=0; index<count; index+=1) new[index] = randomInteger(0X100);
+      memcpy(cells, new, count);
+
+      {
+        TimeValue start;
+        getMonotonicTime(&start);
+
+        for (unsigned int iteration=0; iteration<iterations; iteration+=1) {
+          unsigned int from, to;
+
+          change->modify(new, count);
+          cellsHaveChanged(cells, new, count, &from, &to, NULL);
+        }
+
+        snprintf(name, sizeof(name), "span %s, %s", size->name, change->name);
+        reportResult("cells", name, iterations, getMonotonicNanosecondsElapsed(&start));
+      }
+
+      {
+        TimeValue start;
+        getMonotonicTime(&start);
+
+        for (unsigned int iteration=0; iteration<iterations; iteration+=1) {
+          CellSpan spans[8];
+
+          change->modify(new, count);
+          cellsHaveChangedSpans(cells, new, count, spans, ARRAY_COUNT(spans), 4, NULL);
+        }
+
+        snprintf(name, sizeof(name), "spans %s, %s", size->name, change->name);
+        reportResult("cells", name, iterations, getMonotonicNanosecondsElapsed(&start));
+      }
+
+      {
+        TimeValue start;
+        getMonotonicTime(&start);
+
+        for (unsigned int iteration=0; iteration<iterations; iteration+=1) {
+          unsigned char changedRows[size->rows];
+
+          change->modify(new, count);
+          cellRowsHaveChanged(cells, new, size->columns, size->rows, changedRows, NULL);
+        }
+
+        snprintf(name, sizeof(name), "rows %s, %s", size->name, change->name);
+        reportResult("cells", name, iterations, getMonotonicNanosecondsElapsed(&start));
+      }
+
+      benchmarkSink = cells[0];
+    }
+  }
+
+  return 1;
+}
+
+#define CRC_BLOCK_SIZE 0X1000
+
+static int
+benchmarkCRC (void) {
+  uint8_t *data = malloc(CRC_BLOCK_SIZE);
+
+  if (!data) {
+    logMallocError();
+    return 0;
+  }
+
+  for (size_t index=0; index<CRC_BLOCK_SIZE; index+=1) data[index] = randomInteger(0X100);
+
+  /* the block is added once per iteration, and the operations are bytes */
+  uint64_t bytes = (uint64_t)iterations * CRC_BLOCK_SIZE;
+  const CRCAlgorithm **algorithm = crcProvidedAlgorithms;
+  int ok = 1;
+
+  while (*algorithm) {
+    CRCGenerator *crc = crcNewGenerator(*algorithm);
+    char name[0X40];
+
+    if (!crc) {
+      ok = 0;
+      break;
+    }
+
+    {
+      TimeValue start;
+      getMonotonicTime(&start);
+
+      for (unsigned int block=0; block<iterations; block+=1) {
+        const uint8_t *byte = data;
+        const uint8_t *end = byte + CRC_BLOCK_SIZE;
+        while (byte < end) crcAddByte(crc, *byte++);
+      }
+
+      snprintf(name, sizeof(name), "bytes %s", (*algorithm)->primaryName);
+      reportResult("crc", name, bytes, getMonotonicNanosecondsElapsed(&start));
+    }
+
+    {
+      TimeValue start;
+      getMonotonicTime(&start);
+
+      for (unsigned int block=0; block<iterations; block+=1) {
+        crcAddData(crc, data, CRC_BLOCK_SIZE);
+      }
+
+      snprintf(name, sizeof(name), "data %s", (*algorithm)->primaryName);
+      reportResult("crc", name, bytes, getMonotonicNanosecondsElapsed(&start));
+    }
+
+    benchmarkSink = crcGetValue(crc);
+    crcDestroyGenerator(crc);
+    algorithm += 1;
+  }
+
+  free(data);
+  return ok;
+}
+
+typedef struct {
+  const char *table;
+  const wchar_t *text;
+} ContractionSample;
+
+static const ContractionSample contractionSamples[] = {
+  { .table = "en-us-g2", .text = englishSample },
+  { .table = "en-ueb-g2", .text = englishSample },
+  { .table = "de-g2", .text = germanSample },
+  { .table = "fr-g2", .text = frenchSample },
+};
+
+static int
+benchmarkContraction (void) {
+  for (unsigned int index=0; index<ARRAY_COUNT(contractionSamples); index+=1) {
+    const ContractionSample *sample = &contractionSamples[index];
+    ContractionTable *table = compileContractionTableName(sample->table);
+    if (!table) return 0;
+
+    {
+      size_t length = wcslen(sample->text);
+      unsigned char cells[length * 2];
+      int offsets[length];
+      int ok = 1;
+      TimeValue start;
+
+      getMonotonicTime(&start);
+
+      for (unsigned int iteration=0; iteration<iterations; iteration+=1) {
+        const wchar_t *text = sample->text;
+        int left = length;
+
+        /* contract one display's worth at a time, the way the core does */
+        while (left) {
+          int inputLength = left;
+          int outputLength = 40;
+
+          contractText(table, text, &inputLength,
+                       cells, &outputLength, offsets, CTB_NO_CURSOR);
+
+          if (!inputLength) {
+            logMessage(LOG_ERR, "contraction not progressing: %s", sample->table);
+            ok = 0;
+            break;
+          }
+
+          text += inputLength;
+          left -= inputLength;
+        }
+
+        if (!ok) break;
+      }
+
+      if (ok) reportResult("ctb", sample->table, (uint64_t)iterations * length, getMonotonicNanosecondsElapsed(&start));
+      destroyContractionTable(table);
+      if (!ok) return 0;
+    }
+  }
+
+  return 1;
+}
+
+static unsigned int commandCount = 0;
+
+static int
+handleChordCommand (int command, void *data) {
+  commandCount += 1;
+  return 1;
+}
+
+ASYNC_CONDITION_TESTER(testCommandsHandled) {
+  unsigned int *handled = data;
+  if (commandCount == *handled) return 1;
+
+  *handled = commandCount;
+  return 0;
+}
+
+static int
+benchmarkChords (void) {
+  static const unsigned char chordSizes[] = {1, 3, 6, 9};
+
+  KeyTable *table;
+  int ok = 0;
+
+  {
+    char *path = makeKeyboardTablePath(opt_tablesDirectory, "braille");
+    if (!path) return 0;
+
+    if (!(table = compileKeyTable(path, KEY_NAME_TABLES(keyboard)))) {
+      logMessage(LOG_ERR, "cannot compile keyboard table: %s", path);
+    }
+
+    free(path);
+    if (!table) return 0;
+  }
+
+  if (!pushCommandEnvironment("bench", NULL, NULL)) {
+    destroyKeyTable(table);
+    return 0;
+  }
+
+  pushCommandHandler("chords", KTB_CTX_DEFAULT, handleChordCommand, NULL, NULL);
+
+  {
+    const KeyContext *ctx = getKeyContext(table, KTB_CTX_DEFAULT);
+    unsigned int keyCount = ctx? ctx->mappedKeys.count: 0;
+
+    if (keyCount) {
+      for (unsigned int index=0; index<ARRAY_COUNT(chordSizes); index+=1) {
+        unsigned int size = chordSizes[index];
+        KeyTableEvent presses[size];
+        KeyTableEvent releases[size];
+        char name[0X40];
+
+        if (size > keyCount) break;
+
+        for (unsigned int key=0; key<size; key+=1) {
+          const KeyValue *value = &ctx->mappedKeys.table[key].keyValue;
+
+          presses[key] = (KeyTableEvent){
+            .group = value->group,
+            .number = value->number,
+            .press = 1
+          };
+
+          releases[key] = presses[key];
+          releases[key].press = 0;
+        }
+
+        {
+          TimeValue start;
+          getMonotonicTime(&start);
+
+          for (unsigned int iteration=0; iteration<iterations; iteration+=1) {
+            for (unsigned int key=0; key<size; key+=1) {
+              processKeyEvent(table, KTB_CTX_DEFAULT, presses[key].group, presses[key].number, 1);
+            }
+
+            for (unsigned int key=0; key<size; key+=1) {
+              processKeyEvent(table, KTB_CTX_DEFAULT, releases[key].group, releases[key].number, 0);
+            }
+          }
+
+          snprintf(name, sizeof(name), "%u-key chord", size);
+          reportResult("ktb", name, iterations, getMonotonicNanosecondsElapsed(&start));
+        }
+
+        {
+          TimeValue start;
+          getMonotonicTime(&start);
+
+          for (unsigned int iteration=0; iteration<iterations; iteration+=1) {
+            processKeyEvents(table, KTB_CTX_DEFAULT, presses, size);
+            processKeyEvents(table, KTB_CTX_DEFAULT, releases, size);
+          }
+
+          snprintf(name, sizeof(name), "%u-key chord batched", size);
+          reportResult("ktb", name, iterations, getMonotonicNanosecondsElapsed(&start));
+        }
+      }
+
+      {
+        unsigned int handled = ~commandCount;
+
+        /* the queued commands go to our handler rather than to the core's */
+        asyncAwaitCondition(100, testCommandsHandled, &handled);
+      }
+
+      benchmarkSink = commandCount;
+      ok = 1;
+    } else {
+      logMessage(LOG_ERR, "keyboard table has no mapped keys");
+    }
+  }
+
+  popCommandEnvironment();
+  destroyKeyTable(table);
+  return ok;
+}
+
+#ifdef HAVE_POSIX_OPENPT
+#define REPLAY_ESCAPE 0X1B
+#define REPLAY_KEYS 0X22
+#define REPLAY_ROUTING 0X24
+#define REPLAY_ROUTING_BYTES 5
+#define REPLAY_PACKET_COUNT 64
+
+typedef struct {
+  const char *name;
+  unsigned char routingInterval;
+} ReplayCase;
+
+static const ReplayCase replayCases[] = {
+  { .name = "key packets", .routingInterval = 0 },
+  { .name = "routing packets", .routingInterval = 1 },
+  { .name = "mixed packets", .routingInterval = 4 },
+};
+
+static BraillePacketVerifierResult
+verifyReplayedPacket (
+  BrailleDisplay *brl,
+  unsigned char *bytes, size_t size,
+  size_t *length, void *data
+) {
+  unsigned char byte = bytes[size-1];
+
+  switch (size) {
+    case 1:
+      if (byte != REPLAY_ESCAPE) return BRL_PVR_INVALID;
+      *length = 2;
+      break;
+
+    case 2:
+      switch (byte) {
+        case REPLAY_KEYS:
+          *length += 1;
+          break;
+
+        case REPLAY_ROUTING:
+          *length += REPLAY_ROUTING_BYTES;
+          break;
+
+        default:
+          return BRL_PVR_INVALID;
+      }
+      break;
+
+    default:
+      break;
+  }
+
+  return BRL_PVR_INCLUDE;
+}
+
+static size_t
+makeReplayStream (const ReplayCase *rc, unsigned char *stream) {
+  unsigned char *byte = stream;
+
+  for (unsigned int packet=0; packet<REPLAY_PACKET_COUNT; packet+=1) {
+    *byte++ = REPLAY_ESCAPE;
+
+    if (rc->routingInterval && !(packet % rc->routingInterval)) {
+      *byte++ = REPLAY_ROUTING;
+
+      for (unsigned int index=0; index<REPLAY_ROUTING_BYTES; index+=1) {
+        *byte++ = randomInteger(0X100);
+      }
+    } else {
+      *byte++ = REPLAY_KEYS;
+      *byte++ = randomInteger(0X100);
+    }
+  }
+
+  return byte - stream;
+}
+
+static int
+replayPackets (BrailleDisplay *brl, int master, const unsigned char *stream, size_t size) {
+  unsigned int received = 0;
+
+  if (write(master, stream, size) != size) {
+    logSystemError("write");
+    return 0;
+  }
+
+  while (received < REPLAY_PACKET_COUNT) {
+    unsigned char packet[0X10];
+
+    if (readBraillePacket(brl, NULL, packet, sizeof(packet), verifyReplayedPacket, NULL)) {
+      received += 1;
+    } else if (!gioAwaitInput(brl->gioEndpoint, 1000)) {
+      logMessage(LOG_ERR, "replayed packets not received: %u/%u",
+                 received, REPLAY_PACKET_COUNT);
+      return 0;
+    }
+  }
+
+  return 1;
+}
+
+static int
+openReplayTerminal (int *master, int *slave, char **identifier) {
+  if ((*master = posix_openpt(O_RDWR | O_NOCTTY)) != -1) {
+    if ((grantpt(*master) != -1) && (unlockpt(*master) != -1)) {
+      const char *path = ptsname(*master);
+
+      if (path) {
+        /* Keep the slave side open so that the master doesn't see a
+         * hangup whenever the endpoint is closed.
+         */
+        if ((*slave = open(path, (O_RDWR | O_NOCTTY))) != -1) {
+          struct termios attributes;
+
+          if (tcgetattr(*slave, &attributes) != -1) {
+            cfmakeraw(&attributes);
+            tcsetattr(*slave, TCSANOW, &attributes);
+          }
+
+          {
+            static const char qualifier[] = "serial:";
+            size_t size = sizeof(qualifier) + strlen(path);
+
+            if ((*identifier = malloc(size))) {
+              snprintf(*identifier, size, "%s%s", qualifier, path);
+              return 1;
+            } else {
+              logMallocError();
+            }
+          }
+
+          close(*slave);
+        } else {
+          logSystemError("open");
+        }
+      } else {
+        logSystemError("ptsname");
+      }
+    } else {
+      logSystemError("grantpt");
+    }
+
+    close(*master);
+  } else {
+    logSystemError("posix_openpt");
+  }
+
+  return 0;
+}
+
+static int
+benchmarkPackets (void) {
+  int master, slave;
+  char *identifier;
+  int ok = 0;
+
+  if (openReplayTerminal(&master, &slave, &identifier)) {
+    static const SerialParameters serialParameters = {
+      SERIAL_DEFAULT_PARAMETERS
+    };
+
+    GioDescriptor descriptor;
+    BrailleDisplay brl;
+
+    gioInitializeDescriptor(&descriptor);
+    descriptor.serial.parameters = &serialParameters;
+    descriptor.serial.options.readyDelay = 0;
+
+    memset(&brl, 0, sizeof(brl));
+
+    if ((brl.gioEndpoint = gioConnectResource(identifier, &descriptor))) {
+      ok = 1;
+
+      for (unsigned int index=0; index<ARRAY_COUNT(replayCases); index+=1) {
+        const ReplayCase *rc = &replayCases[index];
+        unsigned char stream[REPLAY_PACKET_COUNT * (3 + REPLAY_ROUTING_BYTES)];
+        size_t size = makeReplayStream(rc, stream);
+        TimeValue start;
+
+        getMonotonicTime(&start);
+
+        for (unsigned int iteration=0; iteration<iterations; iteration+=1) {
+          if (!replayPackets(&brl, master, stream, size)) {
+            ok = 0;
+            break;
+          }
+        }
+
+        if (!ok) break;
+        reportResult("packets", rc->name, (uint64_t)iterations * REPLAY_PACKET_COUNT,
+                     getMonotonicNanosecondsElapsed(&start));
+      }
+
+      gioDisconnectResource(brl.gioEndpoint);
+    }
+
+    free(identifier);
+    close(slave);
+    close(master);
+  }
+
+  return ok;
+}
+#else /* HAVE_POSIX_OPENPT */
+static int
+benchmarkPackets (void) {
+  logUnsupportedOperation("posix_openpt");
+  return 1;
+}
+#endif /* HAVE_POSIX_OPENPT */
+
+#ifdef ENABLE_API
+static int
+openBrlapiConnection (brlapi_handle_t *handle, const char *host) {
+  brlapi_connectionSettings_t settings = {
+    .host = (char *)host,
+    .auth = "none"
+  };
+
+  /* the server's socket threads might not be listening yet */
+  for (unsigned int attempt=0; attempt<100; attempt+=1) {
+    if (brlapi__openConnection(handle, &settings, NULL) != -1) {
+      if (brlapi__enterTtyMode(handle, 1, NULL) != -1) return 1;
+      logMessage(LOG_ERR, "enter tty mode: %s", brlapi_strerror(&brlapi_error));
+      brlapi__closeConnection(handle);
+      return 0;
+    }
+
+    approximateDelay(10);
+  }
+
+  logMessage(LOG_ERR, "connect to %s: %s", host, brlapi_strerror(&brlapi_error));
+  return 0;
+}
+
+static int
+synchronizeBrlapiWrites (brlapi_handle_t *handle) {
+  brlapi_param_displaySize_t displaySize;
+
+  /* the server handles requests in order, so this reply means that all of
+   * the preceding writes have been applied
+   */
+  if (brlapi__getParameter(handle, BRLAPI_PARAM_DISPLAY_SIZE, 0, BRLAPI_PARAMF_GLOBAL,
+                           &displaySize, sizeof(displaySize)) == -1) {
+    logMessage(LOG_ERR, "get display size: %s", brlapi_strerror(&brlapi_error));
+    return 0;
+  }
+
+  benchmarkSink = displaySize.columns;
+  return 1;
+}
+
+static int
+benchmarkBrlapiWrites (brlapi_handle_t *handle, unsigned int size, const char *path) {
+  unsigned char andMask[size];
+  unsigned char orMask[size];
+  char text[(size * UTF8_LEN_MAX) + 1];
+
+  {
+    char *byte = text;
+
+    for (unsigned int column=0; column<size; column+=1) {
+      Utf8Buffer utf8;
+      size_t length = convertWcharToUtf8(germanSample[column], utf8);
+
+      memcpy(byte, utf8, length);
+      byte += length;
+    }
+
+    *byte = 0;
+  }
+
+  memset(andMask, 0XFF, size);
+  memset(orMask, 0, size);
+
+  brlapi_writeArguments_t arguments = BRLAPI_WRITEARGUMENTS_INITIALIZER;
+  arguments.regionBegin = 1;
+  arguments.regionSize = size;
+  arguments.text = text;
+  arguments.textSize = strlen(text);
+  arguments.andMask = andMask;
+  arguments.orMask = orMask;
+  arguments.charset = "UTF-8";
+
+  static const struct {
+    const char *name;
+    unsigned char eachWrite;
+  } writeCases[] = {
+    { .name = "round trip", .eachWrite = 1 },
+    { .name = "burst", .eachWrite = 0 },
+  };
+
+  for (unsigned int index=0; index<ARRAY_COUNT(writeCases); index+=1) {
+    int eachWrite = writeCases[index].eachWrite;
+    TimeValue start;
+
+    getMonotonicTime(&start);
+
+    for (unsigned int iteration=0; iteration<iterations; iteration+=1) {
+      arguments.cursor = (iteration % size) + 1;
+
+      if (brlapi__write(handle, &arguments) == -1) {
+        logMessage(LOG_ERR, "write: %s", brlapi_strerror(&brlapi_error));
+        return 0;
+      }
+
+      if (eachWrite && !synchronizeBrlapiWrites(handle)) return 0;
+    }
+
+    if (!eachWrite && !synchronizeBrlapiWrites(handle)) return 0;
+
+    {
+      char name[0X40];
+
+      snprintf(name, sizeof(name), "%s %u cells, %s", writeCases[index].name, size, path);
+      reportResult("brlapi", name, iterations, getMonotonicNanosecondsElapsed(&start));
+    }
+  }
+
+  return 1;
+}
+
+/* The server hands its braille output to the core's main thread, so the
+ * client has to run on a thread of its own.
+ */
+typedef struct {
+  const char *host;
+  unsigned int size;
+  AsyncEvent *event;
+
+  int ok;
+  unsigned char finished;
+} BrlapiClient;
+
+THREAD_FUNCTION(runBrlapiClient) {
+  BrlapiClient *client = argument;
+  brlapi_handle_t *handle;
+
+  client->ok = 0;
+
+  if ((handle = malloc(brlapi_getHandleSize()))) {
+    if (openBrlapiConnection(handle, client->host)) {
+      if (benchmarkBrlapiWrites(handle, client->size, "socket")) {
+        if (brlapi__enableSharedMemory(handle) == -1) {
+          logMessage(LOG_WARNING, "shared memory not enabled: %s", brlapi_strerror(&brlapi_error));
+          client->ok = 1;
+        } else {
+          client->ok = benchmarkBrlapiWrites(handle, client->size, "shared");
+        }
+      }
+
+      brlapi__closeConnection(handle);
+    }
+
+    free(handle);
+  } else {
+    logMallocError();
+  }
+
+  asyncSignalEvent(client->event, NULL);
+  return NULL;
+}
+
+ASYNC_EVENT_CALLBACK(setBrlapiClientFinished) {
+  BrlapiClient *client = parameters->eventData;
+  client->finished = 1;
+}
+
+ASYNC_CONDITION_TESTER(testBrlapiClientFinished) {
+  const BrlapiClient *client = data;
+  return client->finished;
+}
+
+static int
+runBrlapiClientThread (BrlapiClient *client) {
+  int ok = 0;
+
+  if ((client->event = asyncNewEvent(setBrlapiClientFinished, client))) {
+    pthread_t thread;
+    int error = createThread("bench-client", &thread, NULL, runBrlapiClient, client);
+
+    if (!error) {
+      asyncWaitFor(testBrlapiClientFinished, client);
+      pthread_join(thread, NULL);
+      ok = client->ok;
+    } else {
+      logActionError(error, "pthread_create");
+    }
+
+    asyncDiscardEvent(client->event);
+    client->event = NULL;
+  }
+
+  return ok;
+}
+
+static int
+benchmarkBrlapi (void) {
+  static const unsigned char writeSizes[] = {40, 80};
+
+  /* a local socket of our own so that a running brltty isn't disturbed */
+  char host[0X40];
+  snprintf(host, sizeof(host), ":bench-%ld", (long)getpid());
+
+  /* in the order of api_serverParameters: auth, host, stacksize */
+  char *serverParameters[] = {"none", host, "", NULL};
+
+  static char *noParameters[] = {NULL};
+  int ok = 1;
+
+  /* the server's braille flush asks the screen for the current terminal */
+  screen = &benchScreen;
+  if (!constructScreenDriver(noParameters)) return 0;
+
+  if (!startCoreTasks()) {
+    destructScreenDriver();
+    return 0;
+  }
+
+  constructBrailleDisplay(&brl);
+
+  if (api_startServer(&brl, serverParameters)) {
+    for (unsigned int index=0; index<ARRAY_COUNT(writeSizes); index+=1) {
+      BrlapiClient client = {
+        .host = host,
+        .size = writeSizes[index]
+      };
+
+      brl.textColumns = client.size;
+      if (!ensureBrailleBuffer(&brl, LOG_DEBUG)) {
+        ok = 0;
+        break;
+      }
+
+      api_linkServer(&brl);
+      if (!runBrlapiClientThread(&client)) ok = 0;
+      api_unlinkServer(&brl);
+
+      /* start the next size with a buffer of its own, as a driver restart does */
+      destructBrailleDisplay(&brl);
+      constructBrailleDisplay(&brl);
+
+      if (!ok) break;
+    }
+
+    api_stopServer(&brl);
+  } else {
+    ok = 0;
+  }
+
+  destructBrailleDisplay(&brl);
+  stopCoreTasks();
+  destructScreenDriver();
+  return ok;
+}
+#else /* ENABLE_API */
+static int
+benchmarkBrlapi (void) {
+  logUnsupportedOperation("brlapi");
+  return 1;
+}
+#endif /* ENABLE_API */
+
+#ifdef GOT_PTHREADS
+#define EVENT_PRODUCER_COUNT 4
+
+typedef struct {
+  AsyncEvent *event;
+  unsigned int count;
+  unsigned int expected;
+  unsigned int received;
+
+  volatile unsigned int acknowledged;
+  TimeValue sendTime;
+  int64_t latency;
+} EventBench;
+
+ASYNC_EVENT_CALLBACK(handleBenchEvent) {
+  EventBench *bench = parameters->eventData;
+  bench->received += 1;
+}
+
+THREAD_FUNCTION(sendBenchEvents) {
+  EventBench *bench = argument;
+
+  for (unsigned int count=0; count<bench->count; count+=1) {
+    if (!asyncSignalEvent(bench->event, NULL)) break;
+  }
+
+  return NULL;
+}
+
+ASYNC_CONDITION_TESTER(testBenchEventsReceived) {
+  const EventBench *bench = data;
+  return bench->received == bench->expected;
+}
+
+static int
+sendBenchEventBurst (EventBench *bench) {
+  pthread_t threads[EVENT_PRODUCER_COUNT];
+  unsigned int started = 0;
+
+  while (started < EVENT_PRODUCER_COUNT) {
+    if (createThread("bench-producer", &threads[started], NULL,
+                     sendBenchEvents, bench)) {
+      break;
+    }
+
+    started += 1;
+  }
+
+  if (started == EVENT_PRODUCER_COUNT) asyncWaitFor(testBenchEventsReceived, bench);
+  while (started) pthread_join(threads[--started], NULL);
+  return bench->received == bench->expected;
+}
+
+ASYNC_EVENT_CALLBACK(handleTimedBenchEvent) {
+  EventBench *bench = parameters->eventData;
+
+  bench->latency += getMonotonicNanosecondsElapsed(&bench->sendTime);
+  bench->received += 1;
+
+  __sync_synchronize();
+  bench->acknowledged = bench->received;
+}
+
+THREAD_FUNCTION(signalTimedBenchEvents) {
+  EventBench *bench = argument;
+
+  for (unsigned int count=0; count<bench->count; count+=1) {
+    getMonotonicTime(&bench->sendTime);
+    __sync_synchronize();
+    if (!asyncSignalEvent(bench->event, NULL)) break;
+
+    /* one event at a time so that each delivery is timed on its own */
+    while (bench->acknowledged == count) {
+      __sync_synchronize();
+    }
+  }
+
+  return NULL;
+}
+
+static int
+sendTimedBenchEvents (EventBench *bench) {
+  pthread_t thread;
+
+  if (createThread("bench-producer", &thread, NULL, signalTimedBenchEvents, bench)) return 0;
+  asyncWaitFor(testBenchEventsReceived, bench);
+  pthread_join(thread, NULL);
+  return 1;
+}
+
+static int
+benchmarkEvents (void) {
+  int ok = 1;
+
+  for (int queued=0; queued<2; queued+=1) {
+    const char *implementation = queued? "queue": "pipe";
+    if (!asyncSetEventQueueing(queued)) continue;
+
+    {
+      unsigned int count = MAX(iterations / EVENT_PRODUCER_COUNT, 1);
+
+      EventBench bench = {
+        .count = count,
+        .expected = count * EVENT_PRODUCER_COUNT
+      };
+
+      if ((bench.event = asyncNewEvent(handleBenchEvent, &bench))) {
+        TimeValue start;
+        getMonotonicTime(&start);
+
+        if (sendBenchEventBurst(&bench)) {
+          char name[0X40];
+
+          snprintf(name, sizeof(name), "burst, %s", implementation);
+          reportResult("events", name, bench.expected, getMonotonicNanosecondsElapsed(&start));
+        } else {
+          ok = 0;
+        }
+
+        asyncDiscardEvent(bench.event);
+      } else {
+        ok = 0;
+      }
+    }
+
+    {
+      EventBench bench = {
+        .count = iterations,
+        .expected = iterations
+      };
+
+      if ((bench.event = asyncNewEvent(handleTimedBenchEvent, &bench))) {
+        if (sendTimedBenchEvents(&bench)) {
+          char name[0X40];
+
+          snprintf(name, sizeof(name), "latency, %s", implementation);
+          reportResult("events", name, bench.received, bench.latency);
+        } else {
+          ok = 0;
+        }
+
+        asyncDiscardEvent(bench.event);
+      } else {
+        ok = 0;
+      }
+    }
+
+    if (!ok) break;
+  }
+
+  asyncSetEventQueueing(1);
+  return ok;
+}
+#else /* GOT_PTHREADS */
+static int
+benchmarkEvents (void) {
+  logUnsupportedOperation("events");
+  return 1;
+}
+#endif /* GOT_PTHREADS */
+
+#define ALARM_COUNT 64
+
+typedef struct {
+  AsyncHandle handles[ALARM_COUNT];
+  unsigned int fired;
+} AlarmChurn;
+
+ASYNC_ALARM_CALLBACK(handleChurnedAlarm) {
+  AlarmChurn *churn = parameters->data;
+  churn->fired += 1;
+}
+
+ASYNC_CONDITION_TESTER(testAlarmsFired) {
+  const AlarmChurn *churn = data;
+  return churn->fired == ALARM_COUNT;
+}
+
+static int
+newChurnedAlarms (AlarmChurn *churn, int later) {
+  churn->fired = 0;
+
+  for (unsigned int index=0; index<ALARM_COUNT; index+=1) {
+    int delay = later? (1000 + randomInteger(1000)): 0;
+
+    if (!asyncNewRelativeAlarm(&churn->handles[index], delay, handleChurnedAlarm, churn)) {
+      while (index) asyncCancelRequest(churn->handles[--index]);
+      return 0;
+    }
+  }
+
+  return 1;
+}
+
+static void
+cancelChurnedAlarms (AlarmChurn *churn) {
+  /* cancel from the middle outward so that both ends of the queue are hit */
+  for (unsigned int index=0; index<ALARM_COUNT; index+=1) {
+    unsigned int offset = (index + 1) / 2;
+    unsigned int middle = ALARM_COUNT / 2;
+    asyncCancelRequest(churn->handles[(index & 1)? (middle - offset): (middle + offset) % ALARM_COUNT]);
+  }
+}
+
+typedef enum {
+  CHURN_CANCEL,
+  CHURN_RESET,
+  CHURN_FIRE
+} ChurnMode;
+
+static int
+churnAlarms (ChurnMode mode) {
+  AlarmChurn churn;
+
+  if (!newChurnedAlarms(&churn, (mode != CHURN_FIRE))) return 0;
+
+  switch (mode) {
+    case CHURN_RESET:
+      for (unsigned int index=0; index<ALARM_COUNT; index+=1) {
+        asyncResetAlarmIn(churn.handles[index], 1000 + randomInteger(1000));
+      }
+      /* fall through */
+
+    case CHURN_CANCEL:
+      cancelChurnedAlarms(&churn);
+      return 1;
+
+    case CHURN_FIRE:
+      if (asyncAwaitCondition(1000, testAlarmsFired, &churn)) {
+        /* a fired alarm leaves its handle to be discarded by its owner */
+        for (unsigned int index=0; index<ALARM_COUNT; index+=1) {
+          asyncDiscardHandle(churn.handles[index]);
+        }
+
+        return 1;
+      }
+
+      logMessage(LOG_ERR, "alarms not fired: %u/%u", churn.fired, ALARM_COUNT);
+      return 0;
+  }
+
+  return 0;
+}
+
+static int
+benchmarkAlarms (void) {
+  static const struct {
+    const char *name;
+    ChurnMode mode;
+  } churnCases[] = {
+    { .name = "new and cancel", .mode = CHURN_CANCEL },
+    { .name = "new, reset, and cancel", .mode = CHURN_RESET },
+    { .name = "new and fire", .mode = CHURN_FIRE },
+  };
+
+  for (unsigned int index=0; index<ARRAY_COUNT(churnCases); index+=1) {
+    TimeValue start;
+    getMonotonicTime(&start);
+
+    for (unsigned int iteration=0; iteration<iterations; iteration+=1) {
+      if (!churnAlarms(churnCases[index].mode)) return 0;
+    }
+
+    reportResult("alarms", churnCases[index].name,
+                 (uint64_t)iterations * ALARM_COUNT, getMonotonicNanosecondsElapsed(&start));
+  }
+
+  return 1;
+}
+
+typedef struct {
+  const char *name;
+  int (*run) (void);
+} BenchmarkSuite;
+
+static const BenchmarkSuite benchmarkSuites[] = {
+  { .name = "update", .run = benchmarkUpdate },
+  { .name = "ttb", .run = benchmarkTextTable },
+  { .name = "utf8", .run = benchmarkUtf8 },
+  { .name = "cells", .run = benchmarkCells },
+  { .name = "crc", .run = benchmarkCRC },
+  { .name = "ctb", .run = benchmarkContraction },
+  { .name = "ktb", .run = benchmarkChords },
+  { .name = "packets", .run = benchmarkPackets },
+  { .name = "brlapi", .run = benchmarkBrlapi },
+  { .name = "events", .run = benchmarkEvents },
+  { .name = "alarms", .run = benchmarkAlarms },
+};
+
+static const BenchmarkSuite *
+getBenchmarkSuite (const char *name) {
+  for (unsigned int index=0; index<ARRAY_COUNT(benchmarkSuites); index+=1) {
+    const BenchmarkSuite *suite = &benchmarkSuites[index];
+    if (strcmp(name, suite->name) == 0) return suite;
+  }
+
+  return NULL;
+}
+
+int
+main (int argc, char *argv[]) {
+  const BenchmarkSuite *onlySuite = NULL;
+  TextTable *table = NULL;
+
+  {
+    static const OptionsDescriptor descriptor = {
+      OPTION_TABLE(programOptions),
+      .applicationName = "bench",
+      .argumentsSummary = ""
+    };
+
+    PROCESS_OPTIONS(descriptor, argc, argv);
+  }
+
+  if (opt_iterations && *opt_iterations) {
+    static const int minimum = 1;
+    int count;
+
+    if (!validateInteger(&count, opt_iterations, &minimum, NULL)) {
+      logMessage(LOG_ERR, "invalid iteration count: %s", opt_iterations);
+      return PROG_EXIT_SYNTAX;
+    }
+
+    iterations = count;
+  }
+
+  if (opt_suite && *opt_suite) {
+    if (!(onlySuite = getBenchmarkSuite(opt_suite))) {
+      logMessage(LOG_ERR, "unknown benchmark suite: %s", opt_suite);
+      return PROG_EXIT_SYNTAX;
+    }
+  }
+
+  if (opt_textTable && *opt_textTable) {
+    char *path = makeTextTablePath(opt_tablesDirectory, opt_textTable);
+
+    if (path) {
+      if (!(table = compileTextTable(path))) {
+        logMessage(LOG_ERR, "cannot compile text table: %s", path);
+      }
+
+      free(path);
+    }
+
+    if (!table) return PROG_EXIT_FATAL;
+    textTable = table;
+  }
+
+  resetPreferences();
+  srand(1);
+
+  {
+    int ok = 1;
+
+    beginReport();
+
+    for (unsigned int index=0; index<ARRAY_COUNT(benchmarkSuites); index+=1) {
+      const BenchmarkSuite *suite = &benchmarkSuites[index];
+      if (onlySuite && (suite != onlySuite)) continue;
+
+      if (!suite->run()) {
+        logMessage(LOG_ERR, "benchmark suite failed: %s", suite->name);
+        ok = 0;
+      }
+    }
+
+    endReport(ok);
+    if (table) destroyTextTable(table);
+    return ok? PROG_EXIT_SUCCESS: PROG_EXIT_FATAL;
+  }
+}
+
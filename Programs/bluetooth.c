@@ -27,6 +27,7 @@
 #include "timing.h"
 #include "async_wait.h"
 #include "parse.h"
+#include "file.h"
 #include "device.h"
 #include "queue.h"
 #include "io_bluetooth.h"
@@ -63,6 +64,7 @@ typedef struct {
   uint64_t address;
   char *name;
   int error;
+  uint8_t channel;
   unsigned paired:1;
 } BluetoothDeviceEntry;
 
@@ -79,12 +81,22 @@ bthCreateDeviceQueue (void *data) {
   return newQueue(bthDeallocateDeviceEntry, NULL);
 }
 
+static int bthLoadDeviceCache (void);
+static int bluetoothDeviceCacheLoaded = 0;
+
 static Queue *
 bthGetDeviceQueue (int create) {
   static Queue *devices = NULL;
 
-  return getProgramQueue(&devices, "bluetooth-device-queue", create,
-                         bthCreateDeviceQueue, NULL);
+  Queue *queue = getProgramQueue(&devices, "bluetooth-device-queue", create,
+                                 bthCreateDeviceQueue, NULL);
+
+  if (queue && !bluetoothDeviceCacheLoaded) {
+    bluetoothDeviceCacheLoaded = 1;
+    bthLoadDeviceCache();
+  }
+
+  return queue;
 }
 
 static int
@@ -108,6 +120,7 @@ bthGetDeviceEntry (uint64_t address, int add) {
         device->address = address;
         device->name = NULL;
         device->error = 0;
+        device->channel = 0;
         device->paired = 0;
 
         if (enqueueItem(devices, device)) return device;
@@ -138,6 +151,117 @@ bthSetDeviceName (BluetoothDeviceEntry *device, const char *name) {
   return 0;
 }
 
+/* The name and RFCOMM channel of each device that has been seen are kept,
+ * one device per line, in a file within the updatable directory so that
+ * reconnecting to it (even after a restart) needn't wait for them again.
+ * Each line contains the address, the channel (0 if not known), and the name.
+ */
+#define BLUETOOTH_DEVICE_CACHE_FILE "bluetooth-devices"
+
+static char *
+bthMakeDeviceCachePath (void) {
+  if (!getUpdatableDirectory()) return NULL;
+  return makeUpdatablePath(BLUETOOTH_DEVICE_CACHE_FILE);
+}
+
+static int
+bthLoadDeviceCacheLine (const LineHandlerParameters *parameters) {
+  const char *line = parameters->line.text;
+  char address[0X20];
+  unsigned int channel;
+  int offset;
+
+  if (sscanf(line, "%31s %u %n", address, &channel, &offset) == 2) {
+    uint64_t bda;
+
+    if (bthParseAddress(&bda, address) && (channel < 0X1F)) {
+      BluetoothDeviceEntry *device = bthGetDeviceEntry(bda, 1);
+
+      if (device) {
+        if (!device->channel) device->channel = channel;
+        if (!device->name) bthSetDeviceName(device, &line[offset]);
+      }
+
+      return 1;
+    }
+  }
+
+  logMessage(LOG_WARNING, "invalid Bluetooth device cache entry: %u: %s",
+             parameters->line.number, line);
+  return 1;
+}
+
+static int
+bthLoadDeviceCache (void) {
+  int ok = 0;
+  char *path = bthMakeDeviceCachePath();
+
+  if (path) {
+    FILE *stream = openFile(path, "r", 1);
+
+    if (stream) {
+      if (processLines(stream, bthLoadDeviceCacheLine, NULL)) ok = 1;
+      fclose(stream);
+    }
+
+    free(path);
+  }
+
+  return ok;
+}
+
+static int
+bthSaveDeviceCacheEntry (void *item, void *data) {
+  const BluetoothDeviceEntry *device = item;
+  FILE *stream = data;
+
+  if (device->channel || device->name) {
+    char address[0X20];
+
+    bthFormatAddress(address, sizeof(address), device->address);
+    fprintf(stream, "%s %u %s\n",
+            address, device->channel, (device->name? device->name: ""));
+  }
+
+  return 0;
+}
+
+static int
+bthSaveDeviceCache (void) {
+  int ok = 0;
+  Queue *devices = bthGetDeviceQueue(0);
+
+  if (devices) {
+    char *path = bthMakeDeviceCachePath();
+
+    if (path) {
+      char *newPath = ensureFileExtension(path, ".new");
+
+      if (newPath) {
+        FILE *stream = openFile(newPath, "w", 0);
+
+        if (stream) {
+          processQueue(devices, bthSaveDeviceCacheEntry, stream);
+
+          if (fclose(stream) == EOF) {
+            logSystemError("fclose");
+          } else if (rename(newPath, path) == -1) {
+            logSystemError("rename");
+          } else {
+            ok = 1;
+          }
+        }
+
+        free(newPath);
+      }
+
+      free(path);
+    }
+  }
+
+  return ok;
+}
+
 static inline const char *
 bthGetPairedKeyword (int state) {
   return getFlagKeywordYesNo(state);
@@ -178,6 +302,7 @@ bthForgetDevices (void) {
 
   if (devices) deleteElements(devices);
   bluetoothDevicesDiscovered = 0;
+  bluetoothDeviceCacheLoaded = 0;
 }
 
 static int
@@ -199,6 +324,47 @@ bthRecallConnectError (uint64_t address, int *value) {
   return 1;
 }
 
+static uint8_t
+bthRecallChannel (uint64_t address) {
+  BluetoothDeviceEntry *device = bthGetDeviceEntry(address, 0);
+  if (!device) return 0;
+  return device->channel;
+}
+
+static void
+bthRememberChannel (uint64_t address, uint8_t channel) {
+  BluetoothDeviceEntry *device = bthGetDeviceEntry(address, 1);
+
+  if (device) {
+    if (channel != device->channel) {
+      device->channel = channel;
+      bthSaveDeviceCache();
+    }
+  }
+}
+
+static int
+bthDiscoverChannelOfDevice (BluetoothConnection *connection, int timeout) {
+  if (!bthDiscoverSerialPortChannel(&connection->channel, connection->extension, timeout)) return 0;
+  bthRememberChannel(connection->address, connection->channel);
+  return 1;
+}
+
+static int
+bthOpenChannelOfDevice (BluetoothConnection *connection, int timeout) {
+  TimePeriod period;
+  startTimePeriod(&period, BLUETOOTH_CHANNEL_BUSY_RETRY_TIMEOUT);
+
+  while (1) {
+    if (bthOpenChannel(connection->extension, connection->channel, timeout)) return 1;
+    if (afterTimePeriod(&period, NULL)) break;
+    if (errno != EBUSY) break;
+    asyncWait(BLUETOOTH_CHANNEL_BUSY_RETRY_INTERVAL);
+  }
+
+  return 0;
+}
+
 static BluetoothConnection *
 bthNewConnection (uint64_t address, uint8_t channel, int discover, int timeout) {
   BluetoothConnection *connection;
@@ -210,8 +376,17 @@ bthNewConnection (uint64_t address, uint8_t channel, int discover, int timeout)
 
     if ((connection->extension = bthNewConnectionExtension(connection->address))) {
       int alreadyTried = 0;
+      uint8_t cachedChannel = 0;
+
+      if (discover) {
+        if ((cachedChannel = bthRecallChannel(connection->address))) {
+          logMessage(LOG_CATEGORY(BLUETOOTH_IO), "serial port channel cached: %u", cachedChannel);
+          connection->channel = cachedChannel;
+        } else {
+          bthDiscoverChannelOfDevice(connection, timeout);
+        }
+      }
 
-      if (discover) bthDiscoverSerialPortChannel(&connection->channel, connection->extension, timeout);
       bthLogChannel(connection->channel);
 
       {
@@ -224,17 +399,19 @@ bthNewConnection (uint64_t address, uint8_t channel, int discover, int timeout)
       }
 
       if (!alreadyTried) {
-        TimePeriod period;
-        startTimePeriod(&period, BLUETOOTH_CHANNEL_BUSY_RETRY_TIMEOUT);
-
-        while (1) {
-          if (bthOpenChannel(connection->extension, connection->channel, timeout)) {
-            return connection;
+        if (bthOpenChannelOfDevice(connection, timeout)) return connection;
+
+        if (cachedChannel) {
+          /* the device may have been reconfigured since the channel was cached */
+          int error = errno;
+
+          if (bthDiscoverChannelOfDevice(connection, timeout) &&
+              (connection->channel != cachedChannel)) {
+            bthLogChannel(connection->channel);
+            if (bthOpenChannelOfDevice(connection, timeout)) return connection;
+          } else {
+            errno = error;
           }
-
-          if (afterTimePeriod(&period, NULL)) break;
-          if (errno != EBUSY) break;
-          asyncWait(BLUETOOTH_CHANNEL_BUSY_RETRY_INTERVAL);
         }
 
         bthRememberConnectError(connection->address, errno);
@@ -648,6 +825,7 @@ bthGetDeviceName (uint64_t address, int timeout) {
 
       if ((device->name = bthObtainDeviceName(address, timeout))) {
         logMessage(LOG_CATEGORY(BLUETOOTH_IO), "device name: %s", device->name);
+        bthSaveDeviceCache();
       } else {
         logMessage(LOG_CATEGORY(BLUETOOTH_IO), "device name not obtained");
       }
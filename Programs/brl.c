@@ -28,6 +28,7 @@
 #include "charset.h"
 #include "unicode.h"
 #include "brl.h"
+#include "brl_utils.h"
 #include "ttb.h"
 #include "ktb.h"
 #include "queue.h"
@@ -60,6 +61,10 @@ constructBrailleDisplay (BrailleDisplay *brl) {
   brl->quality = 0;
   brl->isCoreBuffer = 0;
 
+  brl->rows.cells = NULL;
+  brl->rows.changed = NULL;
+  brl->rows.force = 0;
+
   brl->bufferResized = NULL;
   brl->resizeRequired = 0;
 
@@ -78,6 +83,19 @@ constructBrailleDisplay (BrailleDisplay *brl) {
   brl->acknowledgements.missing.limit = BRAILLE_MESSAGE_UNACKNOWLEDGEED_LIMIT;
 }
 
+static void
+deallocateBrailleRows (BrailleDisplay *brl) {
+  if (brl->rows.cells) {
+    free(brl->rows.cells);
+    brl->rows.cells = NULL;
+  }
+
+  if (brl->rows.changed) {
+    free(brl->rows.changed);
+    brl->rows.changed = NULL;
+  }
+}
+
 void
 destructBrailleDisplay (BrailleDisplay *brl) {
   if (brl->acknowledgements.alarm) {
@@ -99,6 +117,8 @@ destructBrailleDisplay (BrailleDisplay *brl) {
     if (brl->isCoreBuffer) free(brl->buffer);
     brl->buffer = NULL;
   }
+
+  deallocateBrailleRows(brl);
 }
 
 static void
@@ -208,6 +228,7 @@ brailleBufferResized (BrailleDisplay *brl, int infoLevel) {
   );
 
   memset(brl->buffer, 0, brl->textColumns*brl->textRows);
+  deallocateBrailleRows(brl);
   if (brl->bufferResized) brl->bufferResized(brl->textRows, brl->textColumns);
 }
 
@@ -242,6 +263,42 @@ ensureBrailleBuffer (BrailleDisplay *brl, int infoLevel) {
   return resizeBrailleBuffer(brl, 1, infoLevel);
 }
 
+const unsigned char *
+getChangedBrailleRows (BrailleDisplay *brl) {
+  if (!brl->rows.cells) {
+    size_t size = brl->textColumns * brl->textRows;
+
+    if (!(brl->rows.cells = malloc(size))) {
+      logMallocError();
+      return NULL;
+    }
+
+    if (!(brl->rows.changed = malloc(brl->textRows))) {
+      logMallocError();
+      deallocateBrailleRows(brl);
+      return NULL;
+    }
+
+    brl->rows.force = 1;
+  }
+
+  cellRowsHaveChanged(brl->rows.cells, brl->buffer,
+                      brl->textColumns, brl->textRows,
+                      brl->rows.changed, &brl->rows.force);
+
+  return brl->rows.changed;
+}
+
+int
+writeBrailleRows (BrailleDisplay *brl, const wchar_t *text) {
+  if (braille->writeWindowRows) {
+    const unsigned char *changedRows = getChangedBrailleRows(brl);
+    if (changedRows) return braille->writeWindowRows(brl, text, changedRows);
+  }
+
+  return braille->writeWindow(brl, text);
+}
+
 int
 readBrailleCommand (BrailleDisplay *brl, KeyTableCommandContext context) {
   int command = braille->readCommand(brl, context);
@@ -259,6 +316,7 @@ int
 refreshBrailleDisplay (BrailleDisplay *brl) {
   if (!canRefreshBrailleDisplay(brl)) return 0;
   logMessage(LOG_DEBUG, "refreshing braille display");
+  brl->rows.force = 1;
   return brl->refreshBrailleDisplay(brl);
 }
 
@@ -51,6 +51,9 @@ extern int setStatusText (BrailleDisplay *brl, const char *text);
 
 extern int readBrailleCommand (BrailleDisplay *, KeyTableCommandContext);
 
+extern const unsigned char *getChangedBrailleRows (BrailleDisplay *brl);
+extern int writeBrailleRows (BrailleDisplay *brl, const wchar_t *text);
+
 extern int canRefreshBrailleDisplay (BrailleDisplay *brl);
 extern int refreshBrailleDisplay (BrailleDisplay *brl);
 
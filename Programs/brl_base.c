@@ -255,7 +255,14 @@ writeBraillePacket (
   if (gioWriteData(endpoint, packet, size) == -1) return 0;
 
   if (endpoint == brl->gioEndpoint) {
-    brl->writeDelay += gioGetMillisecondsToTransfer(endpoint, size);
+    ssize_t pending = gioGetPendingOutput(endpoint);
+
+    if (pending != -1) {
+      /* the port knows how much of what has been written is still queued */
+      brl->writeDelay = gioGetMillisecondsToTransfer(endpoint, pending);
+    } else {
+      brl->writeDelay += gioGetMillisecondsToTransfer(endpoint, size);
+    }
   }
 
   return 1;
@@ -626,23 +633,69 @@ enqueueKeyEvent (
   return 0;
 }
 
+static int
+translateKeyTableEvents (BrailleDisplay *brl, const KeyTableEvent *events, unsigned int count) {
+  if (count) {
+    if (!brl->keyTable) return 0;
+    processKeyEvents(brl->keyTable, getCurrentCommandContext(), events, count);
+  }
+
+  return 1;
+}
+
+static int
+enqueueKeyTableEvents (BrailleDisplay *brl, const KeyTableEvent *events, unsigned int count) {
+  const KeyTableEvent *event = events;
+  const KeyTableEvent *end = event + count;
+  const KeyTableEvent *run = event;
+
+  /* Each event is still offered to the API first, but a run of consecutive
+   * events which it doesn't take is translated as one batch.
+   */
+  while (event < end) {
+    report(REPORT_BRAILLE_KEY_EVENT, NULL);
+
+    if (api.handleKeyEvent(event->group, event->number, event->press)) {
+      if (!translateKeyTableEvents(brl, run, event - run)) return 0;
+      run = event + 1;
+    }
+
+    event += 1;
+  }
+
+  return translateKeyTableEvents(brl, run, event - run);
+}
+
+static void
+addKeyTableEvent (
+  KeyTableEvent *events, unsigned int *count,
+  KeyGroup group, KeyNumber number, int press
+) {
+  KeyTableEvent *event = &events[(*count)++];
+
+  event->group = group;
+  event->number = number;
+  event->press = !!press;
+}
+
+#define KEY_NUMBER_SET_SIZE (sizeof(KeyNumberSet) * 8)
+
 int
 enqueueKeyEvents (
   BrailleDisplay *brl,
   KeyNumberSet set, KeyGroup group, KeyNumber number, int press
 ) {
+  KeyTableEvent events[KEY_NUMBER_SET_SIZE];
+  unsigned int count = 0;
+
   while (set) {
-    if (set & 0X1) {
-      if (!enqueueKeyEvent(brl, group, number, press)) {
-        return 0;
-      }
-    }
+    if (set & 0X1) addKeyTableEvent(events, &count, group, number, press);
 
     set >>= 1;
     number += 1;
   }
 
-  return 1;
+  return enqueueKeyTableEvents(brl, events, count);
 }
 
 int
@@ -664,26 +717,26 @@ enqueueKeys (
   BrailleDisplay *brl,
   KeyNumberSet set, KeyGroup group, KeyNumber number
 ) {
-  KeyNumber stack[UINT8_MAX + 1];
-  unsigned char count = 0;
+  KeyTableEvent events[KEY_NUMBER_SET_SIZE * 2];
+  unsigned int count = 0;
 
   while (set) {
-    if (set & 0X1) {
-      if (!enqueueKeyEvent(brl, group, number, 1)) return 0;
-      stack[count++] = number;
-    }
+    if (set & 0X1) addKeyTableEvent(events, &count, group, number, 1);
 
     set >>= 1;
     number += 1;
   }
 
-  while (count) {
-    if (!enqueueKeyEvent(brl, group, stack[--count], 0)) {
-      return 0;
+  {
+    unsigned int index = count;
+
+    while (index) {
+      const KeyTableEvent *press = &events[--index];
+      addKeyTableEvent(events, &count, press->group, press->number, 0);
     }
   }
 
-  return 1;
+  return enqueueKeyTableEvents(brl, events, count);
 }
 
 int
@@ -692,15 +745,18 @@ enqueueUpdatedKeys (
   KeyNumberSet new, KeyNumberSet *old, KeyGroup group, KeyNumber number
 ) {
   KeyNumberSet bit = KEY_NUMBER_BIT(0);
-  KeyNumber stack[UINT8_MAX + 1];
+  KeyNumber stack[KEY_NUMBER_SET_SIZE];
   unsigned char count = 0;
 
+  KeyTableEvent events[KEY_NUMBER_SET_SIZE];
+  unsigned int eventCount = 0;
+
   while (*old != new) {
     if ((new & bit) && !(*old & bit)) {
       stack[count++] = number;
       *old |= bit;
     } else if (!(new & bit) && (*old & bit)) {
-      if (!enqueueKeyEvent(brl, group, number, 0)) return 0;
+      addKeyTableEvent(events, &eventCount, group, number, 0);
       *old &= ~bit;
     }
 
@@ -708,13 +764,8 @@ enqueueUpdatedKeys (
     bit <<= 1;
   }
 
-  while (count) {
-    if (!enqueueKeyEvent(brl, group, stack[--count], 1)) {
-      return 0;
-    }
-  }
-
-  return 1;
+  while (count) addKeyTableEvent(events, &eventCount, group, stack[--count], 1);
+  return enqueueKeyTableEvents(brl, events, eventCount);
 }
 
 int
@@ -729,6 +780,9 @@ enqueueUpdatedKeyGroup (
   unsigned char pressCount = 0;
   KeyNumber base = 0;
 
+  KeyTableEvent events[count];
+  unsigned int eventCount = 0;
+
   while (base < count) {
     KeyNumber number = base;
     unsigned char bit = 1;
@@ -742,7 +796,7 @@ enqueueUpdatedKeyGroup (
         pressStack[pressCount++] = number;
       } else if (wasPressed && !isPressed) {
         *old &= ~bit;
-        enqueueKeyEvent(brl, group, number, 0);
+        addKeyTableEvent(events, &eventCount, group, number, 0);
       }
 
       if (++number == count) break;
@@ -755,9 +809,10 @@ enqueueUpdatedKeyGroup (
   }
 
   while (pressCount > 0) {
-    enqueueKeyEvent(brl, group, pressStack[--pressCount], 1);
+    addKeyTableEvent(events, &eventCount, group, pressStack[--pressCount], 1);
   }
 
+  enqueueKeyTableEvents(brl, events, eventCount);
   return 1;
 }
 
@@ -75,6 +75,64 @@ setBrailleOnline (BrailleDisplay *brl) {
   }
 }
 
+typedef uint64_t CellWord;
+
+static unsigned int
+findFirstDifference (const unsigned char *old, const unsigned char *new, unsigned int count) {
+  unsigned int index = 0;
+
+  while ((count - index) >= sizeof(CellWord)) {
+    CellWord oldWord, newWord;
+
+    memcpy(&oldWord, &old[index], sizeof(oldWord));
+    memcpy(&newWord, &new[index], sizeof(newWord));
+    if (oldWord != newWord) break;
+
+    index += sizeof(CellWord);
+  }
+
+  while (index < count) {
+    if (old[index] != new[index]) break;
+    index += 1;
+  }
+
+  return index;
+}
+
+static unsigned int
+findLastDifference (const unsigned char *old, const unsigned char *new, unsigned int count) {
+  while (count >= sizeof(CellWord)) {
+    unsigned int index = count - sizeof(CellWord);
+    CellWord oldWord, newWord;
+
+    memcpy(&oldWord, &old[index], sizeof(oldWord));
+    memcpy(&newWord, &new[index], sizeof(newWord));
+    if (oldWord != newWord) break;
+
+    count = index;
+  }
+
+  while (count) {
+    unsigned int last = count - 1;
+    if (old[last] != new[last]) break;
+    count = last;
+  }
+
+  return count;
+}
+
+static unsigned int
+findFirstSameness (const unsigned char *old, const unsigned char *new, unsigned int count) {
+  unsigned int index = 0;
+
+  while (index < count) {
+    if (old[index] == new[index]) break;
+    index += 1;
+  }
+
+  return index;
+}
+
 int
 cellsHaveChanged (
   unsigned char *cells, const unsigned char *new, unsigned int count,
@@ -84,21 +142,9 @@ cellsHaveChanged (
 
   if (force && *force) {
     *force = 0;
-  } else if (memcmp(cells, new, count) != 0) {
-    if (to) {
-      while (count) {
-        unsigned int last = count - 1;
-        if (cells[last] != new[last]) break;
-        count = last;
-      }
-    }
-
-    if (from) {
-      while (first < count) {
-        if (cells[first] != new[first]) break;
-        first += 1;
-      }
-    }
+  } else if ((first = findFirstDifference(cells, new, count)) < count) {
+    if (to) count = first + findLastDifference(&cells[first], &new[first], count-first);
+    if (!from) first = 0;
   } else {
     return 0;
   }
@@ -110,6 +156,225 @@ cellsHaveChanged (
   return 1;
 }
 
+unsigned int
+cellsHaveChangedSpans (
+  unsigned char *cells, const unsigned char *new, unsigned int count,
+  CellSpan *spans, unsigned int limit, unsigned int gap, unsigned char *force
+) {
+  unsigned int spanCount = 0;
+
+  if (!limit) return 0;
+
+  if (force && *force) {
+    *force = 0;
+
+    spans[spanCount++] = (CellSpan){
+      .from = 0,
+      .to = count
+    };
+  } else {
+    unsigned int from = findFirstDifference(cells, new, count);
+
+    if (from == count) return 0;
+    count = from + findLastDifference(&cells[from], &new[from], count-from);
+
+    while (from < count) {
+      unsigned int to = from + findFirstSameness(&cells[from], &new[from], count-from);
+
+      if (spanCount && ((from - spans[spanCount-1].to) < gap)) {
+        spans[spanCount-1].to = to;
+      } else if (spanCount == limit) {
+        spans[spanCount-1].to = count;
+        break;
+      } else {
+        spans[spanCount++] = (CellSpan){
+          .from = from,
+          .to = to
+        };
+      }
+
+      if (to == count) break;
+      from = to + findFirstDifference(&cells[to], &new[to], count-to);
+    }
+  }
+
+  for (unsigned int index=0; index<spanCount; index+=1) {
+    const CellSpan *span = &spans[index];
+    memcpy(&cells[span->from], &new[span->from], (span->to - span->from));
+  }
+
+  return spanCount;
+}
+
+unsigned int
+getCellWriteBytes (
+  const unsigned char *cells, const CellSpan *span, const CellWriteCost *cost
+) {
+  unsigned int count = span->to - span->from;
+  unsigned int bytes = cost->packetBytes + (count * cost->cellBytes);
+
+  if (cost->escapeBytes) {
+    const unsigned char *cell = &cells[span->from];
+    const unsigned char *end = cell + count;
+
+    while (cell < end) {
+      if (*cell++ == cost->escapeCell) bytes += cost->escapeBytes;
+    }
+  }
+
+  return bytes;
+}
+
+static void
+logCellWritePlan (
+  const unsigned char *cells, const CellSpan *spans, unsigned int count,
+  const CellWriteCost *cost
+) {
+  const CellSpan whole = {
+    .from = spans[0].from,
+    .to = spans[count-1].to
+  };
+
+  unsigned int bytes = 0;
+
+  for (unsigned int index=0; index<count; index+=1) {
+    bytes += getCellWriteBytes(cells, &spans[index], cost);
+  }
+
+  logMessage(LOG_CATEGORY(OUTPUT_PACKETS),
+             "cell writes: %u spans, %u bytes (%u saved)",
+             count, bytes, (getCellWriteBytes(cells, &whole, cost) - bytes));
+}
+
+unsigned int
+planCellWrites (
+  unsigned char *cells, const unsigned char *new, unsigned int count,
+  CellSpan *spans, unsigned int limit, const CellWriteCost *cost, unsigned char *force
+) {
+  unsigned int spanCount = 0;
+
+  if (!limit) return 0;
+
+  if (force && *force) {
+    *force = 0;
+
+    spans[spanCount++] = (CellSpan){
+      .from = 0,
+      .to = count
+    };
+  } else {
+    unsigned int from = findFirstDifference(cells, new, count);
+
+    if (from == count) return 0;
+    count = from + findLastDifference(&cells[from], &new[from], count-from);
+
+    {
+      CellSpan runs[((count - from) + 1) / 2];
+      unsigned int runCount = 0;
+
+      while (1) {
+        unsigned int to = from + findFirstSameness(&cells[from], &new[from], count-from);
+
+        runs[runCount++] = (CellSpan){
+          .from = from,
+          .to = to
+        };
+
+        if (to == count) break;
+        from = to + findFirstDifference(&cells[to], &new[to], count-to);
+      }
+
+      {
+        /* Each write costs the same fixed overhead and every covered cell costs
+         * the same whatever write it's in, so the unchanged gap between two
+         * runs is worth a write of its own only when resending it would cost
+         * more than that overhead. When there are more such gaps than spans
+         * then the cheapest of them are resent after all.
+         */
+        unsigned int gapBytes[runCount];
+        unsigned char split[runCount];
+        unsigned int splitCount = 0;
+
+        for (unsigned int run=1; run<runCount; run+=1) {
+          const CellSpan gap = {
+            .from = runs[run-1].to,
+            .to = runs[run].from
+          };
+
+          unsigned int *bytes = &gapBytes[run-1];
+          *bytes = getCellWriteBytes(new, &gap, cost) - cost->packetBytes;
+
+          if ((split[run-1] = *bytes > cost->packetBytes)) splitCount += 1;
+        }
+
+        while (splitCount >= limit) {
+          unsigned int cheapest = runCount;
+
+          for (unsigned int gap=0; gap<(runCount-1); gap+=1) {
+            if (split[gap]) {
+              if ((cheapest == runCount) || (gapBytes[gap] < gapBytes[cheapest])) {
+                cheapest = gap;
+              }
+            }
+          }
+
+          split[cheapest] = 0;
+          splitCount -= 1;
+        }
+
+        spans[0].from = runs[0].from;
+
+        for (unsigned int run=1; run<runCount; run+=1) {
+          if (split[run-1]) {
+            spans[spanCount++].to = runs[run-1].to;
+            spans[spanCount].from = runs[run].from;
+          }
+        }
+
+        spans[spanCount++].to = runs[runCount-1].to;
+      }
+    }
+
+    if ((spanCount > 1) && LOG_CATEGORY_FLAG(OUTPUT_PACKETS)) {
+      logCellWritePlan(new, spans, spanCount, cost);
+    }
+  }
+
+  for (unsigned int index=0; index<spanCount; index+=1) {
+    const CellSpan *span = &spans[index];
+    memcpy(&cells[span->from], &new[span->from], (span->to - span->from));
+  }
+
+  return spanCount;
+}
+
+unsigned int
+cellRowsHaveChanged (
+  unsigned char *cells, const unsigned char *new,
+  unsigned int columns, unsigned int rows,
+  unsigned char *changedRows, unsigned char *force
+) {
+  unsigned int changedCount = 0;
+  int forced = force && *force;
+
+  if (forced) *force = 0;
+
+  for (unsigned int row=0; row<rows; row+=1) {
+    unsigned char *oldRow = &cells[row * columns];
+    const unsigned char *newRow = &new[row * columns];
+    int changed = forced || (findFirstDifference(oldRow, newRow, columns) < columns);
+
+    if (changed) {
+      memcpy(oldRow, newRow, columns);
+      changedCount += 1;
+    }
+
+    if (changedRows) changedRows[row] = changed;
+  }
+
+  return changedCount;
+}
+
 int
 textHasChanged (
   wchar_t *text, const wchar_t *new, unsigned int count,
@@ -119,23 +384,22 @@ textHasChanged (
 
   if (force && *force) {
     *force = 0;
-  } else if (wmemcmp(text, new, count) != 0) {
+  } else {
+    const unsigned char *oldBytes = (const unsigned char *)text;
+    const unsigned char *newBytes = (const unsigned char *)new;
+    unsigned int size = count * sizeof(*text);
+    unsigned int offset = findFirstDifference(oldBytes, newBytes, size);
+
+    if (offset == size) return 0;
+    first = offset / sizeof(*text);
+
     if (to) {
-      while (count) {
-        unsigned int last = count - 1;
-        if (text[last] != new[last]) break;
-        count = last;
-      }
+      offset = first * sizeof(*text);
+      size = offset + findLastDifference(&oldBytes[offset], &newBytes[offset], size-offset);
+      count = (size + sizeof(*text) - 1) / sizeof(*text);
     }
 
-    if (from) {
-      while (first < count) {
-        if (text[first] != new[first]) break;
-        first += 1;
-      }
-    }
-  } else {
-    return 0;
+    if (!from) first = 0;
   }
 
   if (from) *from = first;
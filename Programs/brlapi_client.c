@@ -106,6 +106,7 @@
 
 #define BRLAPI(fun) brlapi_ ## fun
 #include "brlapi_common.h"
+#include "utf8.h"
 
 #ifndef MIN
 #define MIN(a, b) (((a) < (b))? (a): (b))
@@ -296,6 +297,16 @@ struct brlapi_handle_t { /* Connection-specific information */
    * deleted item. */
   struct brlapi_parameterCallback_t *nextCallback;
 
+#ifdef BRLAPI_SHARED_MEMORY
+  /* Shared with the server, keys are read from it as soon as it's set up */
+  brlapi_sharedMemory_t *shared;
+  /* Whether the server has accepted it, so that writes may go through it */
+  int sharedWrites;
+  /* Whether every key sent on the socket before it was accepted has been
+   * read, so that the key ring may be drained without being notified */
+  int sharedKeys;
+#endif /* BRLAPI_SHARED_MEMORY */
+
   void *clientData; /* Private client data */
 };
 
@@ -357,9 +368,56 @@ static void brlapi_initializeHandle(brlapi_handle_t *handle)
     pthread_mutex_init(&handle->callbacks_mutex, &mattr);
   }
   handle->nextCallback = NULL;
+#ifdef BRLAPI_SHARED_MEMORY
+  handle->shared = NULL;
+  handle->sharedWrites = 0;
+  handle->sharedKeys = 0;
+#endif /* BRLAPI_SHARED_MEMORY */
   handle->clientData = NULL;
 }
 
+#ifdef BRLAPI_SHARED_MEMORY
+/* brlapi_drainSharedKeys */
+/* Moves the keys from the shared key ring to the key buffer */
+/* Must be called with read_mutex locked */
+static void brlapi__drainSharedKeys(brlapi_handle_t *handle)
+{
+  brlapi_sharedMemory_t *shared = handle->shared;
+  uint32_t head = shared->keyHead;
+  uint32_t tail = shared->keyTail;
+
+  __sync_synchronize();
+
+  while (head != tail) {
+    brlapi_keyCode_t key = shared->keys[head++ % BRLAPI_SHARED_KEYS];
+
+    if (handle->keybuf_nb>=BRL_KEYBUF_SIZE) {
+      syslog(LOG_WARNING,"lost key: 0X%016"BRLAPI_PRIxKEYCODE"\n",key);
+    } else {
+      handle->keybuf[(handle->keybuf_next+handle->keybuf_nb++)%BRL_KEYBUF_SIZE] = key;
+    }
+  }
+
+  __sync_synchronize();
+  shared->keyHead = head;
+}
+
+/* brlapi_takeBufferedKey */
+/* Removes the oldest key from the key buffer, in packet format */
+/* Must be called with read_mutex locked and a key buffered */
+static ssize_t brlapi__takeBufferedKey(brlapi_handle_t *handle, void *packet, size_t size)
+{
+  brlapi_keyCode_t key = handle->keybuf[handle->keybuf_next];
+  uint32_t buf[2] = { htonl(key >> 32), htonl(key & 0xffffffff) };
+
+  handle->keybuf_next = (handle->keybuf_next+1)%BRL_KEYBUF_SIZE;
+  handle->keybuf_nb--;
+
+  memcpy(packet, buf, MIN(size, sizeof(buf)));
+  return sizeof(buf);
+}
+#endif /* BRLAPI_SHARED_MEMORY */
+
 /* brlapi_doWaitForPacket */
 /* Waits for the specified type of packet: must be called with brlapi_req_mutex locked */
 /* deadline can be used to stop waiting after a given date, or wait forever (NULL) */
@@ -382,6 +440,9 @@ static ssize_t brlapi__doWaitForPacket(brlapi_handle_t *handle, brlapi_packetTyp
   struct timeval now;
   int delay = 0;
 
+#ifdef BRLAPI_SHARED_MEMORY
+again:
+#endif /* BRLAPI_SHARED_MEMORY */
   do {
     if (deadline) {
       getRealTime(&now);
@@ -452,6 +513,43 @@ static ssize_t brlapi__doWaitForPacket(brlapi_handle_t *handle, brlapi_packetTyp
   size = handle->packet.header.size;
   type = handle->packet.header.type;
 
+#ifdef BRLAPI_SHARED_MEMORY
+  if (handle->packet.descriptor != -1) {
+    /* The server never passes file descriptors */
+    close(handle->packet.descriptor);
+    handle->packet.descriptor = -1;
+  }
+
+  if ((type==BRLAPI_PACKET_SHAREDNOTIFY) && handle->shared) {
+    ssize_t res = -3;
+
+    pthread_mutex_lock(&handle->read_mutex);
+    handle->shared->keyNotifyPending = 0;
+    __sync_synchronize();
+    brlapi__drainSharedKeys(handle);
+
+    if (!handle->keybuf_nb) {
+      /* Nothing new, brlapi_readKey already took them */
+      pthread_mutex_unlock(&handle->read_mutex);
+      goto again;
+    }
+
+    if (expectedPacketType==BRLAPI_PACKET_KEY) {
+      res = brlapi__takeBufferedKey(handle, packet, packetSize);
+    } else if (handle->altSem && (handle->altExpectedPacketType==BRLAPI_PACKET_KEY)) {
+      *handle->altRes = brlapi__takeBufferedKey(handle, handle->altPacket, handle->altSize);
+#ifndef WINDOWS
+      if (sem_post)
+#endif /* WINDOWS */
+        sem_post(handle->altSem);
+      handle->altSem = NULL;
+    }
+
+    pthread_mutex_unlock(&handle->read_mutex);
+    return res;
+  }
+#endif /* BRLAPI_SHARED_MEMORY */
+
   if (type==expectedPacketType)
   {
     /* For us, just copy */
@@ -671,6 +769,191 @@ static int brlapi__writePacketWaitForAck(brlapi_handle_t *handle, brlapi_packetT
   return res;
 }
 
+#ifdef BRLAPI_SHARED_MEMORY
+/* brlapi_writeDescriptorPacket */
+/* Sends an empty packet along with a file descriptor */
+static int brlapi_writeDescriptorPacket(brlapi_fileDescriptor fd, brlapi_packetType_t type, int descriptor)
+{
+  uint32_t header[2] = { htonl(0), htonl(type) };
+  struct iovec iov = {
+    .iov_base = header,
+    .iov_len = sizeof(header)
+  };
+
+  union {
+    struct cmsghdr header;
+    char buffer[CMSG_SPACE(sizeof(int))];
+  } control;
+
+  struct msghdr message = {
+    .msg_iov = &iov,
+    .msg_iovlen = 1,
+    .msg_control = &control,
+    .msg_controllen = sizeof(control)
+  };
+
+  struct cmsghdr *cmsg;
+  ssize_t res;
+
+  memset(&control, 0, sizeof(control));
+  cmsg = CMSG_FIRSTHDR(&message);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type = SCM_RIGHTS;
+  cmsg->cmsg_len = CMSG_LEN(sizeof(descriptor));
+  memcpy(CMSG_DATA(cmsg), &descriptor, sizeof(descriptor));
+
+  do {
+    res = sendmsg(fd, &message, 0);
+  } while ((res == -1) && (errno == EINTR));
+
+  if (res != sizeof(header)) {
+    LibcError("sendmsg in writeDescriptorPacket");
+    return -1;
+  }
+
+  return 0;
+}
+
+/* brlapi_writeSharedPacket */
+/* Queues a write packet in the shared write ring */
+/* Must be called with fileDescriptor_mutex locked */
+/* Returns 1 if queued, 0 if the ring is full, -1 on error */
+static int brlapi__writeSharedPacket(brlapi_handle_t *handle, const void *buf, size_t size)
+{
+  brlapi_sharedMemory_t *shared = handle->shared;
+  uint32_t tail = shared->writeTail;
+
+  /* Requests sent through the socket while the ring is full or after it has
+   * been written to are still handled in order since a notification is then
+   * always ahead of them. */
+  if ((uint32_t)(tail - shared->writeHead) >= BRLAPI_SHARED_WRITES) return 0;
+
+  {
+    brlapi_sharedWrite_t *slot = &shared->writes[tail % BRLAPI_SHARED_WRITES];
+    slot->size = size;
+    memcpy(slot->data, buf, size);
+  }
+
+  __sync_synchronize();
+  shared->writeTail = tail + 1;
+  __sync_synchronize();
+
+  if (!shared->writeNotifyPending) {
+    shared->writeNotifyPending = 1;
+    if (brlapi_writePacket(handle->fileDescriptor,BRLAPI_PACKET_SHAREDNOTIFY,NULL,0) < 0) return -1;
+  }
+
+  return 1;
+}
+#endif /* BRLAPI_SHARED_MEMORY */
+
+/* brlapi_sendWritePacket */
+/* Sends a write packet, through the shared memory if possible */
+static int brlapi__sendWritePacket(brlapi_handle_t *handle, const void *buf, size_t size)
+{
+  int res;
+
+  pthread_mutex_lock(&handle->fileDescriptor_mutex);
+
+#ifdef BRLAPI_SHARED_MEMORY
+  if (handle->sharedWrites && ((res = brlapi__writeSharedPacket(handle, buf, size)) != 0)) {
+    if (res > 0) res = 0;
+  } else
+#endif /* BRLAPI_SHARED_MEMORY */
+
+  {
+    res = brlapi_writePacket(handle->fileDescriptor,BRLAPI_PACKET_WRITE,buf,size);
+  }
+
+  pthread_mutex_unlock(&handle->fileDescriptor_mutex);
+  return res;
+}
+
+/* brlapi__enableSharedMemory */
+/* Sets up memory shared with the server */
+int BRLAPI_STDCALL brlapi__enableSharedMemory(brlapi_handle_t *handle)
+{
+#ifdef BRLAPI_SHARED_MEMORY
+  brlapi_sharedMemory_t *shared;
+  int fd;
+  int res = -1;
+
+  if (handle->addrfamily != PF_LOCAL) {
+    brlapi_errno = BRLAPI_ERROR_OPNOTSUPP;
+    return -1;
+  }
+
+  if (handle->shared) return 0;
+
+  if ((fd = memfd_create("brlapi", MFD_CLOEXEC|MFD_ALLOW_SEALING)) == -1) {
+    LibcError("memfd_create");
+    return -1;
+  }
+
+  if (ftruncate(fd, sizeof(*shared)) == -1) {
+    LibcError("ftruncate");
+    goto closeFile;
+  }
+
+  /* The server only accepts it if it can't be shrunk underneath it */
+  if (fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK|F_SEAL_GROW|F_SEAL_SEAL) == -1) {
+    LibcError("fcntl F_ADD_SEALS");
+    goto closeFile;
+  }
+
+  shared = mmap(NULL, sizeof(*shared), PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+  if (shared == MAP_FAILED) {
+    LibcError("mmap");
+    goto closeFile;
+  }
+
+  shared->magic = BRLAPI_SHARED_MAGIC;
+  shared->version = BRLAPI_SHARED_VERSION;
+
+  /* Key notifications may arrive as soon as the server has accepted it,
+   * possibly even before its acknowledgement. */
+  pthread_mutex_lock(&handle->read_mutex);
+  handle->shared = shared;
+  pthread_mutex_unlock(&handle->read_mutex);
+
+  pthread_mutex_lock(&handle->req_mutex);
+  pthread_mutex_lock(&handle->fileDescriptor_mutex);
+  res = brlapi_writeDescriptorPacket(handle->fileDescriptor, BRLAPI_PACKET_SHAREDMEMORY, fd);
+  pthread_mutex_unlock(&handle->fileDescriptor_mutex);
+  if (res >= 0) res = brlapi__waitForAck(handle);
+
+  if (res >= 0) {
+    pthread_mutex_lock(&handle->fileDescriptor_mutex);
+    handle->sharedWrites = 1;
+    pthread_mutex_unlock(&handle->fileDescriptor_mutex);
+
+    /* The acknowledgement follows every key which the server sent on the
+     * socket, and they've all been buffered by now. */
+    pthread_mutex_lock(&handle->read_mutex);
+    handle->sharedKeys = 1;
+    pthread_mutex_unlock(&handle->read_mutex);
+  } else {
+    pthread_mutex_lock(&handle->read_mutex);
+    handle->shared = NULL;
+    pthread_mutex_unlock(&handle->read_mutex);
+    munmap(shared, sizeof(*shared));
+  }
+  pthread_mutex_unlock(&handle->req_mutex);
+
+closeFile:
+  close(fd);
+  return res;
+#else /* BRLAPI_SHARED_MEMORY */
+  brlapi_errno = BRLAPI_ERROR_OPNOTSUPP;
+  return -1;
+#endif /* BRLAPI_SHARED_MEMORY */
+}
+
+int BRLAPI_STDCALL brlapi_enableSharedMemory(void)
+{
+  return brlapi__enableSharedMemory(&defaultHandle);
+}
+
 /* brlapi__pause */
 /* Wait for an event to be received */
 int BRLAPI_STDCALL brlapi__pause(brlapi_handle_t *handle, int timeout_ms) {
@@ -1089,10 +1372,25 @@ void BRLAPI_STDCALL brlapi__closeConnection(brlapi_handle_t *handle)
   pthread_mutex_lock(&handle->state_mutex);
   handle->state = 0;
   pthread_mutex_unlock(&handle->state_mutex);
+#ifdef BRLAPI_SHARED_MEMORY
+  /* readKey drains the key ring with only read_mutex locked */
+  pthread_mutex_lock(&handle->read_mutex);
+#endif /* BRLAPI_SHARED_MEMORY */
   pthread_mutex_lock(&handle->fileDescriptor_mutex);
   closeFileDescriptor(handle->fileDescriptor);
   handle->fileDescriptor = BRLAPI_INVALID_FILE_DESCRIPTOR;
+#ifdef BRLAPI_SHARED_MEMORY
+  if (handle->shared) {
+    munmap(handle->shared, sizeof(*handle->shared));
+    handle->shared = NULL;
+    handle->sharedWrites = 0;
+    handle->sharedKeys = 0;
+  }
+#endif /* BRLAPI_SHARED_MEMORY */
   pthread_mutex_unlock(&handle->fileDescriptor_mutex);
+#ifdef BRLAPI_SHARED_MEMORY
+  pthread_mutex_unlock(&handle->read_mutex);
+#endif /* BRLAPI_SHARED_MEMORY */
 
 #ifdef LC_GLOBAL_LOCALE
   if (handle->default_locale != LC_GLOBAL_LOCALE) {
@@ -1870,6 +2168,16 @@ static size_t getCharset(brlapi_handle_t *handle, void *buffer, int wide) {
   return p-start;
 }
 
+static int isUtf8Codeset(void)
+{
+#if !defined(WINDOWS) && defined(HAVE_NL_LANGINFO)
+  const char *codeset = nl_langinfo(CODESET);
+  return codeset && (!strcasecmp(codeset, "UTF-8") || !strcasecmp(codeset, "UTF8"));
+#else /* get codeset */
+  return 0;
+#endif /* get codeset */
+}
+
 /* Function : brlapi_writeText */
 /* Writes a string to the braille display */
 static int brlapi___writeText(brlapi_handle_t *handle, int cursor, const void *str, int wide)
@@ -1913,7 +2221,40 @@ static int brlapi___writeText(brlapi_handle_t *handle, int cursor, const void *s
 #endif /* __MINGW32__ */
     else
       len = strlen(str);
-    if (!wide && locale && strcmp(locale,"C")) {
+    if (!wide && locale && strcmp(locale,"C") && isUtf8Codeset()) {
+      const char *from = str;
+      size_t left = len;
+      unsigned int count = 0;
+      int ok = 1;
+
+      while (left && (count < dispSize)) {
+	wchar_t characters[0X100];
+	wchar_t *to = characters;
+	size_t room = MIN(sizeof(characters)/sizeof(*characters), dispSize-count);
+	const char *start = from;
+
+	ok = convertUtf8TextToWchars(&from, &left, &to, &room);
+	memcpy(p, start, from-start);
+	p += from-start;
+	count += to-characters;
+	if (!ok) break;
+      }
+
+      if (!ok) {
+	brlapi_libcerrno = EILSEQ;
+	brlapi_errfun = "convertUtf8TextToWchars";
+	brlapi_errno = BRLAPI_ERROR_LIBCERR;
+#ifdef LC_GLOBAL_LOCALE
+	if (handle->default_locale != LC_GLOBAL_LOCALE) {
+	  /* Restore application locale */
+	  uselocale(old_locale);
+	}
+#endif /* LC_GLOBAL_LOCALE */
+	return -1;
+      }
+      memset(p, ' ', dispSize-count);
+      p += dispSize-count;
+    } else if (!wide && locale && strcmp(locale,"C")) {
       mbstate_t ps;
       size_t eaten;
       unsigned i;
@@ -1976,9 +2317,7 @@ endcount:
   }
 
   wa->flags = htonl(wa->flags);
-  pthread_mutex_lock(&handle->fileDescriptor_mutex);
-  res = brlapi_writePacket(handle->fileDescriptor,BRLAPI_PACKET_WRITE,&packet,sizeof(wa->flags)+(p-&wa->data));
-  pthread_mutex_unlock(&handle->fileDescriptor_mutex);
+  res = brlapi__sendWritePacket(handle,&packet,sizeof(wa->flags)+(p-&wa->data));
 
 #ifdef LC_GLOBAL_LOCALE
   if (handle->default_locale != LC_GLOBAL_LOCALE) {
@@ -2208,9 +2547,7 @@ int brlapi__write(brlapi_handle_t *handle, const brlapi_writeArguments_t *s)
 
 send:
   wa->flags = htonl(wa->flags);
-  pthread_mutex_lock(&handle->fileDescriptor_mutex);
-  res = brlapi_writePacket(handle->fileDescriptor,BRLAPI_PACKET_WRITE,&packet,sizeof(wa->flags)+(p-&wa->data));
-  pthread_mutex_unlock(&handle->fileDescriptor_mutex);
+  res = brlapi__sendWritePacket(handle,&packet,sizeof(wa->flags)+(p-&wa->data));
   return res;
 }
 
@@ -2242,6 +2579,9 @@ int BRLAPI_STDCALL brlapi__readKeyWithTimeout(brlapi_handle_t *handle, int timeo
   pthread_mutex_unlock(&handle->state_mutex);
 
   pthread_mutex_lock(&handle->read_mutex);
+#ifdef BRLAPI_SHARED_MEMORY
+  if (handle->sharedKeys) brlapi__drainSharedKeys(handle);
+#endif /* BRLAPI_SHARED_MEMORY */
   if (handle->keybuf_nb>0) {
     *code=handle->keybuf[handle->keybuf_next];
     handle->keybuf_next=(handle->keybuf_next+1)%BRL_KEYBUF_SIZE;
@@ -45,6 +45,11 @@
 #define PF_LOCAL PF_UNIX
 #endif /* !defined(PF_LOCAL) && defined(PF_UNIX) */
 
+#if defined(HAVE_MEMFD_CREATE) && defined(SCM_RIGHTS) && defined(F_SEAL_SHRINK)
+#define BRLAPI_SHARED_MEMORY
+#include <sys/mman.h>
+#endif /* shared memory */
+
 #ifndef MIN
 #define MIN(a, b) (((a) < (b))? (a): (b))
 #endif /* MIN */
@@ -164,6 +169,9 @@ typedef struct {
 #ifdef __MINGW32__
   OVERLAPPED overl;
 #endif /* __MINGW32__ */
+#ifdef BRLAPI_SHARED_MEMORY
+  int descriptor; /* File descriptor passed along with the packet, or -1 */
+#endif /* BRLAPI_SHARED_MEMORY */
 } Packet;
 
 /* Function: brlapi_resetPacket */
@@ -196,10 +204,61 @@ static int brlapi_initializePacket(Packet *packet)
     return -1;
   }
 #endif /* __MINGW32__ */
+#ifdef BRLAPI_SHARED_MEMORY
+  packet->descriptor = -1;
+#endif /* BRLAPI_SHARED_MEMORY */
   brlapi_resetPacket(packet);
   return 0;
 }
 
+#ifdef BRLAPI_SHARED_MEMORY
+/* Function : brlapi_receiveData */
+/* Like read(), but also accepts a file descriptor passed with SCM_RIGHTS */
+static ssize_t brlapi_receiveData(Packet *packet, brlapi_fileDescriptor descriptor)
+{
+  struct iovec iov = {
+    .iov_base = packet->p,
+    .iov_len = packet->n
+  };
+
+  union {
+    struct cmsghdr header;
+    char buffer[CMSG_SPACE(sizeof(int))];
+  } control;
+
+  struct msghdr message = {
+    .msg_iov = &iov,
+    .msg_iovlen = 1,
+    .msg_control = &control,
+    .msg_controllen = sizeof(control)
+  };
+
+  ssize_t res = recvmsg(descriptor, &message, MSG_CMSG_CLOEXEC);
+
+  if (res == -1) {
+    if (errno == ENOTSOCK) return read(descriptor, packet->p, packet->n);
+    return -1;
+  }
+
+  {
+    struct cmsghdr *cmsg;
+
+    for (cmsg=CMSG_FIRSTHDR(&message); cmsg; cmsg=CMSG_NXTHDR(&message, cmsg)) {
+      if ((cmsg->cmsg_level == SOL_SOCKET) && (cmsg->cmsg_type == SCM_RIGHTS) &&
+          (cmsg->cmsg_len >= CMSG_LEN(sizeof(int)))) {
+        int fd;
+        memcpy(&fd, CMSG_DATA(cmsg), sizeof(fd));
+
+        if (packet->descriptor != -1) close(packet->descriptor);
+        packet->descriptor = fd;
+      }
+    }
+  }
+
+  return res;
+}
+#endif /* BRLAPI_SHARED_MEMORY */
+
 /* Function : readPacket */
 /* Reads a packet for the given connection */
 /* Returns -2 on EOF, -1 on error, 0 if the reading is not complete, */
@@ -222,7 +281,11 @@ read:
 #else /* __MINGW32__ */
   int res;
 read:
+#ifdef BRLAPI_SHARED_MEMORY
+  res = brlapi_receiveData(packet, descriptor);
+#else /* BRLAPI_SHARED_MEMORY */
   res = read(descriptor, packet->p, packet->n);
+#endif /* BRLAPI_SHARED_MEMORY */
   if (res==-1) {
     switch (errno) {
       case EINTR: goto read;
@@ -502,6 +565,8 @@ static const brlapi_packetTypeEntry_t brlapi_packetTypeTable[] = {
   { BRLAPI_PACKET_RESUMEDRIVER, "ResumeDriver" },
   { BRLAPI_PACKET_PARAM_VALUE, "ParameterValue" },
   { BRLAPI_PACKET_PARAM_REQUEST, "ParameterRequest" },
+  { BRLAPI_PACKET_SHAREDMEMORY, "SharedMemory" },
+  { BRLAPI_PACKET_SHAREDNOTIFY, "SharedNotify" },
   { BRLAPI_PACKET_ACK, "Ack" },
   { BRLAPI_PACKET_ERROR, "Error" },
   { BRLAPI_PACKET_EXCEPTION, "Exception" },
@@ -618,6 +683,12 @@ static const brlapi_param_properties_t brlapi_param_properties[BRLAPI_PARAM_COUN
     .count = 1,
   },
 
+  [BRLAPI_PARAM_CLIENT_STATISTICS] = {
+    .type = BRLAPI_PARAM_TYPE_UINT32,
+    .count = 4,
+    .isArray = 1,
+  },
+
 //Device Parameters
   [BRLAPI_PARAM_DRIVER_NAME] = {
     .type = BRLAPI_PARAM_TYPE_STRING,
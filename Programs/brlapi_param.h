@@ -37,6 +37,7 @@ typedef enum {
 //Connection Parameters
   BRLAPI_PARAM_SERVER_VERSION = 0,		/**< Version of the server: uint32_t */
   BRLAPI_PARAM_CLIENT_PRIORITY = 1,		/**< Priority of the client: uint32_t (from 0 through 100, default is 50) */
+  BRLAPI_PARAM_CLIENT_STATISTICS = 32,		/**< Window update statistics of the client: brlapi_param_clientStatistics_t */
 
 //Device Parameters
   BRLAPI_PARAM_DRIVER_NAME = 2,			/**< Full name of the driver: string */
@@ -100,7 +101,7 @@ typedef enum {
 
  /* TODO: help strings */
 
-  BRLAPI_PARAM_COUNT = 32 /** Number of parameters */
+  BRLAPI_PARAM_COUNT = 33 /** Number of parameters */
 } brlapi_param_t;
 
 /* brlapi_param_subparam_t */
@@ -128,6 +129,15 @@ typedef uint32_t brlapi_param_clientPriority_t;
  * output */
 #define BRLAPI_PARAM_CLIENT_PRIORITY_DISABLE 0
 
+/* brlapi_param_clientStatistics_t */
+/** Type to be used for BRLAPI_PARAM_CLIENT_STATISTICS */
+typedef struct {
+  uint32_t writes;	/**< Number of window writes received from the client */
+  uint32_t bytes;	/**< Number of bytes in those writes */
+  uint32_t cells;	/**< Number of cells updated by those writes */
+  uint32_t renders;	/**< Number of times the client's window was written to the device */
+} brlapi_param_clientStatistics_t;
+
 /* brlapi_param_driverName_t */
 /** Type to be used for BRLAPI_PARAM_DRIVER_NAME */
 typedef char *brlapi_param_driverName_t;
@@ -78,6 +78,8 @@ extern "C" {
 #define BRLAPI_PACKET_PARAM_VALUE     (('P'<<8) + 'V') /**< Parameter value  */
 #define BRLAPI_PACKET_PARAM_REQUEST   (('P'<<8) + 'R') /**< Parameter request*/
 #define BRLAPI_PACKET_PARAM_UPDATE    (('P'<<8) + 'U') /**< Parameter update */
+#define BRLAPI_PACKET_SHAREDMEMORY    (('S'<<8) + 'M') /**< Shared memory setup */
+#define BRLAPI_PACKET_SHAREDNOTIFY    (('S'<<8) + 'N') /**< Shared memory doorbell */
 
 /** Magic number to give when sending a BRLPACKET_ENTERRAWMODE or BRLPACKET_SUSPEND packet */
 #define BRLAPI_DEVICE_MAGIC (0xdeadbeefL)
@@ -166,6 +168,53 @@ typedef struct {
   uint32_t subparam_lo; /** Which sub-parameter being transmitted, lo 32bits */
 } brlapi_paramRequestPacket_t;
 
+/** Magic number at the start of a shared memory area */
+#define BRLAPI_SHARED_MAGIC 0X42534D31 /* BSM1 */
+
+/** Layout version of shared memory areas */
+#define BRLAPI_SHARED_VERSION 1
+
+/** Number of write packets which fit in the shared write ring */
+#define BRLAPI_SHARED_WRITES 32
+
+/** Number of key codes which fit in the shared key ring */
+#define BRLAPI_SHARED_KEYS 256
+
+/** Structure of a write packet in the shared write ring */
+typedef struct {
+  uint32_t size; /** Size of the packet, in bytes */
+  unsigned char data[BRLAPI_MAXPACKETSIZE]; /** Same content as a BRLAPI_PACKET_WRITE packet */
+} brlapi_sharedWrite_t;
+
+/** Structure of the shared memory area
+ *
+ * The client creates it, seals it against shrinking, and passes its file
+ * descriptor along with a BRLAPI_PACKET_SHAREDMEMORY packet over a local
+ * socket. Write packets then go from the client to the server through the
+ * write ring, and key codes from the server to the client through the key
+ * ring. Each ring has a single producer and a single consumer. Its head and
+ * tail are free-running counters, the slot being the counter modulo the ring
+ * size. After publishing a new tail, the producer sends a
+ * BRLAPI_PACKET_SHAREDNOTIFY packet only if the ring's notify-pending flag
+ * was clear, setting it. The consumer clears that flag before draining the
+ * ring. Fields are in host byte order since both ends are on the same host.
+ */
+typedef struct {
+  uint32_t magic; /** BRLAPI_SHARED_MAGIC */
+  uint32_t version; /** BRLAPI_SHARED_VERSION */
+
+  volatile uint32_t writeHead; /** Next write packet to be consumed by the server */
+  volatile uint32_t writeTail; /** Next write packet to be produced by the client */
+  volatile uint32_t writeNotifyPending; /** The server has yet to be notified */
+
+  volatile uint32_t keyHead; /** Next key code to be consumed by the client */
+  volatile uint32_t keyTail; /** Next key code to be produced by the server */
+  volatile uint32_t keyNotifyPending; /** The client has yet to be notified */
+
+  brlapi_keyCode_t keys[BRLAPI_SHARED_KEYS];
+  brlapi_sharedWrite_t writes[BRLAPI_SHARED_WRITES];
+} brlapi_sharedMemory_t;
+
 /** Type for packets.  Should be used instead of a mere char[], since it has
  * correct alignment requirements. */
 typedef union {
@@ -173,13 +173,27 @@ static brlapi_error_t brlapiserver_error;
 extern char *opt_brailleParameters;
 extern char *cfg_brailleParameters;
 
+/* The arrays share one allocation (text first for alignment). dots caches
+ * the translated text merged with the attributes (without the cursor), and
+ * only the cells in [dirtyFrom, dirtyTo) need to be recomputed. */
 typedef struct {
   unsigned int cursor;
   wchar_t *text;
   unsigned char *andAttr;
   unsigned char *orAttr;
+  unsigned char *dots;
+  unsigned int dirtyFrom;
+  unsigned int dirtyTo;
+  unsigned int tableGeneration;
 } BrailleWindow;
 
+typedef struct {
+  uint32_t writes; /* write requests */
+  uint32_t bytes; /* bytes in those requests */
+  uint32_t cells; /* cells they updated */
+  uint32_t renders; /* times the window was written to the device */
+} ClientStatistics;
+
 typedef enum { TODISPLAY, EMPTY } BrlBufState;
 
 typedef struct Subscription {
@@ -200,6 +214,7 @@ typedef struct Connection {
   unsigned int how; /* how keys must be delivered to clients */
   uint8_t retainDots; /* whether client wants dots instead of translating to chars */
   BrailleWindow brailleWindow;
+  ClientStatistics statistics;
   BrlBufState brlbufstate;
   pthread_mutex_t brailleWindowMutex;
   KeyrangeList *acceptedKeys;
@@ -207,6 +222,12 @@ typedef struct Connection {
   time_t upTime;
   Packet packet;
   struct Subscription subscriptions;
+#ifdef BRLAPI_SHARED_MEMORY
+  brlapi_sharedMemory_t *shared;
+  uint32_t sharedWriteHead; /* private copies of the indices we own */
+  uint32_t sharedKeyTail;
+  unsigned char sharedKeyOverflow; /* keys are sent on the socket again */
+#endif /* BRLAPI_SHARED_MEMORY */
 } Connection;
 
 typedef struct Tty {
@@ -321,6 +342,8 @@ static int driverConstructing; /* Whether device being constructed, protected by
 static wchar_t *coreWindowText; /* Last text written by the core */
 static unsigned char *coreWindowDots; /* Last dots written by the core */
 static int coreWindowCursor; /* Last cursor position set by the core */
+static unsigned char *displayedWindowDots; /* Last dots written to the driver */
+static unsigned char displayedWindowForce; /* Whether every row must be rewritten */
 pthread_mutex_t apiSuspendMutex; /* Protects use of driverConstructed state */
 
 static const char *auth = BRLAPI_DEFAUTH;
@@ -527,12 +550,50 @@ static void writeException(FileDescriptor fd, unsigned int err, brlapi_packetTyp
   brlapiserver_writePacket(fd,BRLAPI_PACKET_EXCEPTION,&epacket.data, hdrsize+esize);
 }
 
-static void writeKey(FileDescriptor fd, brlapi_keyCode_t key) {
+#ifdef BRLAPI_SHARED_MEMORY
+/* Function : writeSharedKey */
+/* Queues a key in the connection's key ring, notifying the client if needed */
+/* Returns 0 if the ring is full, in which case the key must go on the socket */
+/* Must be called with apiConnectionsMutex held */
+static int writeSharedKey(Connection *c, brlapi_keyCode_t key)
+{
+  brlapi_sharedMemory_t *shared = c->shared;
+
+  if ((uint32_t)(c->sharedKeyTail - shared->keyHead) >= BRLAPI_SHARED_KEYS) {
+    /* The client drains the ring before reading the socket, so later keys
+     * mustn't go back to the ring or they'd overtake this one. */
+    logMessage(LOG_WARNING, "key ring full, using the socket for fd %"PRIfd, c->fd);
+    c->sharedKeyOverflow = 1;
+    return 0;
+  }
+
+  shared->keys[c->sharedKeyTail % BRLAPI_SHARED_KEYS] = key;
+  __sync_synchronize();
+  shared->keyTail = ++c->sharedKeyTail;
+  __sync_synchronize();
+
+  if (!shared->keyNotifyPending) {
+    shared->keyNotifyPending = 1;
+    brlapiserver_writePacket(c->fd,BRLAPI_PACKET_SHAREDNOTIFY,NULL,0);
+  }
+
+  return 1;
+}
+#endif /* BRLAPI_SHARED_MEMORY */
+
+static void writeKey(Connection *c, brlapi_keyCode_t key) {
   uint32_t buf[2];
   buf[0] = htonl(key >> 32);
   buf[1] = htonl(key & 0xffffffff);
-  logMessage(LOG_CATEGORY(SERVER_EVENTS), "writing key %08"PRIx32" %08"PRIx32" to fd %"PRIfd,buf[0],buf[1],fd);
-  brlapiserver_writePacket(fd,BRLAPI_PACKET_KEY,&buf,sizeof(buf));
+  logMessage(LOG_CATEGORY(SERVER_EVENTS), "writing key %08"PRIx32" %08"PRIx32" to fd %"PRIfd,buf[0],buf[1],c->fd);
+
+#ifdef BRLAPI_SHARED_MEMORY
+  if (c->shared && !c->sharedKeyOverflow) {
+    if (writeSharedKey(c, key)) return;
+  }
+#endif /* BRLAPI_SHARED_MEMORY */
+
+  brlapiserver_writePacket(c->fd,BRLAPI_PACKET_KEY,&buf,sizeof(buf));
 }
 
 typedef int(*PacketHandler)(Connection *, brlapi_packetType_t, brlapi_packet_t *, size_t);
@@ -554,6 +615,8 @@ typedef struct { /* packet handlers */
   PacketHandler resumeDriver;
   PacketHandler parameterValue;
   PacketHandler parameterRequest;
+  PacketHandler sharedMemory;
+  PacketHandler sharedNotify;
 } PacketHandlers;
 
 /****************************************************************************/
@@ -566,24 +629,22 @@ typedef struct { /* packet handlers */
 /* Returns to report success, -1 on errors */
 static int allocBrailleWindow(BrailleWindow *brailleWindow)
 {
-  if (!(brailleWindow->text = malloc(displaySize*sizeof(wchar_t)))) goto out;
-  if (!(brailleWindow->andAttr = malloc(displaySize))) goto outText;
-  if (!(brailleWindow->orAttr = malloc(displaySize))) goto outAnd;
+  unsigned char *cells;
+
+  if (!(brailleWindow->text = malloc(displaySize * (sizeof(wchar_t) + 3)))) return -1;
+  cells = (unsigned char *)(brailleWindow->text + displaySize);
+  brailleWindow->andAttr = cells;
+  brailleWindow->orAttr = cells + displaySize;
+  brailleWindow->dots = cells + (displaySize * 2);
 
   wmemset(brailleWindow->text, WC_C(' '), displaySize);
   memset(brailleWindow->andAttr, 0xFF, displaySize);
   memset(brailleWindow->orAttr, 0x00, displaySize);
   brailleWindow->cursor = 0;
+  brailleWindow->dirtyFrom = 0;
+  brailleWindow->dirtyTo = displaySize;
+  brailleWindow->tableGeneration = getTextTableGeneration();
   return 0;
-
-outAnd:
-  free(brailleWindow->andAttr);
-
-outText:
-  free(brailleWindow->text);
-
-out:
-  return -1;
 }
 
 /* Function: freeBrailleWindow */
@@ -591,8 +652,24 @@ out:
 static void freeBrailleWindow(BrailleWindow *brailleWindow)
 {
   free(brailleWindow->text); brailleWindow->text = NULL;
-  free(brailleWindow->andAttr); brailleWindow->andAttr = NULL;
-  free(brailleWindow->orAttr); brailleWindow->orAttr = NULL;
+  brailleWindow->andAttr = NULL;
+  brailleWindow->orAttr = NULL;
+  brailleWindow->dots = NULL;
+}
+
+/* Function: markBrailleWindow */
+/* Notes that the dots of some cells of a BrailleWindow need to be recomputed */
+static void markBrailleWindow(BrailleWindow *brailleWindow, unsigned int from, unsigned int count)
+{
+  unsigned int to = from + count;
+
+  if (brailleWindow->dirtyFrom == brailleWindow->dirtyTo) {
+    brailleWindow->dirtyFrom = from;
+    brailleWindow->dirtyTo = to;
+  } else {
+    if (from < brailleWindow->dirtyFrom) brailleWindow->dirtyFrom = from;
+    if (to > brailleWindow->dirtyTo) brailleWindow->dirtyTo = to;
+  }
 }
 
 static unsigned char
@@ -609,18 +686,37 @@ getCursorOverlay (BrailleDisplay *brl) {
   return 0;
 }
 
+static void mergeAttributes(unsigned char *restrict dots, const unsigned char *restrict andAttr, const unsigned char *restrict orAttr, unsigned int count)
+{
+  for (unsigned int i=0; i<count; i+=1) {
+    dots[i] = (dots[i] & andAttr[i]) | orAttr[i];
+  }
+}
+
 /* Function: getDots */
 /* Returns the braille dots corresponding to a BrailleWindow structure */
+/* Only the cells written since the last call are translated again */
 /* No allocation of buf is performed */
-static void getDots(const BrailleWindow *brailleWindow, unsigned char *buf)
+static void getDots(BrailleWindow *brailleWindow, unsigned char *buf)
 {
-  int i;
-  unsigned char c;
-  for (i=0; i<displaySize; i++) {
-    c = convertCharacterToDots(textTable, brailleWindow->text[i]);
-    buf[i] = (c & brailleWindow->andAttr[i]) | brailleWindow->orAttr[i];
+  unsigned int generation = getTextTableGeneration();
+
+  if (brailleWindow->tableGeneration != generation) {
+    brailleWindow->tableGeneration = generation;
+    markBrailleWindow(brailleWindow, 0, displaySize);
+  }
+
+  if (brailleWindow->dirtyFrom < brailleWindow->dirtyTo) {
+    unsigned int from = brailleWindow->dirtyFrom;
+    unsigned int count = brailleWindow->dirtyTo - from;
+
+    convertCharactersToDots(textTable, &brailleWindow->text[from], &brailleWindow->dots[from], count);
+    mergeAttributes(&brailleWindow->dots[from], &brailleWindow->andAttr[from], &brailleWindow->orAttr[from], count);
+    brailleWindow->dirtyFrom = brailleWindow->dirtyTo = 0;
   }
 
+  memcpy(buf, brailleWindow->dots, displaySize);
+
   if (brailleWindow->cursor) {
     buf[brailleWindow->cursor-1] |= cursorOverlay;
   }
@@ -665,6 +761,12 @@ static Connection *createConnection(FileDescriptor fd, time_t currentTime)
   c->brailleWindow.text = NULL;
   c->brailleWindow.andAttr = NULL;
   c->brailleWindow.orAttr = NULL;
+  c->brailleWindow.dots = NULL;
+  memset(&c->statistics, 0, sizeof(c->statistics));
+#ifdef BRLAPI_SHARED_MEMORY
+  c->shared = NULL;
+  c->sharedKeyOverflow = 0;
+#endif /* BRLAPI_SHARED_MEMORY */
   if (brlapi_initializePacket(&c->packet))
     goto outmalloc;
   c->subscriptions.next = &c->subscriptions;
@@ -711,6 +813,10 @@ static void freeConnection(Connection *c)
 
   freeBrailleWindow(&c->brailleWindow);
   freeKeyrangeList(&c->acceptedKeys);
+#ifdef BRLAPI_SHARED_MEMORY
+  if (c->shared) munmap(c->shared, sizeof(*c->shared));
+  if (c->packet.descriptor != -1) close(c->packet.descriptor);
+#endif /* BRLAPI_SHARED_MEMORY */
   free(c);
 }
 
@@ -1048,19 +1154,16 @@ convertFromUTF8 (Connection *c, wchar_t *outBuff, size_t *outLeft, const char *i
   wchar_t *out = outBuff;
   const char *in = inBuff;
 
-  while ((*outLeft > 0) && (*inLeft > 0)) {
-    wint_t wc = convertUtf8ToWchar(&in, inLeft);
-    if (wc == WEOF) return 0;
-
-    *out++ = wc;
-    *outLeft -= 1;
-  }
+  if (!convertUtf8TextToWchars(&in, inLeft, &out, outLeft)) return 0;
 
   logConversionResult(c, (out - outBuff), (in - inBuff));
   return 1;
 }
 
-static int handleWrite(Connection *c, brlapi_packetType_t type, brlapi_packet_t *packet, size_t size)
+/* Function : applyWrite */
+/* Updates the braille window of the connection according to a write packet */
+/* Returns 1 if the window needs to be flushed to the display */
+static int applyWrite(Connection *c, brlapi_packetType_t type, brlapi_packet_t *packet, size_t size)
 {
   brlapi_writeArgumentsPacket_t *wa = &packet->writeArguments;
   unsigned char *text = NULL, *orAttr = NULL, *andAttr = NULL;
@@ -1146,6 +1249,7 @@ static int handleWrite(Connection *c, brlapi_packetType_t type, brlapi_packet_t
   if (text) {
     int isUTF8 = 0;
     int isLatin1 = 0;
+    int isWchar = 0;
 
 #ifndef HAVE_ALLOCA_H
     char charsetBuffer[0X20];
@@ -1182,6 +1286,8 @@ static int handleWrite(Connection *c, brlapi_packetType_t type, brlapi_packet_t
         isUTF8 = 1;
       } else if (isCharsetLatin1(charset)) {
         isLatin1 = 1;
+      } else if (isCharsetWchar(charset)) {
+        isWchar = 1;
       } else {
 #ifndef HAVE_ICONV_H
         CHECKEXC(0, BRLAPI_ERROR_OPNOTSUPP, "charset conversion not supported (enable iconv?)");
@@ -1212,6 +1318,22 @@ static int handleWrite(Connection *c, brlapi_packetType_t type, brlapi_packet_t
       logConversionDecision(c, "ISO_8859-1", "internal conversion");
       lockMutex(&c->brailleWindowMutex);
       convertFromLatin1(c, rbeg, rsiz, text, textLen);
+    } else if (isWchar) {
+      logConversionDecision(c, charset, "internal conversion");
+
+      wchar_t textBuf[rsiz];
+      CHECKEXC(!(textLen % sizeof(textBuf[0])), BRLAPI_ERROR_INVALID_PACKET, "invalid charset conversion");
+      CHECKEXC((textLen <= sizeof(textBuf)), BRLAPI_ERROR_INVALID_PACKET, "text too big");
+      CHECKEXC((textLen >= sizeof(textBuf)), BRLAPI_ERROR_INVALID_PACKET, "text too small");
+      memcpy(textBuf, text, sizeof(textBuf));
+
+      for (unsigned int i=0; i<rsiz; i+=1) {
+        CHECKEXC(((uint32_t)textBuf[i] <= 0X7FFFFFFF), BRLAPI_ERROR_INVALID_PACKET, "invalid charset conversion");
+      }
+
+      logConversionResult(c, rsiz, textLen);
+      lockMutex(&c->brailleWindowMutex);
+      wmemcpy(c->brailleWindow.text+rbeg-1, textBuf, rsiz);
     }
 
 #ifdef HAVE_ICONV_H
@@ -1257,10 +1379,20 @@ static int handleWrite(Connection *c, brlapi_packetType_t type, brlapi_packet_t
   if (andAttr) memcpy(c->brailleWindow.andAttr+rbeg-1,andAttr,rsiz);
   if (orAttr) memcpy(c->brailleWindow.orAttr+rbeg-1,orAttr,rsiz);
   if (cursor >= 0) c->brailleWindow.cursor = cursor;
+  if (text || andAttr || orAttr) markBrailleWindow(&c->brailleWindow, rbeg-1, rsiz);
+
+  c->statistics.writes += 1;
+  c->statistics.bytes += size;
+  if (text || andAttr || orAttr) c->statistics.cells += rsiz;
 
   c->brlbufstate = TODISPLAY;
   unlockMutex(&c->brailleWindowMutex);
-  flushOutput();
+  return 1;
+}
+
+static int handleWrite(Connection *c, brlapi_packetType_t type, brlapi_packet_t *packet, size_t size)
+{
+  if (applyWrite(c, type, packet, size)) flushOutput();
   return 0;
 }
 
@@ -1433,6 +1565,22 @@ PARAM_WRITER(clientPriority)
   return NULL;
 }
 
+/* BRLAPI_PARAM_CLIENT_STATISTICS */
+PARAM_READER(clientStatistics)
+{
+  brlapi_param_clientStatistics_t *clientStatistics = data;
+  *size = sizeof(*clientStatistics);
+
+  lockMutex(&c->brailleWindowMutex);
+    clientStatistics->writes = c->statistics.writes;
+    clientStatistics->bytes = c->statistics.bytes;
+    clientStatistics->cells = c->statistics.cells;
+    clientStatistics->renders = c->statistics.renders;
+  unlockMutex(&c->brailleWindowMutex);
+
+  return NULL;
+}
+
 /* BRLAPI_PARAM_DRIVER_NAME */
 PARAM_READER(driverName)
 {
@@ -1691,8 +1839,9 @@ PARAM_WRITER(cursorBlinkPercentage)
 /* BRLAPI_PARAM_RENDERED_CELLS */
 PARAM_READER(renderedCells)
 {
+  lockMutex(&c->brailleWindowMutex);
   lockMutex(&apiDriverMutex);
-    if (disp) {
+    if (disp && c->brailleWindow.text) {
       unsigned char buffer[displaySize];
       getDots(&c->brailleWindow, buffer);
 
@@ -1702,6 +1851,7 @@ PARAM_READER(renderedCells)
       *size = 0;
     }
   unlockMutex(&apiDriverMutex);
+  unlockMutex(&c->brailleWindowMutex);
 
   return NULL;
 }
@@ -2009,6 +2159,11 @@ static const ParamDispatch paramDispatch[BRLAPI_PARAM_COUNT] = {
     .write = param_clientPriority_write,
   },
 
+  [BRLAPI_PARAM_CLIENT_STATISTICS] = {
+    .local = 1,
+    .read = param_clientStatistics_read,
+  },
+
 //Device Parameters
   [BRLAPI_PARAM_DRIVER_NAME] = {
     .global = 1,
@@ -2477,6 +2632,97 @@ static int handleParamRequest(Connection *c, brlapi_packetType_t type, brlapi_pa
   return 0;
 }
 
+static int handleSharedMemory(Connection *c, brlapi_packetType_t type, brlapi_packet_t *packet, size_t size)
+{
+#ifdef BRLAPI_SHARED_MEMORY
+  int fd = c->packet.descriptor;
+  brlapi_sharedMemory_t *shared;
+  struct stat status;
+  int seals;
+
+  CHECKERR(size==0,BRLAPI_ERROR_INVALID_PACKET,"packet should be empty");
+  CHECKERR(!c->shared,BRLAPI_ERROR_ILLEGAL_INSTRUCTION,"shared memory already set up");
+  CHECKERR(fd!=-1,BRLAPI_ERROR_INVALID_PACKET,"no file descriptor passed");
+
+  /* The client mustn't be able to shrink it underneath our mapping */
+  seals = fcntl(fd, F_GET_SEALS);
+  CHECKERR((seals!=-1) && (seals & F_SEAL_SHRINK),BRLAPI_ERROR_INVALID_PARAMETER,"shared memory not sealed against shrinking");
+  CHECKERR((fstat(fd, &status)!=-1) && (status.st_size>=sizeof(*shared)),BRLAPI_ERROR_INVALID_PARAMETER,"shared memory too small");
+
+  shared = mmap(NULL, sizeof(*shared), PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+  CHECKERR(shared!=MAP_FAILED,BRLAPI_ERROR_NOMEM,"mmap: %s", strerror(errno));
+
+  if ((shared->magic != BRLAPI_SHARED_MAGIC) || (shared->version != BRLAPI_SHARED_VERSION)) {
+    munmap(shared, sizeof(*shared));
+    WERR(c->fd, BRLAPI_ERROR_INVALID_PARAMETER, "unsupported shared memory layout");
+    return 0;
+  }
+
+  lockMutex(&apiConnectionsMutex);
+  c->sharedWriteHead = shared->writeHead;
+  c->sharedKeyTail = shared->keyTail;
+  c->shared = shared;
+  unlockMutex(&apiConnectionsMutex);
+
+  logMessage(LOG_CATEGORY(SERVER_EVENTS), "shared memory set up on fd %"PRIfd, c->fd);
+  writeAck(c->fd);
+#else /* BRLAPI_SHARED_MEMORY */
+  CHECKERR(0,BRLAPI_ERROR_OPNOTSUPP,"shared memory not supported");
+#endif /* BRLAPI_SHARED_MEMORY */
+  return 0;
+}
+
+static int handleSharedNotify(Connection *c, brlapi_packetType_t type, brlapi_packet_t *packet, size_t size)
+{
+#ifdef BRLAPI_SHARED_MEMORY
+  brlapi_sharedMemory_t *shared = c->shared;
+  int flush = 0;
+
+  CHECKERR(shared,BRLAPI_ERROR_ILLEGAL_INSTRUCTION,"shared memory not set up");
+  shared->writeNotifyPending = 0;
+  __sync_synchronize();
+
+  while (1) {
+    /* The ring belongs to the client too, so don't trust anything in it */
+    uint32_t tail = shared->writeTail;
+    uint32_t length;
+    brlapi_packet_t request;
+
+    if (tail == c->sharedWriteHead) break;
+
+    if ((uint32_t)(tail - c->sharedWriteHead) > BRLAPI_SHARED_WRITES) {
+      c->sharedWriteHead = shared->writeHead = tail;
+      WERR(c->fd, BRLAPI_ERROR_INVALID_PACKET, "shared write ring indices corrupted");
+      break;
+    }
+
+    __sync_synchronize();
+
+    {
+      const brlapi_sharedWrite_t *slot = &shared->writes[c->sharedWriteHead % BRLAPI_SHARED_WRITES];
+
+      length = slot->size;
+      if (length <= sizeof(request.data)) memcpy(request.data, slot->data, length);
+    }
+
+    __sync_synchronize();
+    shared->writeHead = ++c->sharedWriteHead;
+
+    if (length > sizeof(request.data)) {
+      WERR(c->fd, BRLAPI_ERROR_INVALID_PACKET, "shared write too large: %"PRIu32, length);
+      continue;
+    }
+
+    if (applyWrite(c, BRLAPI_PACKET_WRITE, &request, length)) flush = 1;
+  }
+
+  if (flush) flushOutput();
+#else /* BRLAPI_SHARED_MEMORY */
+  CHECKERR(0,BRLAPI_ERROR_OPNOTSUPP,"shared memory not supported");
+#endif /* BRLAPI_SHARED_MEMORY */
+  return 0;
+}
+
 static PacketHandlers packetHandlers = {
   handleGetDriverName, handleGetModelIdentifier, handleGetDisplaySize,
   handleEnterTtyMode, handleSetFocus, handleLeaveTtyMode,
@@ -2484,6 +2730,7 @@ static PacketHandlers packetHandlers = {
   handleEnterRawMode, handleLeaveRawMode, handlePacket,
   handleSuspendDriver, handleResumeDriver,
   handleParamValue, handleParamRequest,
+  handleSharedMemory, handleSharedNotify,
 };
 
 static void handleNewConnection(Connection *c)
@@ -2654,11 +2901,15 @@ static int processRequest(Connection *c, PacketHandlers *handlers)
   size = c->packet.header.size;
   type = c->packet.header.type;
 
-  if (c->auth!=1) return handleUnauthorizedConnection(c, type, packet, size);
+  if (c->auth!=1) {
+    res = handleUnauthorizedConnection(c, type, packet, size);
+    goto done;
+  }
 
   if (size>BRLAPI_MAXPACKETSIZE) {
     logMessage(LOG_WARNING, "Discarding too large packet of type %s on fd %"PRIfd,brlapiserver_getPacketTypeName(type), c->fd);
-    return 0;
+    res = 0;
+    goto done;
   }
   switch (type) {
     case BRLAPI_PACKET_GETDRIVERNAME: p = handlers->getDriverName; break;
@@ -2677,6 +2928,8 @@ static int processRequest(Connection *c, PacketHandlers *handlers)
     case BRLAPI_PACKET_RESUMEDRIVER: p = handlers->resumeDriver; break;
     case BRLAPI_PACKET_PARAM_VALUE: p = handlers->parameterValue; break;
     case BRLAPI_PACKET_PARAM_REQUEST: p = handlers->parameterRequest; break;
+    case BRLAPI_PACKET_SHAREDMEMORY: p = handlers->sharedMemory; break;
+    case BRLAPI_PACKET_SHAREDNOTIFY: p = handlers->sharedNotify; break;
   }
   if (p!=NULL) {
     logRequest(type, c->fd);
@@ -2684,7 +2937,17 @@ static int processRequest(Connection *c, PacketHandlers *handlers)
   } else {
     WEXC(c->fd,BRLAPI_ERROR_UNKNOWN_INSTRUCTION, type, packet, size, "unknown packet type %x", type);
   }
-  return 0;
+  res = 0;
+
+done:
+#ifdef BRLAPI_SHARED_MEMORY
+  /* Don't leak a file descriptor which the handler didn't want */
+  if (c->packet.descriptor != -1) {
+    close(c->packet.descriptor);
+    c->packet.descriptor = -1;
+  }
+#endif /* BRLAPI_SHARED_MEMORY */
+  return res;
 }
 
 /****************************************************************************/
@@ -3998,6 +4261,24 @@ static inline void setCurrentRootTty(void) {
   ttys.focus = currentVirtualTerminal();
 }
 
+/* Function : writeDisplayedWindow */
+/* Writes brl->buffer to the true driver. Drivers which accept row updates are */
+/* told which rows differ from what was last displayed, be it core or client output */
+static int writeDisplayedWindow(BrailleDisplay *brl, const wchar_t *text)
+{
+  if (trueBraille->writeWindowRows && displayedWindowDots) {
+    unsigned char changedRows[brl->textRows];
+
+    cellRowsHaveChanged(displayedWindowDots, brl->buffer,
+                        brl->textColumns, brl->textRows,
+                        changedRows, &displayedWindowForce);
+
+    return trueBraille->writeWindowRows(brl, text, changedRows);
+  }
+
+  return trueBraille->writeWindow(brl, text);
+}
+
 /* Function : api_writeWindow */
 static int api_writeWindow(BrailleDisplay *brl, const wchar_t *text)
 {
@@ -4013,7 +4294,7 @@ static int api_writeWindow(BrailleDisplay *brl, const wchar_t *text)
   lockMutex(&apiRawMutex);
   if (!offline && !suspendConnection && !rawConnection && !whoFillsTty(&ttys)) {
     lockMutex(&apiDriverMutex);
-    if (!trueBraille->writeWindow(brl, text)) ok = 0;
+    if (!writeDisplayedWindow(brl, text)) ok = 0;
     unlockMutex(&apiDriverMutex);
   }
   unlockMutex(&apiRawMutex);
@@ -4053,7 +4334,7 @@ static void broadcastKey(Tty *tty, brlapi_keyCode_t code, unsigned int how) {
   for (c=tty->connections->next; c!=tty->connections; c = c->next) {
     lockMutex(&c->acceptedKeysMutex);
     if ((c->how==how) && (inKeyrangeList(c->acceptedKeys,code) != NULL))
-      writeKey(c->fd,code);
+      writeKey(c,code);
     unlockMutex(&c->acceptedKeysMutex);
   }
   for (t = tty->subttys; t; t = t->next)
@@ -4071,7 +4352,7 @@ static int api__handleKeyEvent(brlapi_keyCode_t clientCode) {
   /* somebody gets the raw code */
   if ((c = whoGetsKey(&ttys, clientCode, BRL_KEYCODES, 0))) {
     logMessage(LOG_CATEGORY(SERVER_EVENTS), "transmitting accepted key %016"BRLAPI_PRIxKEYCODE" to fd %"PRIfd,clientCode,c->fd);
-    writeKey(c->fd,clientCode);
+    writeKey(c,clientCode);
     return 1;
   }
   return 0;
@@ -4128,7 +4409,7 @@ static int api__handleCommand(int command) {
 
     if (c) {
       logMessage(LOG_CATEGORY(SERVER_EVENTS), "transmitting accepted command %lx as client code %016"BRLAPI_PRIxKEYCODE" to fd %"PRIfd,(unsigned long)command,code,c->fd);
-      writeKey(c->fd, code);
+      writeKey(c, code);
       return 1;
     }
   }
@@ -4231,7 +4512,8 @@ int api_flushOutput(BrailleDisplay *brl) {
       disp->buffer = buf;
       getDots(&c->brailleWindow, buf);
       brl->cursor = c->brailleWindow.cursor-1;
-      if (!trueBraille->writeWindow(brl, c->brailleWindow.text)) ok = 0;
+      if (!writeDisplayedWindow(brl, c->brailleWindow.text)) ok = 0;
+      c->statistics.renders += 1;
       /* FIXME: the client should have gotten the notification when the write
        * was received, rather than only when it eventually gets displayed
        * (possibly only because of focus change) */
@@ -4251,7 +4533,7 @@ int api_flushOutput(BrailleDisplay *brl) {
 	unsigned char *oldbuf = disp->buffer;
 	disp->buffer = coreWindowDots;
 	brl->cursor = coreWindowCursor;
-	if (!trueBraille->writeWindow(brl, coreWindowText)) ok = 0;
+	if (!writeDisplayedWindow(brl, coreWindowText)) ok = 0;
 	disp->buffer = oldbuf;
 	suspendBrailleDriver();
       }
@@ -4313,6 +4595,8 @@ static void brlResize(BrailleDisplay *brl)
   displaySize = brl->textColumns * brl->textRows;
   coreWindowText = realloc(coreWindowText, displaySize * sizeof(*coreWindowText));
   coreWindowDots = realloc(coreWindowDots, displaySize * sizeof(*coreWindowDots));
+  displayedWindowDots = realloc(displayedWindowDots, displaySize * sizeof(*displayedWindowDots));
+  displayedWindowForce = 1;
   coreWindowCursor = 0;
   handleParamUpdate(NULL, NULL, BRLAPI_PARAM_DISPLAY_SIZE, 0, BRLAPI_PARAMF_GLOBAL, displayDimensions, sizeof(displayDimensions));
 }
@@ -4336,6 +4620,7 @@ void api_linkServer(BrailleDisplay *brl)
   trueBraille=braille;
   memcpy(&ApiBraille,braille,sizeof(BrailleDriver));
   ApiBraille.writeWindow=api_writeWindow;
+  ApiBraille.writeWindowRows = NULL; /* row changes are tracked by writeDisplayedWindow */
   ApiBraille.readCommand=api_readCommand;
   ApiBraille.readPacket = NULL;
   ApiBraille.writePacket = NULL;
@@ -4364,6 +4649,8 @@ void api_unlinkServer(BrailleDisplay *brl)
   coreWindowText = NULL;
   free(coreWindowDots);
   coreWindowDots = NULL;
+  free(displayedWindowDots);
+  displayedWindowDots = NULL;
   braille=trueBraille;
   trueBraille=&noBraille;
   lockMutex(&apiDriverMutex);
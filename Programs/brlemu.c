@@ -0,0 +1,251 @@
+/*
+ * BRLTTY - A background process providing access to the console screen (when in
+ *          text mode) for a blind person using a refreshable braille display.
+ *
+ * Copyright (C) 1995-2021 by The BRLTTY Developers.
+ *
+ * BRLTTY comes with ABSOLUTELY NO WARRANTY.
+ *
+ * This is free software, placed under the terms of the
+ * GNU Lesser General Public License, as published by the Free Software
+ * Foundation; either version 2.1 of the License, or (at your option) any
+ * later version. Please see the file LICENSE-LGPL for details.
+ *
+ * Web Page: http://brltty.app/
+ *
+ * This software is maintained by Dave Mielke <dave@mielke.cc>.
+ */
+
+#include "prologue.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "log.h"
+#include "program.h"
+#include "options.h"
+#include "parse.h"
+#include "timing.h"
+#include "async_alarm.h"
+#include "async_wait.h"
+#include "emulator.h"
+
+static char *opt_protocol;
+static char *opt_actionRate;
+static char *opt_routingRate;
+static char *opt_duration;
+static char *opt_connectTimeout;
+
+BEGIN_OPTION_TABLE(programOptions)
+  { .word = "protocol",
+    .letter = 'p',
+    .argument = "name",
+    .setting.string = &opt_protocol,
+    .internal.setting = "baum",
+    .description = "the device protocol to emulate (baum, handytech, alva)"
+  },
+
+  { .word = "action-rate",
+    .letter = 'a',
+    .argument = "count",
+    .setting.string = &opt_actionRate,
+    .internal.setting = "2",
+    .description = "action keys (bound to HELP) sent per second"
+  },
+
+  { .word = "routing-rate",
+    .letter = 'r',
+    .argument = "count",
+    .setting.string = &opt_routingRate,
+    .internal.setting = "0",
+    .description = "routing keys sent per second"
+  },
+
+  { .word = "duration",
+    .letter = 'd',
+    .argument = "seconds",
+    .setting.string = &opt_duration,
+    .internal.setting = "10",
+    .description = "how long to measure once the driver has connected"
+  },
+
+  { .word = "connect-timeout",
+    .letter = 't',
+    .argument = "seconds",
+    .setting.string = &opt_connectTimeout,
+    .internal.setting = "60",
+    .description = "how long to wait for the driver to connect"
+  },
+END_OPTION_TABLE
+
+typedef struct {
+  Emulator *emulator;
+  TimePeriod period;
+  unsigned int routingKey;
+} EmulatorSession;
+
+ASYNC_CONDITION_TESTER(testEmulatorConnected) {
+  EmulatorSession *session = data;
+
+  if (isEmulatorConnected(session->emulator)) return 1;
+  return afterTimePeriod(&session->period, NULL);
+}
+
+ASYNC_CONDITION_TESTER(testMeasurementFinished) {
+  EmulatorSession *session = data;
+
+  return afterTimePeriod(&session->period, NULL);
+}
+
+ASYNC_ALARM_CALLBACK(sendActionKey) {
+  EmulatorSession *session = parameters->data;
+
+  sendEmulatorActionKey(session->emulator);
+}
+
+ASYNC_ALARM_CALLBACK(sendRoutingKey) {
+  EmulatorSession *session = parameters->data;
+
+  sendEmulatorRoutingKey(session->emulator, session->routingKey++);
+}
+
+static int
+startTraffic (AsyncHandle *alarm, int rate, AsyncAlarmCallback *callback, EmulatorSession *session) {
+  *alarm = NULL;
+  if (!rate) return 1;
+
+  {
+    int interval = MSECS_PER_SEC / rate;
+
+    if (!interval) interval = 1;
+    if (!asyncNewRelativeAlarm(alarm, interval, callback, session)) return 0;
+    if (asyncResetAlarmInterval(*alarm, interval)) return 1;
+
+    asyncCancelRequest(*alarm);
+    *alarm = NULL;
+  }
+
+  return 0;
+}
+
+static void
+stopTraffic (AsyncHandle alarm) {
+  if (alarm) asyncCancelRequest(alarm);
+}
+
+static void
+showStatistics (const Emulator *emulator, long int milliseconds) {
+  EmulatorStatistics statistics;
+  getEmulatorStatistics(emulator, &statistics);
+
+  if (!milliseconds) milliseconds = 1;
+
+  printf("cell updates: %lu (%.1f/s), cells changed: %lu\n",
+         statistics.cellUpdates,
+         (double)statistics.cellUpdates * MSECS_PER_SEC / milliseconds,
+         statistics.cellsChanged);
+
+  printf("bytes received: %lu (%.1f/update), bytes sent: %lu\n",
+         statistics.bytesReceived,
+         statistics.cellUpdates? ((double)statistics.bytesReceived / statistics.cellUpdates): 0.0,
+         statistics.bytesSent);
+
+  printf("keys sent: %lu action, %lu routing\n",
+         statistics.actionKeys, statistics.routingKeys);
+
+  if (statistics.latencyCount) {
+    printf("key-to-update latency: %.3fms mean, %.3fms maximum (%lu samples)\n",
+           (double)statistics.latencyTotal / statistics.latencyCount / USECS_PER_MSEC,
+           (double)statistics.latencyMaximum / USECS_PER_MSEC,
+           statistics.latencyCount);
+  } else {
+    printf("key-to-update latency: no samples\n");
+  }
+}
+
+int
+main (int argc, char *argv[]) {
+  int actionRate = 0;
+  int routingRate = 0;
+  int duration = 0;
+  int connectTimeout = 0;
+
+  {
+    static const OptionsDescriptor descriptor = {
+      OPTION_TABLE(programOptions),
+      .applicationName = "brlemu",
+      .argumentsSummary = ""
+    };
+
+    PROCESS_OPTIONS(descriptor, argc, argv);
+  }
+
+  {
+    typedef struct {
+      int *value;
+      const char *setting;
+      const char *name;
+      int minimum;
+    } IntegerOption;
+
+    const IntegerOption options[] = {
+      { .value = &actionRate, .setting = opt_actionRate, .name = "action rate", .minimum = 0 },
+      { .value = &routingRate, .setting = opt_routingRate, .name = "routing rate", .minimum = 0 },
+      { .value = &duration, .setting = opt_duration, .name = "duration", .minimum = 1 },
+      { .value = &connectTimeout, .setting = opt_connectTimeout, .name = "connect timeout", .minimum = 1 },
+    };
+
+    for (unsigned int index=0; index<ARRAY_COUNT(options); index+=1) {
+      const IntegerOption *option = &options[index];
+
+      if (!validateInteger(option->value, option->setting, &option->minimum, NULL)) {
+        logMessage(LOG_ERR, "invalid %s: %s", option->name, option->setting);
+        return PROG_EXIT_SYNTAX;
+      }
+    }
+  }
+
+  {
+    EmulatorSession session = {
+      .routingKey = 0
+    };
+
+    if (!(session.emulator = newEmulator(opt_protocol))) return PROG_EXIT_FATAL;
+
+    printf("emulating %s (%u cells): brltty -b %s -d serial:%s\n",
+           opt_protocol, getEmulatorCellCount(session.emulator),
+           getEmulatorDriver(session.emulator),
+           getEmulatorDevice(session.emulator));
+    fflush(stdout);
+
+    startTimePeriod(&session.period, (connectTimeout * MSECS_PER_SEC));
+    asyncWaitFor(testEmulatorConnected, &session);
+
+    if (isEmulatorConnected(session.emulator)) {
+      AsyncHandle actionAlarm;
+      AsyncHandle routingAlarm;
+      TimeValue start;
+
+      resetEmulatorStatistics(session.emulator);
+      getMonotonicTime(&start);
+      startTimePeriod(&session.period, (duration * MSECS_PER_SEC));
+
+      if (startTraffic(&actionAlarm, actionRate, sendActionKey, &session)) {
+        if (startTraffic(&routingAlarm, routingRate, sendRoutingKey, &session)) {
+          asyncWaitFor(testMeasurementFinished, &session);
+          stopTraffic(routingAlarm);
+        }
+
+        stopTraffic(actionAlarm);
+      }
+
+      showStatistics(session.emulator, getMonotonicElapsed(&start));
+    } else {
+      logMessage(LOG_ERR, "driver didn't connect");
+    }
+
+    destroyEmulator(session.emulator);
+  }
+
+  return PROG_EXIT_SUCCESS;
+}
@@ -32,8 +32,16 @@
 #define DEFAULT_OUTPUT_FORMAT "%s\\t%n\\n"
 
 static char *opt_outputFormat;
+static char *opt_indexFile;
 
 BEGIN_OPTION_TABLE(programOptions)
+  { .word = "index-file",
+    .letter = 'i',
+    .argument = strtext("file"),
+    .setting.string = &opt_indexFile,
+    .description = strtext("Write a binary annotations index rather than the annotations.")
+  },
+
   { .word = "output-format",
     .letter = 'f',
     .argument = strtext("string"),
@@ -224,6 +232,12 @@ main (int argc, char *argv[]) {
     return PROG_EXIT_SYNTAX;
   }
 
+  if (opt_indexFile && *opt_indexFile) {
+    return cldrMakeAnnotationIndex(inputFile, opt_indexFile)?
+           PROG_EXIT_SUCCESS:
+           PROG_EXIT_FATAL;
+  }
+
   return cldrParseFile(inputFile, handleAnnotation, NULL)?
          PROG_EXIT_SUCCESS:
          PROG_EXIT_FATAL;
@@ -42,6 +42,7 @@ static char *opt_verificationTable;
 static int opt_reformatText;
 static char *opt_outputWidth;
 static int opt_forceOutput;
+static int opt_logStatistics;
 
 BEGIN_OPTION_TABLE(programOptions)
   { .word = "tables-directory",
@@ -95,6 +96,12 @@ BEGIN_OPTION_TABLE(programOptions)
     .setting.flag = &opt_forceOutput,
     .description = strtext("Force immediate output.")
   },
+
+  { .word = "statistics",
+    .letter = 's',
+    .setting.flag = &opt_logStatistics,
+    .description = strtext("Log the normalization statistics.")
+  },
 END_OPTION_TABLE
 
 static wchar_t *inputBuffer;
@@ -531,6 +538,16 @@ main (int argc, char *argv[]) {
           if (textTable) destroyTextTable(textTable);
         }
 
+        if (opt_logStatistics) {
+          NormalizationStatistics statistics;
+          getNormalizationStatistics(&statistics);
+
+          logMessage(LOG_NOTICE,
+                     "normalization: Calls:%lu Skipped:%lu Changed:%lu Spans:%lu Characters:%lu",
+                     statistics.calls, statistics.skipped, statistics.changed,
+                     statistics.spans, statistics.characters);
+        }
+
         destroyContractionTable(contractionTable);
       } else {
         exitStatus = PROG_EXIT_FATAL;
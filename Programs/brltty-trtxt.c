@@ -21,13 +21,20 @@
 #include <stdio.h>
 #include <string.h>
 #include <errno.h>
+#include <sys/stat.h>
+
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif /* HAVE_SYS_MMAN_H */
 
 #include "program.h"
 #include "options.h"
 #include "log.h"
 #include "file.h"
+#include "timing.h"
 #include "unicode.h"
 #include "utf8.h"
+#include "charset.h"
 #include "brl_dots.h"
 #include "ttb.h"
 
@@ -36,6 +43,8 @@ static char *opt_inputTable;
 static char *opt_outputTable;
 static int opt_sixDots;
 static int opt_noBaseCharacters;
+static int opt_mapInput;
+static int opt_showThroughput;
 
 static const char tableName_autoselect[] = "auto";
 static const char tableName_unicode[] = "unicode";
@@ -78,6 +87,18 @@ BEGIN_OPTION_TABLE(programOptions)
     .setting.flag = &opt_noBaseCharacters,
     .description = strtext("Don't fall back to the Unicode base character.")
   },
+
+  { .word = "map-input",
+    .letter = 'm',
+    .setting.flag = &opt_mapInput,
+    .description = strtext("Map input files into memory rather than reading them.")
+  },
+
+  { .word = "throughput",
+    .letter = 'r',
+    .setting.flag = &opt_showThroughput,
+    .description = strtext("Report the conversion throughput.")
+  },
 END_OPTION_TABLE
 
 static TextTable *inputTable;
@@ -111,6 +132,22 @@ toCharacter_unicode (unsigned char dots) {
   return UNICODE_BRAILLE_ROW | dots;
 }
 
+static wchar_t
+translateCharacter (wchar_t character) {
+  if (!iswcntrl(character)) {
+    unsigned char dots = toDots(character);
+
+    if (dots || !iswspace(character)) {
+      if (opt_sixDots) dots &= ~(BRL_DOT_7 | BRL_DOT_8);
+      character = toCharacter(dots);
+    }
+  }
+
+  return character;
+}
+
+static size_t inputByteCount;
+
 static int
 writeCharacter (const wchar_t *character, mbstate_t *state) {
   char bytes[0X1000];
@@ -138,6 +175,7 @@ processStream (FILE *inputStream, const char *inputName) {
     if (ferror(inputStream)) goto inputError;
     if (!inputCount) break;
     inputBuffer[inputCount] = 0;
+    inputByteCount += inputCount;
 
     {
       char *byte = inputBuffer;
@@ -156,15 +194,7 @@ processStream (FILE *inputStream, const char *inputName) {
           inputCount -= result;
         }
 
-        if (!iswcntrl(character)) {
-          unsigned char dots = toDots(character);
-
-          if (dots || !iswspace(character)) {
-            if (opt_sixDots) dots &= ~(BRL_DOT_7 | BRL_DOT_8);
-            character = toCharacter(dots);
-          }
-        }
-
+        character = translateCharacter(character);
         if (!writeCharacter(&character, &outputState)) goto outputError;
       }
     }
@@ -194,6 +224,230 @@ outputError:
   return 0;
 }
 
+#define UTF8_TRANSLATION_LIMIT 0X250
+static wchar_t utf8Translations[UTF8_TRANSLATION_LIMIT];
+static wchar_t dotsTranslations[0X100];
+
+static void
+prepareUtf8Translations (void) {
+  for (unsigned int dots=0; dots<ARRAY_COUNT(dotsTranslations); dots+=1) {
+    unsigned char cell = dots;
+    if (opt_sixDots) cell &= ~(BRL_DOT_7 | BRL_DOT_8);
+    dotsTranslations[dots] = toCharacter(cell);
+  }
+
+  for (wchar_t character=0; character<UTF8_TRANSLATION_LIMIT; character+=1) {
+    utf8Translations[character] = translateCharacter(character);
+  }
+}
+
+static wchar_t
+translateUtf8Character (wchar_t character) {
+  if (character < UTF8_TRANSLATION_LIMIT) return utf8Translations[character];
+  if (iswcntrl(character)) return character;
+
+  {
+    unsigned char dots = toDots(character);
+    if (!dots && iswspace(character)) return character;
+    return dotsTranslations[dots];
+  }
+}
+
+static struct {
+  char buffer[0X10000];
+  size_t count;
+} utf8Output;
+
+static int
+flushUtf8Output (void) {
+  if (utf8Output.count) {
+    fwrite(utf8Output.buffer, 1, utf8Output.count, outputStream);
+    utf8Output.count = 0;
+    if (ferror(outputStream)) return 0;
+  }
+
+  return 1;
+}
+
+static size_t
+getUtf8SequenceLength (unsigned char byte) {
+  if (byte < 0XC0) return 0;
+  if (byte < 0XE0) return 2;
+  if (byte < 0XF0) return 3;
+  if (byte < 0XF8) return 4;
+  return 0;
+}
+
+static int
+translateUtf8Bytes (const char **bytes, size_t *count, int isFinal) {
+  const char *byte = *bytes;
+  const char *end = byte + *count;
+  int ok = 1;
+
+  while (byte < end) {
+    wchar_t character;
+
+    if (!(*byte & 0X80)) {
+      character = utf8Translations[(unsigned char)*byte++];
+    } else {
+      size_t length = getUtf8SequenceLength(*byte);
+
+      if (!length) {
+        ok = 0;
+        break;
+      }
+
+      if (length > (end - byte)) {
+        if (isFinal) ok = 0;
+        break;
+      }
+
+      {
+        size_t utfs = length;
+        wint_t wc = convertUtf8ToWchar(&byte, &utfs);
+
+        if (wc == WEOF) {
+          ok = 0;
+          break;
+        }
+
+        character = translateUtf8Character(wc);
+      }
+    }
+
+    if ((sizeof(utf8Output.buffer) - utf8Output.count) < UTF8_LEN_MAX) {
+      if (!flushUtf8Output()) goto outputError;
+    }
+
+    if (!(character & ~0X7F)) {
+      utf8Output.buffer[utf8Output.count++] = character;
+    } else {
+      Utf8Buffer utf8;
+      size_t utfs = convertWcharToUtf8(character, utf8);
+
+      memcpy(&utf8Output.buffer[utf8Output.count], utf8, utfs);
+      utf8Output.count += utfs;
+    }
+  }
+
+  *count = end - byte;
+  *bytes = byte;
+
+  if (!ok) {
+#ifdef EILSEQ
+    errno = EILSEQ;
+#else /* EILSEQ */
+    errno = EINVAL;
+#endif /* EILSEQ */
+  }
+
+  return ok;
+
+outputError:
+  return -1;
+}
+
+static int
+processUtf8Stream (FILE *inputStream, const char *inputName) {
+  char inputBuffer[0X10000];
+  size_t inputCount = 0;
+  int result;
+
+  while (1) {
+    size_t count = fread(&inputBuffer[inputCount], 1, sizeof(inputBuffer)-inputCount, inputStream);
+
+    if (ferror(inputStream)) goto inputError;
+    inputByteCount += count;
+    inputCount += count;
+
+    {
+      const char *bytes = inputBuffer;
+      int isFinal = !count;
+
+      if ((result = translateUtf8Bytes(&bytes, &inputCount, isFinal)) < 0) goto outputError;
+      if (!result) goto inputError;
+      if (isFinal) break;
+
+      memmove(inputBuffer, bytes, inputCount);
+    }
+  }
+
+  if (!flushUtf8Output()) goto outputError;
+  fflush(outputStream);
+  if (ferror(outputStream)) goto outputError;
+  return 1;
+
+inputError:
+  logMessage(LOG_ERR, "input error: %s: %s", inputName, strerror(errno));
+  flushUtf8Output();
+  return 0;
+
+outputError:
+  logMessage(LOG_ERR, "output error: %s: %s", outputName, strerror(errno));
+  return 0;
+}
+
+#ifdef HAVE_SYS_MMAN_H
+static int
+processUtf8Mapping (FILE *inputStream, const char *inputName) {
+  int fileDescriptor = fileno(inputStream);
+  struct stat status;
+
+  if (fstat(fileDescriptor, &status) == -1) goto inputError;
+  if (!S_ISREG(status.st_mode) || !status.st_size) return processUtf8Stream(inputStream, inputName);
+
+  {
+    size_t size = status.st_size;
+    void *address = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+    if (address == MAP_FAILED) goto inputError;
+
+#ifdef MADV_SEQUENTIAL
+    madvise(address, size, MADV_SEQUENTIAL);
+#endif /* MADV_SEQUENTIAL */
+
+    const char *bytes = address;
+    size_t count = size;
+    int result = translateUtf8Bytes(&bytes, &count, 1);
+
+    inputByteCount += size;
+    munmap(address, size);
+
+    if (result < 0) goto outputError;
+    if (!result) goto inputError;
+  }
+
+  if (!flushUtf8Output()) goto outputError;
+  fflush(outputStream);
+  if (ferror(outputStream)) goto outputError;
+  return 1;
+
+inputError:
+  logMessage(LOG_ERR, "input error: %s: %s", inputName, strerror(errno));
+  flushUtf8Output();
+  return 0;
+
+outputError:
+  logMessage(LOG_ERR, "output error: %s: %s", outputName, strerror(errno));
+  return 0;
+}
+#endif /* HAVE_SYS_MMAN_H */
+
+static int (*processInput) (FILE *inputStream, const char *inputName);
+
+static void
+selectInputProcessor (void) {
+  processInput = processStream;
+
+  if (isCharsetUTF8(getLocaleCharset())) {
+    prepareUtf8Translations();
+    processInput = processUtf8Stream;
+
+#ifdef HAVE_SYS_MMAN_H
+    if (opt_mapInput) processInput = processUtf8Mapping;
+#endif /* HAVE_SYS_MMAN_H */
+  }
+}
+
 static int
 getTable (TextTable **table, const char *name) {
   const char *directory = opt_tablesDirectory;
@@ -247,6 +501,10 @@ main (int argc, char *argv[]) {
 
       toDots = inputTable? toDots_mapped: toDots_unicode;
       toCharacter = outputTable? toCharacter_mapped: toCharacter_unicode;
+      selectInputProcessor();
+
+      TimeValue startTime;
+      getMonotonicTime(&startTime);
 
       if (argc) {
         do {
@@ -254,9 +512,9 @@ main (int argc, char *argv[]) {
           FILE *stream;
 
           if (strcmp(file, standardStreamArgument) == 0) {
-            if (!processStream(stdin, standardInputName)) break;
+            if (!processInput(stdin, standardInputName)) break;
           } else if ((stream = fopen(file, "r"))) {
-            int ok = processStream(stream, file);
+            int ok = processInput(stream, file);
             fclose(stream);
             if (!ok) break;
           } else {
@@ -269,10 +527,20 @@ main (int argc, char *argv[]) {
         } while (argc);
 
         if (!argc) exitStatus = PROG_EXIT_SUCCESS;
-      } else if (processStream(stdin, standardInputName)) {
+      } else if (processInput(stdin, standardInputName)) {
         exitStatus = PROG_EXIT_SUCCESS;
       }
 
+      if (opt_showThroughput) {
+        long int elapsed = getMonotonicElapsed(&startTime);
+        double megabytes = (double)inputByteCount / (1024.0 * 1024.0);
+
+        logMessage(LOG_NOTICE,
+                   "%zu bytes in %ld ms: %.1f MB/s",
+                   inputByteCount, elapsed,
+                   (elapsed? (megabytes * MSECS_PER_SEC / elapsed): 0.0));
+      }
+
       if (outputTable) destroyTextTable(outputTable);
     }
 
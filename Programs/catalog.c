@@ -0,0 +1,600 @@
+/*
+ * BRLTTY - A background process providing access to the console screen (when in
+ *          text mode) for a blind person using a refreshable braille display.
+ *
+ * Copyright (C) 1995-2021 by The BRLTTY Developers.
+ *
+ * BRLTTY comes with ABSOLUTELY NO WARRANTY.
+ *
+ * This is free software, placed under the terms of the
+ * GNU Lesser General Public License, as published by the Free Software
+ * Foundation; either version 2.1 of the License, or (at your option) any
+ * later version. Please see the file LICENSE-LGPL for details.
+ *
+ * Web Page: http://brltty.app/
+ *
+ * This software is maintained by Dave Mielke <dave@mielke.cc>.
+ */
+
+#include "prologue.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#undef CAN_GLOB
+#if defined(HAVE_GLOB)
+#define CAN_GLOB
+#include <glob.h>
+
+#elif defined(__MINGW32__)
+#define CAN_GLOB
+#include <io.h>
+
+#else /* glob: paradigm-specific global definitions */
+#warning file globbing support not available on this platform
+#endif /* glob: paradigm-specific global definitions */
+
+#ifdef HAVE_SYS_INOTIFY_H
+#include <sys/inotify.h>
+#endif /* HAVE_SYS_INOTIFY_H */
+
+#include "log.h"
+#include "catalog.h"
+#include "queue.h"
+#include "parse.h"
+#include "file.h"
+#include "async_io.h"
+
+typedef struct {
+  char *name;
+  char *title;
+  char *language;
+  unsigned metadataLoaded:1;
+} FileCatalogEntry;
+
+struct FileCatalogListingStruct {
+  unsigned int referenceCount;
+
+  FileCatalogEntry *entries;
+  unsigned int size;
+  unsigned int count;
+};
+
+struct FileCatalogStruct {
+  char *directory;
+  char *extension;
+
+  FileCatalogListing *listing;
+  time_t modificationTime;
+  unsigned isStale:1;
+  unsigned isWatched:1;
+
+#ifdef HAVE_SYS_INOTIFY_H
+  int notifyDescriptor;
+  AsyncHandle notifyMonitor;
+#endif /* HAVE_SYS_INOTIFY_H */
+};
+
+static FileCatalogListing *
+newFileCatalogListing (void) {
+  FileCatalogListing *listing;
+
+  if ((listing = malloc(sizeof(*listing)))) {
+    listing->referenceCount = 1;
+    listing->entries = NULL;
+    listing->size = 0;
+    listing->count = 0;
+    return listing;
+  } else {
+    logMallocError();
+  }
+
+  return NULL;
+}
+
+void
+releaseFileCatalogListing (FileCatalogListing *listing) {
+  if (!--listing->referenceCount) {
+    while (listing->count) {
+      FileCatalogEntry *entry = &listing->entries[--listing->count];
+
+      free(entry->name);
+      if (entry->title) free(entry->title);
+      if (entry->language) free(entry->language);
+    }
+
+    if (listing->entries) free(listing->entries);
+    free(listing);
+  }
+}
+
+static int
+addFileCatalogEntry (FileCatalogListing *listing, const char *name) {
+  if (listing->count == listing->size) {
+    unsigned int newSize = listing->size? listing->size<<1: 0X20;
+    FileCatalogEntry *newEntries = realloc(listing->entries, ARRAY_SIZE(newEntries, newSize));
+
+    if (!newEntries) {
+      logMallocError();
+      return 0;
+    }
+
+    listing->entries = newEntries;
+    listing->size = newSize;
+  }
+
+  {
+    FileCatalogEntry *entry = &listing->entries[listing->count];
+
+    if (!(entry->name = strdup(name))) {
+      logMallocError();
+      return 0;
+    }
+
+    entry->title = NULL;
+    entry->language = NULL;
+    entry->metadataLoaded = 0;
+  }
+
+  listing->count += 1;
+  return 1;
+}
+
+static int
+sortFileCatalogEntries (const void *element1, const void *element2) {
+  const FileCatalogEntry *entry1 = element1;
+  const FileCatalogEntry *entry2 = element2;
+  return strcmp(entry1->name, entry2->name);
+}
+
+static int
+searchFileCatalogEntry (const void *target, const void *element) {
+  const char *name = target;
+  const FileCatalogEntry *entry = element;
+  return strcmp(name, entry->name);
+}
+
+static int
+scanFileCatalog (const FileCatalog *catalog, FileCatalogListing *listing) {
+  int ok = 1;
+
+#ifdef CAN_GLOB
+  char *pattern;
+
+  {
+    const char *strings[] = {"*", catalog->extension};
+    pattern = joinStrings(strings, ARRAY_COUNT(strings));
+  }
+
+  if (pattern) {
+#ifdef HAVE_FCHDIR
+    int originalDirectory = open(".", O_RDONLY);
+
+    if (originalDirectory != -1)
+#else /* HAVE_FCHDIR */
+    char *originalDirectory = getWorkingDirectory();
+
+    if (originalDirectory)
+#endif /* HAVE_FCHDIR */
+    {
+      if (chdir(catalog->directory) != -1) {
+#if defined(HAVE_GLOB)
+        glob_t paths;
+
+        memset(&paths, 0, sizeof(paths));
+
+        if (glob(pattern, 0, NULL, &paths) == 0) {
+          char **path = paths.gl_pathv;
+
+          while (*path) {
+            if (!addFileCatalogEntry(listing, *path)) {
+              ok = 0;
+              break;
+            }
+
+            path += 1;
+          }
+
+          globfree(&paths);
+        }
+#elif defined(__MINGW32__)
+        struct _finddata_t findData;
+        long findHandle = _findfirst(pattern, &findData);
+
+        if (findHandle != -1) {
+          do {
+            if (!addFileCatalogEntry(listing, findData.name)) {
+              ok = 0;
+              break;
+            }
+          } while (_findnext(findHandle, &findData) == 0);
+
+          _findclose(findHandle);
+        }
+#endif /* glob: paradigm-specific file scanning */
+
+#ifdef HAVE_FCHDIR
+        if (fchdir(originalDirectory) == -1) logSystemError("fchdir");
+#else /* HAVE_FCHDIR */
+        if (chdir(originalDirectory) == -1) logSystemError("chdir");
+#endif /* HAVE_FCHDIR */
+      } else {
+        logMessage(LOG_ERR, "%s: %s: %s",
+                   gettext("cannot set working directory"), catalog->directory, strerror(errno));
+      }
+
+#ifdef HAVE_FCHDIR
+      close(originalDirectory);
+#else /* HAVE_FCHDIR */
+      free(originalDirectory);
+#endif /* HAVE_FCHDIR */
+    } else {
+#ifdef HAVE_FCHDIR
+      logMessage(LOG_ERR, "%s: %s",
+                 gettext("cannot open working directory"), strerror(errno));
+#else /* HAVE_FCHDIR */
+      logMessage(LOG_ERR, "%s", gettext("cannot determine working directory"));
+#endif /* HAVE_FCHDIR */
+    }
+
+    free(pattern);
+  } else {
+    ok = 0;
+  }
+#endif /* CAN_GLOB */
+
+  if (ok) {
+    qsort(listing->entries, listing->count, sizeof(*listing->entries), sortFileCatalogEntries);
+  }
+
+  return ok;
+}
+
+static int
+getDirectoryModificationTime (const char *directory, time_t *modificationTime) {
+  struct stat status;
+
+  if (stat(directory, &status) == -1) return 0;
+  *modificationTime = status.st_mtime;
+  return 1;
+}
+
+static int
+refreshFileCatalog (FileCatalog *catalog) {
+  FileCatalogListing *listing;
+
+  if (!getDirectoryModificationTime(catalog->directory, &catalog->modificationTime)) {
+    catalog->modificationTime = 0;
+  }
+
+  if ((listing = newFileCatalogListing())) {
+    if (scanFileCatalog(catalog, listing)) {
+      if (catalog->listing) releaseFileCatalogListing(catalog->listing);
+      catalog->listing = listing;
+      catalog->isStale = 0;
+
+      logMessage(LOG_DEBUG, "file catalog refreshed: %s: %u *%s files",
+                 catalog->directory, listing->count, catalog->extension);
+      return 1;
+    }
+
+    releaseFileCatalogListing(listing);
+  }
+
+  return 0;
+}
+
+#ifdef HAVE_SYS_INOTIFY_H
+ASYNC_MONITOR_CALLBACK(handleFileCatalogNotification) {
+  FileCatalog *catalog = parameters->data;
+
+  union {
+    struct inotify_event event;
+    char bytes[0X1000];
+  } buffer;
+
+  ssize_t count;
+
+  while ((count = read(catalog->notifyDescriptor, &buffer, sizeof(buffer))) > 0) {
+    const char *byte = buffer.bytes;
+    const char *end = byte + count;
+
+    while (byte < end) {
+      const struct inotify_event *event = (const void *)byte;
+
+      if (event->mask & (IN_Q_OVERFLOW | IN_IGNORED)) {
+        catalog->isStale = 1;
+        if (event->mask & IN_IGNORED) catalog->isWatched = 0;
+      } else if (event->len && hasFileExtension(event->name, catalog->extension)) {
+        catalog->isStale = 1;
+      }
+
+      byte += sizeof(*event) + event->len;
+    }
+  }
+
+  if (count == -1) {
+    if ((errno != EAGAIN) && (errno != EINTR)) {
+      logSystemError("inotify read");
+    }
+  }
+
+  return 1;
+}
+#endif /* HAVE_SYS_INOTIFY_H */
+
+static void
+watchFileCatalog (FileCatalog *catalog) {
+  catalog->isWatched = 0;
+
+#ifdef HAVE_SYS_INOTIFY_H
+  catalog->notifyMonitor = NULL;
+
+  if ((catalog->notifyDescriptor = inotify_init1(IN_NONBLOCK | IN_CLOEXEC)) != -1) {
+    static const uint32_t events = IN_CREATE | IN_DELETE | IN_CLOSE_WRITE
+                                 | IN_MOVED_FROM | IN_MOVED_TO
+                                 | IN_DELETE_SELF | IN_MOVE_SELF
+                                 | IN_ONLYDIR;
+
+    if (inotify_add_watch(catalog->notifyDescriptor, catalog->directory, events) != -1) {
+      if (asyncMonitorFileInput(&catalog->notifyMonitor, catalog->notifyDescriptor,
+                                handleFileCatalogNotification, catalog)) {
+        catalog->isWatched = 1;
+        return;
+      }
+    } else {
+      logMessage(LOG_DEBUG, "inotify watch error: %s: %s",
+                 catalog->directory, strerror(errno));
+    }
+
+    close(catalog->notifyDescriptor);
+    catalog->notifyDescriptor = -1;
+  } else {
+    logSystemError("inotify_init1");
+  }
+#endif /* HAVE_SYS_INOTIFY_H */
+}
+
+static void
+unwatchFileCatalog (FileCatalog *catalog) {
+#ifdef HAVE_SYS_INOTIFY_H
+  if (catalog->notifyMonitor) {
+    asyncCancelRequest(catalog->notifyMonitor);
+    catalog->notifyMonitor = NULL;
+  }
+
+  if (catalog->notifyDescriptor != -1) {
+    close(catalog->notifyDescriptor);
+    catalog->notifyDescriptor = -1;
+  }
+#endif /* HAVE_SYS_INOTIFY_H */
+
+  catalog->isWatched = 0;
+}
+
+static void
+deallocateFileCatalog (void *item, void *data) {
+  FileCatalog *catalog = item;
+
+  unwatchFileCatalog(catalog);
+  if (catalog->listing) releaseFileCatalogListing(catalog->listing);
+  free(catalog->extension);
+  free(catalog->directory);
+  free(catalog);
+}
+
+static Queue *
+createFileCatalogQueue (void *data) {
+  return newQueue(deallocateFileCatalog, NULL);
+}
+
+static Queue *
+getFileCatalogQueue (int create) {
+  static Queue *catalogs = NULL;
+
+  return getProgramQueue(&catalogs, "file-catalog-queue", create,
+                         createFileCatalogQueue, NULL);
+}
+
+typedef struct {
+  const char *directory;
+  const char *extension;
+} FileCatalogKey;
+
+static int
+testFileCatalog (const void *item, void *data) {
+  const FileCatalog *catalog = item;
+  const FileCatalogKey *key = data;
+
+  return (strcmp(catalog->directory, key->directory) == 0)
+      && (strcmp(catalog->extension, key->extension) == 0);
+}
+
+static FileCatalog *
+newFileCatalog (const char *directory, const char *extension) {
+  FileCatalog *catalog;
+
+  if ((catalog = malloc(sizeof(*catalog)))) {
+    memset(catalog, 0, sizeof(*catalog));
+    catalog->listing = NULL;
+    catalog->isStale = 1;
+
+#ifdef HAVE_SYS_INOTIFY_H
+    catalog->notifyDescriptor = -1;
+#endif /* HAVE_SYS_INOTIFY_H */
+
+    if ((catalog->directory = strdup(directory))) {
+      if ((catalog->extension = strdup(extension))) {
+        watchFileCatalog(catalog);
+        refreshFileCatalog(catalog);
+        return catalog;
+      }
+
+      free(catalog->directory);
+    }
+
+    free(catalog);
+  }
+
+  logMallocError();
+  return NULL;
+}
+
+FileCatalog *
+getFileCatalog (const char *directory, const char *extension) {
+  Queue *catalogs = getFileCatalogQueue(1);
+
+  if (catalogs) {
+    FileCatalogKey key = {
+      .directory = directory,
+      .extension = extension
+    };
+
+    FileCatalog *catalog = findItem(catalogs, testFileCatalog, &key);
+    if (catalog) return catalog;
+
+    if ((catalog = newFileCatalog(directory, extension))) {
+      if (enqueueItem(catalogs, catalog)) return catalog;
+      deallocateFileCatalog(catalog, NULL);
+    }
+  }
+
+  return NULL;
+}
+
+FileCatalogListing *
+getFileCatalogListing (FileCatalog *catalog) {
+  if (!catalog->isWatched && !catalog->isStale) {
+    time_t modificationTime;
+
+    if (!getDirectoryModificationTime(catalog->directory, &modificationTime)) modificationTime = 0;
+    if (modificationTime != catalog->modificationTime) catalog->isStale = 1;
+  }
+
+  if (catalog->isStale) refreshFileCatalog(catalog);
+
+  {
+    FileCatalogListing *listing = catalog->listing;
+
+    if (listing) listing->referenceCount += 1;
+    return listing;
+  }
+}
+
+unsigned int
+getFileCatalogCount (const FileCatalogListing *listing) {
+  return listing->count;
+}
+
+const char *
+getFileCatalogName (const FileCatalogListing *listing, unsigned int index) {
+  return listing->entries[index].name;
+}
+
+static int
+handleFileCatalogHeader (const LineHandlerParameters *parameters) {
+  FileCatalogEntry *entry = parameters->data;
+  const char *line = parameters->line.text;
+  const char *title = NULL;
+
+  while (isspace((unsigned char)*line)) line += 1;
+
+  if (*line == '#') {
+    static const char prefix[] = "# BRLTTY ";
+    static const char separator[] = " Table - ";
+
+    if (strncmp(line, prefix, sizeof(prefix)-1) == 0) {
+      const char *location = strstr(line, separator);
+      if (location) title = location + sizeof(separator) - 1;
+    }
+  } else {
+    static const char directive[] = "title";
+    const size_t length = sizeof(directive) - 1;
+
+    if ((strncmp(line, directive, length) == 0) && isspace((unsigned char)line[length])) {
+      title = line + length;
+    }
+  }
+
+  if (title) {
+    while (isspace((unsigned char)*title)) title += 1;
+
+    if (*title) {
+      if (!(entry->title = strdup(title))) logMallocError();
+      return 0;
+    }
+  }
+
+  return parameters->line.number < 40;
+}
+
+static void
+loadFileCatalogMetadata (const FileCatalog *catalog, FileCatalogEntry *entry) {
+  entry->metadataLoaded = 1;
+
+  {
+    const char *name = entry->name;
+    size_t length = 0;
+
+    while (islower((unsigned char)name[length])) length += 1;
+
+    if ((length >= 2) && (length <= 3) && name[length] && strchr("-_.", name[length])) {
+      if ((entry->language = malloc(length + 1))) {
+        memcpy(entry->language, name, length);
+        entry->language[length] = 0;
+      } else {
+        logMallocError();
+      }
+    }
+  }
+
+  {
+    char *path = makePath(catalog->directory, entry->name);
+
+    if (path) {
+      FILE *stream = openFile(path, "r", 1);
+
+      if (stream) {
+        processLines(stream, handleFileCatalogHeader, entry);
+        fclose(stream);
+      }
+
+      free(path);
+    }
+  }
+}
+
+static FileCatalogEntry *
+getFileCatalogEntry (FileCatalog *catalog, const char *name) {
+  FileCatalogListing *listing = catalog->listing;
+
+  if (listing) {
+    FileCatalogEntry *entry = bsearch(name, listing->entries, listing->count,
+                                      sizeof(*listing->entries), searchFileCatalogEntry);
+
+    if (entry) {
+      if (!entry->metadataLoaded) loadFileCatalogMetadata(catalog, entry);
+      return entry;
+    }
+  }
+
+  return NULL;
+}
+
+const char *
+getFileCatalogTitle (FileCatalog *catalog, const char *name) {
+  const FileCatalogEntry *entry = getFileCatalogEntry(catalog, name);
+
+  return entry? entry->title: NULL;
+}
+
+const char *
+getFileCatalogLanguage (FileCatalog *catalog, const char *name) {
+  const FileCatalogEntry *entry = getFileCatalogEntry(catalog, name);
+
+  return entry? entry->language: NULL;
+}
@@ -0,0 +1,44 @@
+/*
+ * BRLTTY - A background process providing access to the console screen (when in
+ *          text mode) for a blind person using a refreshable braille display.
+ *
+ * Copyright (C) 1995-2021 by The BRLTTY Developers.
+ *
+ * BRLTTY comes with ABSOLUTELY NO WARRANTY.
+ *
+ * This is free software, placed under the terms of the
+ * GNU Lesser General Public License, as published by the Free Software
+ * Foundation; either version 2.1 of the License, or (at your option) any
+ * later version. Please see the file LICENSE-LGPL for details.
+ *
+ * Web Page: http://brltty.app/
+ *
+ * This software is maintained by Dave Mielke <dave@mielke.cc>.
+ */
+
+#ifndef BRLTTY_INCLUDED_CATALOG
+#define BRLTTY_INCLUDED_CATALOG
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+typedef struct FileCatalogStruct FileCatalog;
+typedef struct FileCatalogListingStruct FileCatalogListing;
+
+extern FileCatalog *getFileCatalog (const char *directory, const char *extension);
+
+extern FileCatalogListing *getFileCatalogListing (FileCatalog *catalog);
+extern void releaseFileCatalogListing (FileCatalogListing *listing);
+
+extern unsigned int getFileCatalogCount (const FileCatalogListing *listing);
+extern const char *getFileCatalogName (const FileCatalogListing *listing, unsigned int index);
+
+extern const char *getFileCatalogTitle (FileCatalog *catalog, const char *name);
+extern const char *getFileCatalogLanguage (FileCatalog *catalog, const char *name);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* BRLTTY_INCLUDED_CATALOG */
@@ -0,0 +1,383 @@
+/*
+ * BRLTTY - A background process providing access to the console screen (when in
+ *          text mode) for a blind person using a refreshable braille display.
+ *
+ * Copyright (C) 1995-2021 by The BRLTTY Developers.
+ *
+ * BRLTTY comes with ABSOLUTELY NO WARRANTY.
+ *
+ * This is free software, placed under the terms of the
+ * GNU Lesser General Public License, as published by the Free Software
+ * Foundation; either version 2.1 of the License, or (at your option) any
+ * later version. Please see the file LICENSE-LGPL for details.
+ *
+ * Web Page: http://brltty.app/
+ *
+ * This software is maintained by Dave Mielke <dave@mielke.cc>.
+ */
+
+#include "prologue.h"
+
+#include <string.h>
+#include <limits.h>
+
+#include "log.h"
+#include "program.h"
+#include "options.h"
+#include "brl_utils.h"
+
+BEGIN_OPTION_TABLE(programOptions)
+END_OPTION_TABLE
+
+typedef struct {
+  const char *name;
+  unsigned int columns;
+  unsigned int rows;
+} DisplaySize;
+
+static const DisplaySize displaySizes[] = {
+  { .name = "20 cells", .columns = 20, .rows = 1 },
+  { .name = "40 cells", .columns = 40, .rows = 1 },
+  { .name = "80 cells", .columns = 80, .rows = 1 },
+  { .name = "40x4 cells", .columns = 40, .rows = 4 },
+  { .name = "40x9 cells", .columns = 40, .rows = 9 },
+  { .name = "60x40 cells", .columns = 60, .rows = 40 },
+};
+
+static unsigned int
+randomInteger (unsigned int limit) {
+  return rand() % limit;
+}
+
+static void
+fillCells (unsigned char *cells, unsigned int count) {
+  for (unsigned int index=0; index<count; index+=1) cells[index] = rand();
+}
+
+static void
+changeCells (unsigned char *cells, unsigned int count) {
+  unsigned int changes = randomInteger(4);
+
+  while (changes--) {
+    unsigned int from = randomInteger(count);
+    unsigned int length = randomInteger(count - from) + 1;
+
+    while (length--) cells[from++] ^= randomInteger(0XFF) + 1;
+  }
+}
+
+static int
+testSingleSpan (const unsigned char *old, const unsigned char *new, unsigned int count) {
+  unsigned char cells[count];
+  unsigned int from, to;
+  int changed;
+
+  memcpy(cells, old, count);
+  changed = cellsHaveChanged(cells, new, count, &from, &to, NULL);
+
+  if (memcmp(old, new, count) == 0) {
+    if (!changed) return 1;
+  } else if (changed) {
+    unsigned int first = 0;
+    unsigned int last = count;
+
+    while (old[first] == new[first]) first += 1;
+    while (old[last-1] == new[last-1]) last -= 1;
+
+    if ((from == first) && (to == last) && (memcmp(cells, new, count) == 0)) return 1;
+  }
+
+  logMessage(LOG_ERR, "single span mismatch: count=%u", count);
+  return 0;
+}
+
+static int
+testMultipleSpans (const unsigned char *old, const unsigned char *new, unsigned int count) {
+  unsigned char cells[count];
+  CellSpan spans[4];
+  unsigned int gap = randomInteger(4);
+  unsigned int spanCount;
+
+  memcpy(cells, old, count);
+  spanCount = cellsHaveChangedSpans(cells, new, count, spans, ARRAY_COUNT(spans), gap, NULL);
+
+  if (memcmp(cells, new, count) != 0) {
+    logMessage(LOG_ERR, "multiple spans not copied: count=%u", count);
+    return 0;
+  }
+
+  {
+    unsigned int index = 0;
+
+    for (unsigned int span=0; span<spanCount; span+=1) {
+      const CellSpan *cs = &spans[span];
+
+      if ((cs->from >= cs->to) || (cs->to > count) || (cs->from < index)) {
+        logMessage(LOG_ERR, "invalid span: count=%u from=%u to=%u", count, cs->from, cs->to);
+        return 0;
+      }
+
+      while (index < cs->from) {
+        if (old[index] != new[index]) {
+          logMessage(LOG_ERR, "change not in span: count=%u index=%u", count, index);
+          return 0;
+        }
+
+        index += 1;
+      }
+
+      index = cs->to;
+    }
+
+    while (index < count) {
+      if (old[index] != new[index]) {
+        logMessage(LOG_ERR, "change after last span: count=%u index=%u", count, index);
+        return 0;
+      }
+
+      index += 1;
+    }
+  }
+
+  return 1;
+}
+
+static unsigned int
+getCheapestWriteBytes (
+  const unsigned char *old, const unsigned char *new, unsigned int count,
+  unsigned int limit, const CellWriteCost *cost
+) {
+  CellSpan runs[(count + 1) / 2];
+  unsigned int runCount = 0;
+
+  for (unsigned int index=0; index<count; index+=1) {
+    if (old[index] != new[index]) {
+      if (runCount && (runs[runCount-1].to == index)) {
+        runs[runCount-1].to += 1;
+      } else {
+        runs[runCount++] = (CellSpan){ .from = index, .to = index + 1 };
+      }
+    }
+  }
+
+  {
+    /* bytes[spans][runs]: the cheapest way to write the first runs */
+    unsigned int bytes[limit+1][runCount+1];
+    unsigned int cheapest = UINT_MAX;
+
+    for (unsigned int spanCount=0; spanCount<=limit; spanCount+=1) {
+      bytes[spanCount][0] = spanCount? UINT_MAX: 0;
+
+      for (unsigned int last=1; last<=runCount; last+=1) {
+        bytes[spanCount][last] = UINT_MAX;
+        if (!spanCount) continue;
+
+        for (unsigned int first=1; first<=last; first+=1) {
+          unsigned int before = bytes[spanCount-1][first-1];
+
+          if (before != UINT_MAX) {
+            const CellSpan span = {
+              .from = runs[first-1].from,
+              .to = runs[last-1].to
+            };
+
+            unsigned int total = before + getCellWriteBytes(new, &span, cost);
+            if (total < bytes[spanCount][last]) bytes[spanCount][last] = total;
+          }
+        }
+      }
+
+      if (bytes[spanCount][runCount] < cheapest) cheapest = bytes[spanCount][runCount];
+    }
+
+    return cheapest;
+  }
+}
+
+static int
+testPlannedWrites (const unsigned char *old, const unsigned char *new, unsigned int count) {
+  unsigned char cells[count];
+  CellSpan spans[4];
+  unsigned int limit = randomInteger(ARRAY_COUNT(spans)) + 1;
+  unsigned int spanCount;
+
+  const CellWriteCost cost = {
+    .packetBytes = randomInteger(8),
+    .cellBytes = randomInteger(2) + 1,
+    .escapeBytes = randomInteger(2),
+    .escapeCell = new[randomInteger(count)]
+  };
+
+  memcpy(cells, old, count);
+  spanCount = planCellWrites(cells, new, count, spans, limit, &cost, NULL);
+
+  if ((spanCount > limit) || (memcmp(cells, new, count) != 0)) {
+    logMessage(LOG_ERR, "planned writes not copied: count=%u", count);
+    return 0;
+  }
+
+  {
+    unsigned int bytes = 0;
+    unsigned int index = 0;
+
+    for (unsigned int span=0; span<spanCount; span+=1) {
+      const CellSpan *cs = &spans[span];
+
+      if ((cs->from >= cs->to) || (cs->to > count) || (cs->from < index)) {
+        logMessage(LOG_ERR, "invalid planned write: count=%u from=%u to=%u", count, cs->from, cs->to);
+        return 0;
+      }
+
+      while (index < cs->from) {
+        if (old[index] != new[index]) {
+          logMessage(LOG_ERR, "change not written: count=%u index=%u", count, index);
+          return 0;
+        }
+
+        index += 1;
+      }
+
+      index = cs->to;
+      bytes += getCellWriteBytes(new, cs, &cost);
+    }
+
+    while (index < count) {
+      if (old[index] != new[index]) {
+        logMessage(LOG_ERR, "change after last write: count=%u index=%u", count, index);
+        return 0;
+      }
+
+      index += 1;
+    }
+
+    {
+      unsigned int cheapest = getCheapestWriteBytes(old, new, count, limit, &cost);
+
+      if (bytes != cheapest) {
+        logMessage(LOG_ERR, "planned writes not cheapest: count=%u bytes=%u cheapest=%u",
+                   count, bytes, cheapest);
+        return 0;
+      }
+    }
+  }
+
+  return 1;
+}
+
+static int
+testRows (const unsigned char *old, const unsigned char *new, unsigned int columns, unsigned int rows) {
+  unsigned int count = columns * rows;
+  unsigned char cells[count];
+  unsigned char changedRows[rows];
+  unsigned int changedCount;
+
+  memcpy(cells, old, count);
+  changedCount = cellRowsHaveChanged(cells, new, columns, rows, changedRows, NULL);
+
+  for (unsigned int row=0; row<rows; row+=1) {
+    unsigned int offset = row * columns;
+    int changed = memcmp(&old[offset], &new[offset], columns) != 0;
+
+    if (changed != changedRows[row]) {
+      logMessage(LOG_ERR, "row change mismatch: columns=%u row=%u", columns, row);
+      return 0;
+    }
+
+    if (changed) changedCount -= 1;
+  }
+
+  if (changedCount || (memcmp(cells, new, count) != 0)) {
+    logMessage(LOG_ERR, "row change count mismatch: columns=%u rows=%u", columns, rows);
+    return 0;
+  }
+
+  return 1;
+}
+
+static int
+testText (unsigned int count) {
+  wchar_t old[count];
+  wchar_t new[count];
+  wchar_t text[count];
+
+  for (unsigned int index=0; index<count; index+=1) {
+    old[index] = new[index] = randomInteger(0X10000);
+  }
+
+  {
+    unsigned int index = randomInteger(count);
+    new[index] ^= (randomInteger(0XFF) + 1) << (randomInteger(2) * 8);
+
+    {
+      unsigned int from, to;
+
+      wmemcpy(text, old, count);
+
+      if (!textHasChanged(text, new, count, &from, &to, NULL) ||
+          (from != index) || (to != (index + 1)) ||
+          (wmemcmp(text, new, count) != 0)) {
+        logMessage(LOG_ERR, "text change mismatch: count=%u index=%u", count, index);
+        return 0;
+      }
+    }
+  }
+
+  return 1;
+}
+
+static int
+verifyChangeDetection (void) {
+  for (unsigned int iteration=0; iteration<0X1000; iteration+=1) {
+    const DisplaySize *size = &displaySizes[randomInteger(ARRAY_COUNT(displaySizes))];
+    unsigned int count = size->columns * size->rows;
+    unsigned char old[count];
+    unsigned char new[count];
+
+    fillCells(old, count);
+    memcpy(new, old, count);
+    changeCells(new, count);
+
+    if (!testSingleSpan(old, new, count)) return 0;
+    if (!testMultipleSpans(old, new, count)) return 0;
+    if (!testPlannedWrites(old, new, count)) return 0;
+    if (!testRows(old, new, size->columns, size->rows)) return 0;
+    if (!testText(count)) return 0;
+  }
+
+  return 1;
+}
+
+int
+main (int argc, char *argv[]) {
+  {
+    static const OptionsDescriptor descriptor = {
+      OPTION_TABLE(programOptions),
+      .applicationName = "celltest",
+      .argumentsSummary = ""
+    };
+
+    PROCESS_OPTIONS(descriptor, argc, argv);
+  }
+
+  srand(1);
+  if (!verifyChangeDetection()) return PROG_EXIT_FATAL;
+
+  return PROG_EXIT_SUCCESS;
+}
+
+#include "scr.h"
+
+KeyTableCommandContext
+getScreenCommandContext (void) {
+  return KTB_CTX_DEFAULT;
+}
+
+#include "alert.h"
+
+void
+alert (AlertIdentifier identifier) {
+}
+
+#include "api_control.h"
+
+const ApiMethods api;
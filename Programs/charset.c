@@ -61,6 +61,9 @@ const char defaultCharset[] = "ISO-8859-1";
 
 static char *currentCharset = NULL;
 
+/* Incremented whenever the current charset changes. */
+static unsigned int charsetGeneration = 0;
+
 char *
 getLocaleName (void) {
 #if defined(__MINGW32__)
@@ -129,6 +132,13 @@ getWcharCharset (void) {
   return wcharCharset;
 }
 
+int
+isCharsetWchar (const char *name) {
+  const char *charset = getWcharCharset();
+
+  return charset && (strcasecmp(name, charset) == 0);
+}
+
 const char *
 setCharset (const char *name) {
   char *charset;
@@ -157,6 +167,7 @@ setCharset (const char *name) {
     registerProgramMemory("current-charset", &currentCharset);
   }
 
+  charsetGeneration += 1;
   return currentCharset = charset;
 }
 
@@ -165,6 +176,11 @@ getCharset (void) {
   return setCharset(NULL);
 }
 
+unsigned int
+getCharsetGeneration (void) {
+  return charsetGeneration;
+}
+
 static LockDescriptor *
 getCharsetLock (void) {
   static LockDescriptor *lock = NULL;
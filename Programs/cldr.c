@@ -23,6 +23,10 @@
 #include <fcntl.h>
 #include <sys/stat.h>
 
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif /* HAVE_SYS_MMAN_H */
+
 #include "log.h"
 #include "cldr.h"
 #include "file.h"
@@ -256,59 +260,594 @@ cldrParseDocument (
 
 const char cldrAnnotationsDirectory[] = "/usr/share/unicode/cldr/common/annotations";
 const char cldrAnnotationsExtension[] = ".xml";
+const char cldrIndexExtension[] = ".cldx";
+
+/*
+ * An annotation index is a compact binary copy of an annotations file:
+ * a header, the entries (in document order), the entry numbers sorted by
+ * sequence (for binary search), and then the NUL-terminated strings. It's
+ * mapped (when possible) rather than read, and is only used while its
+ * recorded source size and modification time still match the XML file.
+ */
+
+#define CLDR_INDEX_MAGIC "BRLCLDR1"
+
+typedef struct {
+  char magic[8];
+  uint32_t count;
+  uint32_t stringsSize;
+  uint64_t sourceSize;
+  int64_t sourceTime;
+} CLDR_IndexHeader;
+
+typedef struct {
+  uint32_t sequence;
+  uint32_t name;
+} CLDR_IndexEntry;
+
+struct CLDR_AnnotationIndexStruct {
+  void *address;
+  size_t size;
+  unsigned isMapped:1;
+
+  const CLDR_IndexHeader *header;
+  const CLDR_IndexEntry *entries;
+  const uint32_t *sorted;
+  const char *strings;
+};
+
+static int
+getSourceStatus (const char *path, struct stat *status) {
+  if (stat(path, status) != -1) return 1;
+  if (errno != ENOENT) logMessage(LOG_WARNING, "CLDR stat error: %s: %s", strerror(errno), path);
+  return 0;
+}
+
+static int
+verifyAnnotationIndex (CLDR_AnnotationIndex *index, const char *path) {
+  const CLDR_IndexHeader *header = index->address;
+  size_t offset = sizeof(*header);
+
+  if (index->size < offset) goto invalid;
+  if (memcmp(header->magic, CLDR_INDEX_MAGIC, sizeof(header->magic)) != 0) goto invalid;
+
+  {
+    size_t count = header->count;
+
+    if (count > ((index->size - offset) / sizeof(*index->entries))) goto invalid;
+    index->entries = (const void *)((const char *)index->address + offset);
+    offset += count * sizeof(*index->entries);
+
+    if (count > ((index->size - offset) / sizeof(*index->sorted))) goto invalid;
+    index->sorted = (const void *)((const char *)index->address + offset);
+    offset += count * sizeof(*index->sorted);
+
+    if ((index->size - offset) != header->stringsSize) goto invalid;
+    index->strings = (const char *)index->address + offset;
+    if (header->stringsSize && index->strings[header->stringsSize - 1]) goto invalid;
+
+    for (size_t number=0; number<count; number+=1) {
+      const CLDR_IndexEntry *entry = &index->entries[number];
+
+      if (entry->sequence >= header->stringsSize) goto invalid;
+      if (entry->name >= header->stringsSize) goto invalid;
+      if (index->sorted[number] >= count) goto invalid;
+    }
+  }
+
+  index->header = header;
+  return 1;
+
+invalid:
+  logMessage(LOG_WARNING, "invalid CLDR annotations index: %s", path);
+  return 0;
+}
+
+static CLDR_AnnotationIndex *
+loadAnnotationIndex (const char *path, const struct stat *source) {
+  CLDR_AnnotationIndex *index = NULL;
+  int fd = open(path, O_RDONLY);
+
+  if (fd != -1) {
+    struct stat status;
+
+    if (fstat(fd, &status) != -1) {
+      if ((index = malloc(sizeof(*index)))) {
+        memset(index, 0, sizeof(*index));
+        index->size = status.st_size;
+
+#ifdef HAVE_SYS_MMAN_H
+        if (index->size) {
+          void *address = mmap(NULL, index->size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+          if (address != MAP_FAILED) {
+            index->address = address;
+            index->isMapped = 1;
+          }
+        }
+#endif /* HAVE_SYS_MMAN_H */
+
+        if (!index->address) {
+          if ((index->address = malloc(index->size + 1))) {
+            ssize_t count = readFileDescriptor(fd, index->address, index->size);
+
+            if (count != index->size) {
+              if (count == -1) {
+                logMessage(LOG_WARNING, "CLDR read error: %s: %s", strerror(errno), path);
+              }
+
+              free(index->address);
+              index->address = NULL;
+            }
+          } else {
+            logMallocError();
+          }
+        }
+
+        if (index->address && verifyAnnotationIndex(index, path)) {
+          if (!source ||
+              ((index->header->sourceSize == source->st_size) &&
+               (index->header->sourceTime == source->st_mtime))) {
+            logMessage(LOG_DEBUG, "using CLDR annotations index: %s", path);
+            close(fd);
+            return index;
+          }
+
+          logMessage(LOG_DEBUG, "CLDR annotations index is stale: %s", path);
+        }
+
+        cldrCloseAnnotationIndex(index);
+        index = NULL;
+      } else {
+        logMallocError();
+      }
+    } else {
+      logMessage(LOG_WARNING, "CLDR stat error: %s: %s", strerror(errno), path);
+    }
+
+    close(fd);
+  } else if (errno != ENOENT) {
+    logMessage(LOG_WARNING, "CLDR open error: %s: %s", strerror(errno), path);
+  }
+
+  return NULL;
+}
+
+static char *
+makeCachedIndexPath (const char *sourcePath) {
+  char *path = NULL;
+  char *file = replaceFileExtension(locatePathName(sourcePath), cldrIndexExtension);
+
+  if (file) {
+    if (getUpdatableDirectory()) path = makeUpdatablePath(file);
+    free(file);
+  }
+
+  return path;
+}
+
+static CLDR_AnnotationIndex *
+findAnnotationIndex (const char *sourcePath) {
+  CLDR_AnnotationIndex *index = NULL;
+  struct stat source;
+  const struct stat *status = getSourceStatus(sourcePath, &source)? &source: NULL;
+
+  {
+    char *path = replaceFileExtension(sourcePath, cldrIndexExtension);
+
+    if (path) {
+      index = loadAnnotationIndex(path, status);
+      free(path);
+    }
+  }
+
+  if (!index) {
+    char *path = makeCachedIndexPath(sourcePath);
+
+    if (path) {
+      index = loadAnnotationIndex(path, status);
+      free(path);
+    }
+  }
+
+  return index;
+}
+
+CLDR_AnnotationIndex *
+cldrOpenAnnotationIndex (const char *name) {
+  CLDR_AnnotationIndex *index = NULL;
+
+  if (hasFileExtension(name, cldrIndexExtension)) {
+    index = loadAnnotationIndex(name, NULL);
+  } else {
+    char *path = makeFilePath(cldrAnnotationsDirectory, name, cldrAnnotationsExtension);
+
+    if (path) {
+      index = findAnnotationIndex(path);
+      free(path);
+    }
+  }
+
+  return index;
+}
+
+void
+cldrCloseAnnotationIndex (CLDR_AnnotationIndex *index) {
+  if (index->address) {
+#ifdef HAVE_SYS_MMAN_H
+    if (index->isMapped) {
+      munmap(index->address, index->size);
+    } else
+#endif /* HAVE_SYS_MMAN_H */
+
+    {
+      free(index->address);
+    }
+  }
+
+  free(index);
+}
+
+unsigned int
+cldrGetAnnotationCount (const CLDR_AnnotationIndex *index) {
+  return index->header->count;
+}
+
+const char *
+cldrFindAnnotation (const CLDR_AnnotationIndex *index, const char *sequence) {
+  unsigned int from = 0;
+  unsigned int to = index->header->count;
+
+  while (from < to) {
+    unsigned int current = (from + to) / 2;
+    const CLDR_IndexEntry *entry = &index->entries[index->sorted[current]];
+    int relation = strcmp(sequence, &index->strings[entry->sequence]);
+
+    if (!relation) return &index->strings[entry->name];
+
+    if (relation < 0) {
+      to = current;
+    } else {
+      from = current + 1;
+    }
+  }
+
+  return NULL;
+}
 
 int
-cldrParseFile (
-  const char *name,
+cldrProcessAnnotationIndex (
+  const CLDR_AnnotationIndex *index,
   CLDR_AnnotationHandler *handler, void *data
 ) {
+  const CLDR_IndexEntry *entry = index->entries;
+  const CLDR_IndexEntry *end = entry + index->header->count;
+
+  while (entry < end) {
+    CLDR_AnnotationHandlerParameters parameters = {
+      .sequence = &index->strings[entry->sequence],
+      .name = &index->strings[entry->name],
+      .data = data
+    };
+
+    if (!handler(&parameters)) return 0;
+    entry += 1;
+  }
+
+  return 1;
+}
+
+typedef struct {
+  CLDR_AnnotationHandler *handler;
+  void *data;
+
+  struct {
+    CLDR_IndexEntry *array;
+    size_t size;
+    size_t count;
+  } entries;
+
+  struct {
+    char *buffer;
+    size_t size;
+    size_t length;
+  } strings;
+
+  unsigned isIncomplete:1;
+} IndexBuilder;
+
+static int
+addIndexString (IndexBuilder *ib, const char *string, uint32_t *offset) {
+  size_t size = strlen(string) + 1;
+
+  if ((ib->strings.length + size) > ib->strings.size) {
+    size_t newSize = (ib->strings.size | 0XFFF) + 1;
+    while ((ib->strings.length + size) > newSize) newSize <<= 1;
+
+    char *newBuffer = realloc(ib->strings.buffer, newSize);
+
+    if (!newBuffer) {
+      logMallocError();
+      return 0;
+    }
+
+    ib->strings.buffer = newBuffer;
+    ib->strings.size = newSize;
+  }
+
+  *offset = ib->strings.length;
+  memcpy(&ib->strings.buffer[ib->strings.length], string, size);
+  ib->strings.length += size;
+  return 1;
+}
+
+static int
+addIndexEntry (IndexBuilder *ib, const CLDR_AnnotationHandlerParameters *parameters) {
+  if (ib->entries.count == ib->entries.size) {
+    size_t newSize = ib->entries.size? (ib->entries.size << 1): 0X100;
+    CLDR_IndexEntry *newArray = realloc(ib->entries.array, ARRAY_SIZE(newArray, newSize));
+
+    if (!newArray) {
+      logMallocError();
+      return 0;
+    }
+
+    ib->entries.array = newArray;
+    ib->entries.size = newSize;
+  }
+
+  {
+    CLDR_IndexEntry *entry = &ib->entries.array[ib->entries.count];
+
+    if (!addIndexString(ib, parameters->sequence, &entry->sequence)) return 0;
+    if (!addIndexString(ib, parameters->name, &entry->name)) return 0;
+  }
+
+  ib->entries.count += 1;
+  return 1;
+}
+
+static
+CLDR_ANNOTATION_HANDLER(buildIndex) {
+  IndexBuilder *ib = parameters->data;
+
+  if (!ib->isIncomplete) {
+    if (!addIndexEntry(ib, parameters)) ib->isIncomplete = 1;
+  }
+
+  if (ib->handler) {
+    CLDR_AnnotationHandlerParameters callerParameters = *parameters;
+    callerParameters.data = ib->data;
+    if (!ib->handler(&callerParameters)) return 0;
+  }
+
+  return 1;
+}
+
+typedef struct {
+  const char *sequence;
+  uint32_t number;
+} SortedEntry;
+
+static int
+sortIndexEntries (const void *element1, const void *element2) {
+  const SortedEntry *entry1 = element1;
+  const SortedEntry *entry2 = element2;
+
+  int relation = strcmp(entry1->sequence, entry2->sequence);
+  if (relation) return relation;
+
+  if (entry1->number < entry2->number) return -1;
+  if (entry1->number > entry2->number) return 1;
+  return 0;
+}
+
+static int
+writeIndexData (FILE *stream, const void *data, size_t size) {
+  if (!size) return 1;
+  return fwrite(data, size, 1, stream) == 1;
+}
+
+static int
+saveAnnotationIndex (const IndexBuilder *ib, const struct stat *source, const char *path) {
   int ok = 0;
-  char *path = makeFilePath(cldrAnnotationsDirectory, name, cldrAnnotationsExtension);
+  size_t count = ib->entries.count;
+  uint32_t *sorted = malloc(ARRAY_SIZE(sorted, count) + 1);
 
-  if (path) {
-    logMessage(LOG_DEBUG, "processing CLDR annotations file: %s", path);
-    int fd = open(path, O_RDONLY);
-
-    if (fd != -1) {
-      CLDR_DocumentParserObject *dpo = cldrNewDocumentParser(handler, data);
-
-      if (dpo) {
-        while (1) {
-          char buffer[0X2000];
-          size_t size = sizeof(buffer);
-          ssize_t count = read(fd, buffer, size);
-
-          if (count == -1) {
-            if (errno == EINTR) continue;
-            logMessage(LOG_WARNING, "CLDR read error: %s: %s", strerror(errno), path);
-            break;
-          }
+  if (sorted) {
+    {
+      SortedEntry *entries = malloc(ARRAY_SIZE(entries, count) + 1);
 
-          int final = count == 0;
-          if (!cldrParseText(dpo, buffer, count, final)) break;
+      if (!entries) {
+        logMallocError();
+        free(sorted);
+        return 0;
+      }
+
+      for (size_t number=0; number<count; number+=1) {
+        entries[number].sequence = &ib->strings.buffer[ib->entries.array[number].sequence];
+        entries[number].number = number;
+      }
+
+      qsort(entries, count, sizeof(*entries), sortIndexEntries);
+      for (size_t index=0; index<count; index+=1) sorted[index] = entries[index].number;
+      free(entries);
+    }
+
+    {
+      size_t length = strlen(path);
+      char temporary[length + 5];
+      FILE *stream;
+
+      snprintf(temporary, sizeof(temporary), "%s.new", path);
+
+      if ((stream = fopen(temporary, "wb"))) {
+        CLDR_IndexHeader header;
+
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, CLDR_INDEX_MAGIC, sizeof(header.magic));
+        header.count = count;
+        header.stringsSize = ib->strings.length;
+        header.sourceSize = source->st_size;
+        header.sourceTime = source->st_mtime;
+
+        if (writeIndexData(stream, &header, sizeof(header)) &&
+            writeIndexData(stream, ib->entries.array, ARRAY_SIZE(ib->entries.array, count)) &&
+            writeIndexData(stream, sorted, ARRAY_SIZE(sorted, count)) &&
+            writeIndexData(stream, ib->strings.buffer, ib->strings.length)) {
+          ok = 1;
+        } else {
+          logMessage(LOG_WARNING, "CLDR write error: %s: %s", strerror(errno), temporary);
+        }
+
+        if (fclose(stream) == EOF) {
+          if (ok) logMessage(LOG_WARNING, "CLDR write error: %s: %s", strerror(errno), temporary);
+          ok = 0;
+        }
 
-          if (final) {
-            ok = 1;
-            break;
+        if (ok) {
+          if (rename(temporary, path) != -1) {
+            logMessage(LOG_DEBUG, "CLDR annotations index written: %s", path);
+          } else {
+            logMessage(LOG_WARNING, "CLDR rename error: %s: %s", strerror(errno), path);
+            ok = 0;
           }
         }
 
-        cldrDestroyDocumentParser(dpo);
+        if (!ok) unlink(temporary);
+      } else {
+        logMessage(LOG_WARNING, "CLDR create error: %s: %s", strerror(errno), temporary);
       }
+    }
 
-      close(fd);
-      fd = -1;
-    } else {
-      logMessage(LOG_WARNING, "CLDR open error: %s: %s", strerror(errno), path);
+    free(sorted);
+  } else {
+    logMallocError();
+  }
 
-      if (errno == ENOENT) {
-        if (!isAbsolutePath(name)) {
-          if (!testDirectoryPath(cldrAnnotationsDirectory)) {
-            logPossibleCause("the package that defines the CLDR annotations directory is not installed");
-          }
+  return ok;
+}
+
+static int
+parseAnnotationsFile (
+  const char *name, const char *path,
+  CLDR_AnnotationHandler *handler, void *data
+) {
+  int ok = 0;
+
+  logMessage(LOG_DEBUG, "processing CLDR annotations file: %s", path);
+  int fd = open(path, O_RDONLY);
+
+  if (fd != -1) {
+    CLDR_DocumentParserObject *dpo = cldrNewDocumentParser(handler, data);
+
+    if (dpo) {
+      while (1) {
+        char buffer[0X2000];
+        size_t size = sizeof(buffer);
+        ssize_t count = read(fd, buffer, size);
+
+        if (count == -1) {
+          if (errno == EINTR) continue;
+          logMessage(LOG_WARNING, "CLDR read error: %s: %s", strerror(errno), path);
+          break;
+        }
+
+        int final = count == 0;
+        if (!cldrParseText(dpo, buffer, count, final)) break;
+
+        if (final) {
+          ok = 1;
+          break;
+        }
+      }
+
+      cldrDestroyDocumentParser(dpo);
+    }
+
+    close(fd);
+    fd = -1;
+  } else {
+    logMessage(LOG_WARNING, "CLDR open error: %s: %s", strerror(errno), path);
+
+    if (errno == ENOENT) {
+      if (!isAbsolutePath(name)) {
+        if (!testDirectoryPath(cldrAnnotationsDirectory)) {
+          logPossibleCause("the package that defines the CLDR annotations directory is not installed");
         }
       }
     }
+  }
+
+  return ok;
+}
+
+static int
+parseAndIndexFile (
+  const char *name, const char *sourcePath, const char *indexPath,
+  CLDR_AnnotationHandler *handler, void *data
+) {
+  IndexBuilder ib = {
+    .handler = handler,
+    .data = data
+  };
+
+  struct stat source;
+  int haveSource = getSourceStatus(sourcePath, &source);
+  int ok = parseAnnotationsFile(name, sourcePath, buildIndex, &ib);
+
+  if (ok && haveSource && !ib.isIncomplete) {
+    char *path = indexPath? strdup(indexPath): makeCachedIndexPath(sourcePath);
+
+    if (path) {
+      if (!saveAnnotationIndex(&ib, &source, path)) {
+        if (indexPath) ok = 0;
+      }
+
+      free(path);
+    } else if (indexPath) {
+      logMallocError();
+      ok = 0;
+    }
+  } else if (indexPath) {
+    ok = 0;
+  }
+
+  if (ib.entries.array) free(ib.entries.array);
+  if (ib.strings.buffer) free(ib.strings.buffer);
+  return ok;
+}
+
+int
+cldrMakeAnnotationIndex (const char *name, const char *indexPath) {
+  int ok = 0;
+  char *path = makeFilePath(cldrAnnotationsDirectory, name, cldrAnnotationsExtension);
+
+  if (path) {
+    ok = parseAndIndexFile(name, path, indexPath, NULL, NULL);
+    free(path);
+  }
+
+  return ok;
+}
+
+int
+cldrParseFile (
+  const char *name,
+  CLDR_AnnotationHandler *handler, void *data
+) {
+  int ok = 0;
+  char *path = makeFilePath(cldrAnnotationsDirectory, name, cldrAnnotationsExtension);
+
+  if (path) {
+    CLDR_AnnotationIndex *index = findAnnotationIndex(path);
+
+    if (index) {
+      ok = cldrProcessAnnotationIndex(index, handler, data);
+      cldrCloseAnnotationIndex(index);
+    } else {
+      ok = parseAndIndexFile(name, path, NULL, handler, data);
+    }
 
     free(path);
   }
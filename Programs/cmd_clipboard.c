@@ -30,6 +30,7 @@
 #include "clipboard.h"
 #include "brl_cmds.h"
 #include "scr.h"
+#include "scr_snapshot.h"
 #include "routing.h"
 #include "file.h"
 #include "datafile.h"
@@ -435,6 +436,35 @@ findCharacters (const wchar_t **address, size_t *length, const wchar_t *characte
   return 0;
 }
 
+/* Scan the whole row-major screen text once, rejecting matches that would
+ * wrap from one row into the next. When searching backward the last match
+ * before the end of the range is the one that's wanted.
+ */
+static int
+findScreenCharacters (
+  const wchar_t *text, size_t from, size_t to,
+  const wchar_t *characters, size_t count,
+  int last, size_t *offset
+) {
+  const wchar_t *address = text + from;
+  size_t length = (to > from)? (to - from): 0;
+  int found = 0;
+
+  while (findCharacters(&address, &length, characters, count)) {
+    size_t position = address - text;
+
+    if (((position % scr.cols) + count) <= scr.cols) {
+      *offset = position;
+      found = 1;
+      if (!last) break;
+    }
+
+    ++address, --length;
+  }
+
+  return found;
+}
+
 static int
 handleClipboardCommands (int command, void *data) {
   ClipboardCommandData *ccd = data;
@@ -474,7 +504,7 @@ handleClipboardCommands (int command, void *data) {
 
           if (count <= scr.cols) {
             int line = ses->winy;
-            wchar_t buffer[scr.cols];
+            int lastLine = scr.rows - brl.textRows;
             wchar_t characters[count];
 
             {
@@ -482,41 +512,72 @@ handleClipboardCommands (int command, void *data) {
               for (i=0; i<count; i+=1) characters[i] = towlower(cpbBuffer[i]);
             }
 
-            while ((line >= 0) && (line <= (int)(scr.rows - brl.textRows))) {
-              const wchar_t *address = buffer;
-              size_t length = scr.cols;
-              readScreenText(0, line, length, 1, buffer);
+            const wchar_t *text = ((line >= 0) && (line <= lastLine))?
+                                  getScreenSnapshotFoldedText(scr.cols, (lastLine + 1)):
+                                  NULL;
 
-              {
-                for (size_t i=0; i<length; i+=1) buffer[i] = towlower(buffer[i]);
+            if (text) {
+              size_t from;
+              size_t to;
+
+              if (increment < 0) {
+                size_t end = ses->winx + count - 1;
+                if (end > scr.cols) end = scr.cols;
+
+                from = 0;
+                to = (line * scr.cols) + end;
+              } else {
+                size_t start = ses->winx + textCount;
+                if (start > scr.cols) start = scr.cols;
+
+                from = (line * scr.cols) + start;
+                to = (lastLine + 1) * scr.cols;
               }
 
-              if (line == ses->winy) {
-                if (increment < 0) {
-                  int end = ses->winx + count - 1;
-                  if (end < length) length = end;
-                } else {
-                  int start = ses->winx + textCount;
-                  if (start > length) start = length;
-                  address += start;
-                  length -= start;
-                }
+              size_t offset;
+
+              if (findScreenCharacters(text, from, to, characters, count, (increment < 0), &offset)) {
+                ses->winy = offset / scr.cols;
+                ses->winx = (offset % scr.cols) / textCount * textCount;
+                found = 1;
               }
+            } else {
+              wchar_t buffer[scr.cols];
+
+              while ((line >= 0) && (line <= lastLine)) {
+                const wchar_t *address = buffer;
+                size_t length = scr.cols;
 
-              if (findCharacters(&address, &length, characters, count)) {
-                if (increment < 0) {
-                  while (findCharacters(&address, &length, characters, count)) {
-                    ++address, --length;
+                readScreenText(0, line, length, 1, buffer);
+                for (size_t i=0; i<length; i+=1) buffer[i] = towlower(buffer[i]);
+
+                if (line == ses->winy) {
+                  if (increment < 0) {
+                    int end = ses->winx + count - 1;
+                    if (end < length) length = end;
+                  } else {
+                    int start = ses->winx + textCount;
+                    if (start > length) start = length;
+                    address += start;
+                    length -= start;
                   }
                 }
 
-                ses->winy = line;
-                ses->winx = (address - buffer) / textCount * textCount;
-                found = 1;
-                break;
-              }
+                if (findCharacters(&address, &length, characters, count)) {
+                  if (increment < 0) {
+                    while (findCharacters(&address, &length, characters, count)) {
+                      ++address, --length;
+                    }
+                  }
+
+                  ses->winy = line;
+                  ses->winx = (address - buffer) / textCount * textCount;
+                  found = 1;
+                  break;
+                }
 
-              line += increment;
+                line += increment;
+              }
             }
           }
 
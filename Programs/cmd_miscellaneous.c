@@ -191,9 +191,10 @@ handleMiscellaneousCommands (int command, void *data) {
         unsigned int pageCount = getHelpPageCount();
 
         while (pageNumber <= pageCount) {
-          if (setHelpPageNumber(pageNumber))
-            if (getHelpLineCount())
-              break;
+          if (setHelpPageNumber(pageNumber)) {
+            prepareHelpPage(pageNumber);
+            if (getHelpLineCount()) break;
+          }
 
           pageNumber += 1;
         }
@@ -19,6 +19,7 @@
 #include "prologue.h"
 
 #include <stdio.h>
+#include <string.h>
 
 #include "log.h"
 #include "alert.h"
@@ -33,6 +34,7 @@
 #include "prefs.h"
 #include "routing.h"
 #include "scr.h"
+#include "scr_snapshot.h"
 #include "core.h"
 
 static int
@@ -53,6 +55,19 @@ canMoveDown (void) {
   return (ses->winy + brl.textRows) < scr.rows;
 }
 
+static int
+haveDifferentRowHashes (int row1, int row2, int width, IsSameCharacter isSameCharacter) {
+  const ScreenRowHash *hash1 = getScreenSnapshotRowHash(row1, width);
+  const ScreenRowHash *hash2 = getScreenSnapshotRowHash(row2, width);
+
+  if (hash1 && hash2) {
+    if (isSameCharacter == isSameText) return hash1->text != hash2->text;
+    if (isSameCharacter == isSameAttributes) return hash1->attributes != hash2->attributes;
+  }
+
+  return 0;
+}
+
 static int
 toDifferentLine (
   IsSameCharacter isSameCharacter,
@@ -60,15 +75,22 @@ toDifferentLine (
   int amount, int from, int width
 ) {
   if (canMoveWindow()) {
-    ScreenCharacter characters1[width];
+    int row1 = ses->winy;
+    ScreenCharacter buffer1[from + width];
+    const ScreenCharacter *characters1;
     unsigned int skipped = 0;
 
     if ((isSameCharacter == isSameText) && ses->displayMode) isSameCharacter = isSameAttributes;
-    readScreen(from, ses->winy, width, 1, characters1);
+    characters1 = &getScreenRow(row1, (from + width), buffer1)[from];
 
     do {
-      ScreenCharacter characters2[width];
-      readScreen(from, ses->winy+=amount, width, 1, characters2);
+      ScreenCharacter buffer2[from + width];
+      const ScreenCharacter *characters2;
+
+      ses->winy += amount;
+
+      if (!from && haveDifferentRowHashes(row1, ses->winy, width, isSameCharacter)) return 1;
+      characters2 = &getScreenRow(ses->winy, (from + width), buffer2)[from];
 
       if (!isSameRow(characters1, characters2, width, isSameCharacter) ||
           (showScreenCursor() && (scr.posy == ses->winy) &&
@@ -164,8 +186,8 @@ findRow (int column, int increment, RowTester test, void *data) {
 static int
 testIndent (int column, int row, void *data UNUSED) {
   int count = column+1;
-  ScreenCharacter characters[count];
-  readScreenRow(row, count, characters);
+  ScreenCharacter buffer[count];
+  const ScreenCharacter *characters = getScreenRow(row, count, buffer);
 
   while (column >= 0) {
     wchar_t text = characters[column].text;
@@ -178,12 +200,40 @@ testIndent (int column, int row, void *data UNUSED) {
 
 static RGX_Object *promptPatterns = NULL;
 
+typedef struct {
+  wchar_t *text;
+  uint32_t hash;
+  int width;
+  unsigned char isPrompt;
+} PromptMatchEntry;
+
+/* Rows which haven't changed since they were last matched needn't be
+ * matched again - the entries are indexed by the low-order bits of the
+ * hash of the row's text, and keep a copy of the text so that rows whose
+ * hashes collide aren't mistaken for one another.
+ */
+static PromptMatchEntry promptMatchCache[0X100];
+
+static void
+resetPromptMatchCache (void) {
+  PromptMatchEntry *entry = promptMatchCache;
+  const PromptMatchEntry *end = entry + ARRAY_COUNT(promptMatchCache);
+
+  while (entry < end) {
+    if (entry->text) free(entry->text);
+    memset(entry, 0, sizeof(*entry));
+    entry += 1;
+  }
+}
+
 static void
 exitPromptPatterns (void *data) {
   if (promptPatterns) {
     rgxDestroyObject(promptPatterns);
     promptPatterns = NULL;
   }
+
+  resetPromptMatchCache();
 }
 
 int
@@ -192,8 +242,11 @@ addPromptPattern (const char *string) {
     if (!(promptPatterns = rgxNewObject(NULL))) return 0;
     onProgramExit("prompt-patterns", exitPromptPatterns, NULL);
     rgxCompileOption(promptPatterns, RGX_OPTION_SET, RGX_COMPILE_ANCHOR_START);
+    rgxCombinePatterns(promptPatterns, RGX_OPTION_SET);
   }
 
+  resetPromptMatchCache();
+
   RGX_Matcher *matcher = rgxAddPatternUTF8(
     promptPatterns, string, NULL, NULL
   );
@@ -207,8 +260,8 @@ testPromptOriginal (int column, int row, void *data) {
   if (!column) return 0;
 
   int length = column + 1;
-  ScreenCharacter characters[length];
-  readScreenRow(row, length, characters);
+  ScreenCharacter buffer[length];
+  const ScreenCharacter *characters = getScreenRow(row, length, buffer);
 
   const ScreenCharacter *prompt = data;
   return isSameRow(characters, prompt, length, isSameText);
@@ -220,8 +273,8 @@ testPromptPatterns (int column, int row, void *data) {
   wchar_t text[length];
 
   {
-    ScreenCharacter characters[length];
-    readScreenRow(row, length, characters);
+    ScreenCharacter buffer[length];
+    const ScreenCharacter *characters = getScreenRow(row, length, buffer);
 
     const ScreenCharacter *from = characters;
     const ScreenCharacter *end = from + length;
@@ -230,7 +283,45 @@ testPromptPatterns (int column, int row, void *data) {
     while (from < end) *to++ = from++->text;
   }
 
-  return !!rgxMatchTextCharacters(promptPatterns, text, length, NULL, NULL);
+  PromptMatchEntry *entry = NULL;
+
+  {
+    const ScreenRowHash *hash = getScreenSnapshotRowHash(row, length);
+
+    if (hash) {
+      entry = &promptMatchCache[hash->text % ARRAY_COUNT(promptMatchCache)];
+
+      if (entry->text && (entry->hash == hash->text) && (entry->width == length)) {
+        if (wmemcmp(entry->text, text, length) == 0) return entry->isPrompt;
+      }
+
+      if (entry->width != length) {
+        if (entry->text) free(entry->text);
+        entry->text = NULL;
+        entry->width = 0;
+      }
+
+      if (!entry->text) {
+        if ((entry->text = malloc(ARRAY_SIZE(entry->text, length)))) {
+          entry->width = length;
+        } else {
+          logMallocError();
+          entry = NULL;
+        }
+      }
+
+      if (entry) entry->hash = hash->text;
+    }
+  }
+
+  int isPrompt = !!rgxMatchTextCharacters(promptPatterns, text, length, NULL, NULL);
+
+  if (entry) {
+    wmemcpy(entry->text, text, length);
+    entry->isPrompt = isPrompt;
+  }
+
+  return isPrompt;
 }
 
 static void
@@ -407,13 +498,13 @@ handleNavigationCommands (int command, void *data) {
       } State;
 
       State state = STARTING;
-      ScreenCharacter characters[scr.cols];
+      ScreenCharacter buffer[scr.cols];
       int line = ses->winy;
 
       while (1) {
+        const ScreenCharacter *characters = getScreenRow(line, scr.cols, buffer);
         int isBlankLine;
 
-        readScreenRow(line, scr.cols, characters);
         isBlankLine = isAllSpaceCharacters(characters, scr.cols);
 
         switch (state) {
@@ -452,14 +543,14 @@ handleNavigationCommands (int command, void *data) {
 
     case BRL_CMD_NXPGRPH: {
       int width = scr.cols;
-      ScreenCharacter characters[width];
+      ScreenCharacter buffer[width];
 
       int found = 0;
       int findBlankLine = 1;
       int line = ses->winy;
 
       while (line < scr.rows) {
-        readScreenRow(line, width, characters);
+        const ScreenCharacter *characters = getScreenRow(line, width, buffer);
 
         if (isAllSpaceCharacters(characters, width) == findBlankLine) {
           if (!findBlankLine) {
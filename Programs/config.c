@@ -34,6 +34,7 @@
 #include "pgmprivs.h"
 #include "lock.h"
 #include "activity.h"
+#include "startup.h"
 #include "update.h"
 #include "cmd.h"
 #include "cmd_navigation.h"
@@ -979,46 +980,141 @@ disableKeyboardMonitor (void) {
 }
 */
 
-static unsigned int brailleHelpPageNumber = 0;
-static unsigned int keyboardHelpPageNumber = 0;
+typedef struct {
+  const char *name;
+  void (*begin) (void);
+
+  unsigned int pageNumber;
+  unsigned char isPending;
+
+  KeyTableLister *lister;
+  AsyncHandle alarm;
+} HelpPageGenerator;
+
+#define HELP_PAGE_SLICE_TIME 10
+
+static void makeBrailleHelpPage (void);
+static void makeKeyboardHelpPage (void);
+
+static HelpPageGenerator brailleHelpPage = {
+  .name = "braille",
+  .begin = makeBrailleHelpPage
+};
+
+static HelpPageGenerator keyboardHelpPage = {
+  .name = "keyboard",
+  .begin = makeKeyboardHelpPage
+};
 
 static int
-enableHelpPage (unsigned int *pageNumber) {
-  if (!*pageNumber) {
+reserveHelpPage (HelpPageGenerator *hpg) {
+  if (!hpg->pageNumber) {
     if (!constructHelpScreen()) return 0;
-    if (!(*pageNumber = addHelpPage())) return 0;
+    if (!(hpg->pageNumber = addHelpPage())) return 0;
   }
 
-  return setHelpPageNumber(*pageNumber);
+  return 1;
 }
 
 static int
-enableBrailleHelpPage (void) {
-  return enableHelpPage(&brailleHelpPageNumber);
+isHelpPageShown (const HelpPageGenerator *hpg) {
+  return isSpecialScreen(SCR_HELP) && (getHelpPageNumber() == hpg->pageNumber);
 }
 
-static int
-enableKeyboardHelpPage (void) {
-  return enableHelpPage(&keyboardHelpPageNumber);
+static void
+stopHelpPageGenerator (HelpPageGenerator *hpg) {
+  if (hpg->alarm) {
+    asyncCancelRequest(hpg->alarm);
+    hpg->alarm = NULL;
+  }
+
+  if (hpg->lister) {
+    destroyKeyTableLister(hpg->lister);
+    hpg->lister = NULL;
+  }
 }
 
 static void
-disableHelpPage (unsigned int pageNumber) {
-  if (pageNumber) {
-    if (setHelpPageNumber(pageNumber)) {
+disableHelpPage (HelpPageGenerator *hpg) {
+  hpg->isPending = 0;
+  stopHelpPageGenerator(hpg);
+
+  if (hpg->pageNumber) {
+    unsigned int pageNumber = getHelpPageNumber();
+
+    if (setHelpPageNumber(hpg->pageNumber)) {
       clearHelpPage();
+      setHelpPageNumber(pageNumber);
     }
   }
 }
 
 static void
 disableBrailleHelpPage (void) {
-  disableHelpPage(brailleHelpPageNumber);
+  disableHelpPage(&brailleHelpPage);
 }
 
 static void
 disableKeyboardHelpPage (void) {
-  disableHelpPage(keyboardHelpPageNumber);
+  disableHelpPage(&keyboardHelpPage);
+}
+
+static void
+finishHelpPage (HelpPageGenerator *hpg) {
+  if (!getHelpLineCount()) {
+    addHelpLine(WS_C("help not available"));
+    message(NULL, gettext("no key bindings"), 0);
+  }
+
+  logMessage(LOG_DEBUG, "%s help page generated: %u lines",
+             hpg->name, getHelpLineCount());
+}
+
+static void scheduleHelpPageSlice (HelpPageGenerator *hpg);
+
+static void
+listHelpPageSlice (HelpPageGenerator *hpg) {
+  unsigned int pageNumber = getHelpPageNumber();
+
+  if (setHelpPageNumber(hpg->pageNumber)) {
+    TimePeriod period;
+    int done = 0;
+
+    startTimePeriod(&period, HELP_PAGE_SLICE_TIME);
+
+    do {
+      if (!listKeyTableSection(hpg->lister, &done)) {
+        done = 1;
+        break;
+      }
+    } while (!done && (!getHelpLineCount() || !afterTimePeriod(&period, NULL)));
+
+    if (done) {
+      stopHelpPageGenerator(hpg);
+      finishHelpPage(hpg);
+    } else {
+      scheduleHelpPageSlice(hpg);
+    }
+
+    setHelpPageNumber(pageNumber);
+    if (isHelpPageShown(hpg)) scheduleUpdate("help page extended");
+  }
+}
+
+ASYNC_ALARM_CALLBACK(handleHelpPageSlice) {
+  HelpPageGenerator *hpg = parameters->data;
+
+  asyncDiscardHandle(hpg->alarm);
+  hpg->alarm = NULL;
+
+  listHelpPageSlice(hpg);
+}
+
+static void
+scheduleHelpPageSlice (HelpPageGenerator *hpg) {
+  if (!asyncNewRelativeAlarm(&hpg->alarm, 0, handleHelpPageSlice, hpg)) {
+    stopHelpPageGenerator(hpg);
+  }
 }
 
 static int
@@ -1026,6 +1122,13 @@ handleWcharHelpLine (const wchar_t *line, void *data UNUSED) {
   return addHelpLine(line);
 }
 
+static void
+listHelpPage (HelpPageGenerator *hpg, KeyTable *table) {
+  if ((hpg->lister = newKeyTableLister(table, NULL, handleWcharHelpLine, NULL))) {
+    listHelpPageSlice(hpg);
+  }
+}
+
 static int
 handleUtf8HelpLine (const LineHandlerParameters *parameters) {
   const char *utf8 = parameters->line.text;
@@ -1057,11 +1160,13 @@ makeBrailleKeyTablePath (void) {
 }
 
 static void
-makeBrailleHelpPage (const char *keyTablePath) {
-  if (enableBrailleHelpPage()) {
-    if (brl.keyTable) {
-      listKeyTable(brl.keyTable, NULL, handleWcharHelpLine, NULL);
-    } else {
+makeBrailleHelpPage (void) {
+  if (brl.keyTable) {
+    listHelpPage(&brailleHelpPage, brl.keyTable);
+  } else {
+    char *keyTablePath = makeBrailleKeyTablePath();
+
+    if (keyTablePath) {
       char *keyHelpPath = replaceFileExtension(keyTablePath, KEY_HELP_EXTENSION);
 
       if (keyHelpPath) {
@@ -1073,19 +1178,62 @@ makeBrailleHelpPage (const char *keyTablePath) {
 
         free(keyHelpPath);
       }
-    }
 
-    if (!getHelpLineCount()) {
-      addHelpLine(WS_C("help not available"));
-      message(NULL, gettext("no key bindings"), 0);
+      free(keyTablePath);
     }
+
+    finishHelpPage(&brailleHelpPage);
   }
 }
 
 static void
 makeKeyboardHelpPage (void) {
-  if (enableKeyboardHelpPage()) {
-    listKeyTable(keyboardTable, NULL, handleWcharHelpLine, NULL);
+  if (keyboardTable) listHelpPage(&keyboardHelpPage, keyboardTable);
+}
+
+static void
+beginHelpPage (HelpPageGenerator *hpg) {
+  unsigned int pageNumber = getHelpPageNumber();
+
+  hpg->isPending = 0;
+
+  if (setHelpPageNumber(hpg->pageNumber)) {
+    hpg->begin();
+    setHelpPageNumber(pageNumber);
+  }
+}
+
+static void
+scheduleHelpPage (HelpPageGenerator *hpg) {
+  if (reserveHelpPage(hpg)) {
+    hpg->isPending = 1;
+    if (isHelpPageShown(hpg)) beginHelpPage(hpg);
+  }
+}
+
+static void
+scheduleBrailleHelpPage (void) {
+  scheduleHelpPage(&brailleHelpPage);
+}
+
+static void
+scheduleKeyboardHelpPage (void) {
+  scheduleHelpPage(&keyboardHelpPage);
+}
+
+void
+prepareHelpPage (unsigned int pageNumber) {
+  HelpPageGenerator *const generators[] = {
+    &brailleHelpPage,
+    &keyboardHelpPage
+  };
+
+  for (unsigned int index=0; index<ARRAY_COUNT(generators); index+=1) {
+    HelpPageGenerator *hpg = generators[index];
+
+    if (hpg->isPending && (hpg->pageNumber == pageNumber)) {
+      beginHelpPage(hpg);
+    }
   }
 }
 
@@ -1108,11 +1256,14 @@ changeKeyboardTable (const char *name) {
 
     if (path) {
       logMessage(LOG_DEBUG, "compiling keyboard table: %s", path);
+      beginStartupPhase("keyboard table");
 
       if (!(table = compileKeyTable(path, KEY_NAME_TABLES(keyboard)))) {
         logMessage(LOG_ERR, "%s: %s", gettext("cannot compile keyboard table"), path);
       }
 
+      endStartupPhase();
+
       free(path);
     }
 
@@ -1120,8 +1271,8 @@ changeKeyboardTable (const char *name) {
   }
 
   if (keyboardTable) {
-    destroyKeyTable(keyboardTable);
     disableKeyboardHelpPage();
+    destroyKeyTable(keyboardTable);
   }
 
   if ((keyboardTable = table)) {
@@ -1130,7 +1281,7 @@ changeKeyboardTable (const char *name) {
     setKeyTableLogLabel(keyboardTable, "kbd");
     setLogKeyEventsFlag(keyboardTable, &LOG_CATEGORY_FLAG(KEYBOARD_KEYS));
 
-    makeKeyboardHelpPage();
+    scheduleKeyboardHelpPage();
   }
 
   changeStringSetting(&opt_keyboardTable, name);
@@ -1525,7 +1676,11 @@ constructBrailleDriver (void) {
 
         if (keyTablePath) {
           if (brl.keyNames) {
-            if ((brl.keyTable = compileKeyTable(keyTablePath, brl.keyNames))) {
+            beginStartupPhase("braille key table");
+            brl.keyTable = compileKeyTable(keyTablePath, brl.keyNames);
+            endStartupPhase();
+
+            if (brl.keyTable) {
               logMessage(LOG_INFO, "%s: %s", gettext("Key Table"), keyTablePath);
 
               setKeyTableLogLabel(brl.keyTable, "brl");
@@ -1536,7 +1691,7 @@ constructBrailleDriver (void) {
             }
           }
 
-          makeBrailleHelpPage(keyTablePath);
+          scheduleBrailleHelpPage();
           free(keyTablePath);
         }
       }
@@ -1575,7 +1730,11 @@ isBrailleOnline (void) {
 
 static int
 initializeBrailleDriver (const char *code, int verify) {
-  if ((braille = loadBrailleDriver(code, &brailleObject, opt_driversDirectory))) {
+  beginStartupPhase("braille driver load");
+  braille = loadBrailleDriver(code, &brailleObject, opt_driversDirectory);
+  endStartupPhase();
+
+  if (braille) {
     brailleDriverParameters = getParameters(braille->parameters,
                                             braille->definition.code,
                                             brailleParameters);
@@ -1790,7 +1949,14 @@ prepareBrailleDriverActivity (void *data) {
 
 static int
 startBrailleDriverActivity (void *data) {
-  return startBrailleDriver();
+  int started;
+
+  beginStartupPhase("braille driver");
+  started = startBrailleDriver();
+  endStartupPhase();
+
+  if (!started) endStartup("braille driver not started");
+  return started;
 }
 
 static void
@@ -2137,7 +2303,13 @@ prepareSpeechDriverActivity (void *data) {
 
 static int
 startSpeechDriverActivity (void *data) {
-  return startSpeechDriver();
+  int started;
+
+  beginStartupPhase("speech driver");
+  started = startSpeechDriver();
+  endStartupPhase();
+
+  return started;
 }
 
 static void
@@ -2343,7 +2515,13 @@ prepareScreenDriverActivity (void *data) {
 
 static int
 startScreenDriverActivity (void *data) {
-  return startScreenDriver();
+  int started;
+
+  beginStartupPhase("screen driver");
+  started = startScreenDriver();
+  endStartupPhase();
+
+  return started;
 }
 
 static void
@@ -2770,8 +2948,10 @@ brlttyStart (void) {
   logProperty(opt_configurationFile, "configurationFile", gettext("Configuration File"));
   logProperty(opt_preferencesFile, "preferencesFile", gettext("Preferences File"));
 
+  beginStartupPhase("preferences");
   resetPreferences();
   loadPreferences();
+  endStartupPhase();
 
   if (opt_promptPatterns && *opt_promptPatterns) {
     int count;
@@ -2792,6 +2972,7 @@ brlttyStart (void) {
   logProperty(opt_tablesDirectory, "tablesDirectory", gettext("Tables Directory"));
 
   /* handle text table option */
+  beginStartupPhase("text table");
   int usingInternalTextTable = 0;
   if (*opt_textTable) {
     if (strcmp(opt_textTable, optionOperand_autodetect) == 0) {
@@ -2814,10 +2995,13 @@ brlttyStart (void) {
     usingInternalTextTable = 1;
   }
 
+  endStartupPhase();
   logProperty(opt_textTable, "textTable", gettext("Text Table"));
   onProgramExit("text-table", exitTextTable, NULL);
 
   /* handle attributes table option */
+  beginStartupPhase("attributes table");
+
   if (*opt_attributesTable) {
     if (!changeAttributesTable(opt_attributesTable)) {
       changeStringSetting(&opt_attributesTable, "");
@@ -2828,10 +3012,14 @@ brlttyStart (void) {
     changeStringSetting(&opt_attributesTable, ATTRIBUTES_TABLE);
   }
 
+  endStartupPhase();
+
   logProperty(opt_attributesTable, "attributesTable", gettext("Attributes Table"));
   onProgramExit("attributes-table", exitAttributesTable, NULL);
 
   /* handle contraction table option */
+  beginStartupPhase("contraction table");
+
   if (*opt_contractionTable) {
     if (strcmp(opt_contractionTable, optionOperand_autodetect) == 0) {
       changeStringSetting(&opt_contractionTable, "");
@@ -2860,6 +3048,8 @@ brlttyStart (void) {
     }
   }
 
+  endStartupPhase();
+
   logProperty(opt_contractionTable, "contractionTable", gettext("Contraction Table"));
   onProgramExit("contraction-table", exitContractionTable, NULL);
 
@@ -2918,7 +3108,9 @@ brlttyStart (void) {
   }
 #endif /* ENABLE_SPEECH_SUPPORT */
 
+  beginStartupPhase("API server");
   startApiServer();
+  endStartupPhase();
 
   if (!opt_verify) notifyServiceReady();
 
@@ -2980,18 +3172,13 @@ endLanguageProfile (void) {
 #endif /* ENABLE_SPEECH_SUPPORT */
 
   if (brl.keyTable) {
-    char *path = makeBrailleKeyTablePath();
-
-    if (path) {
-      disableBrailleHelpPage();
-      makeBrailleHelpPage(path);
-      free(path);
-    }
+    disableBrailleHelpPage();
+    scheduleBrailleHelpPage();
   }
 
   if (keyboardTable) {
     disableKeyboardHelpPage();
-    makeKeyboardHelpPage();
+    scheduleKeyboardHelpPage();
   }
 
   return 1;
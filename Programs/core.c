@@ -65,12 +65,14 @@
 #include "utf8.h"
 #include "unicode.h"
 #include "scr.h"
+#include "scr_snapshot.h"
 #include "update.h"
 #include "ses.h"
 #include "brl.h"
 #include "brl_utils.h"
 #include "prefs.h"
 #include "api_control.h"
+#include "startup.h"
 #include "core.h"
 
 #ifdef ENABLE_SPEECH_SUPPORT
@@ -185,6 +187,7 @@ preprocessCommand (void) {
     pre->speechColumn = ses->spkx;
     pre->speechRow = ses->spky;
 
+    invalidateScreenSnapshot();
     suspendUpdates();
     return pre;
   } else {
@@ -1429,7 +1432,7 @@ exitSessions (void *data) {
 
 static AsyncEvent *addCoreTaskEvent = NULL;
 
-static int
+int
 startCoreTasks (void) {
   if (!addCoreTaskEvent) {
     if (!(addCoreTaskEvent = asyncNewAddTaskEvent())) {
@@ -1440,7 +1443,7 @@ startCoreTasks (void) {
   return 1;
 }
 
-static void
+void
 stopCoreTasks (void) {
   if (addCoreTaskEvent) {
     asyncDiscardEvent(addCoreTaskEvent);
@@ -1571,8 +1574,15 @@ brlttyConstruct (int argc, char *argv[]) {
     srand(now.seconds ^ now.nanoseconds);
   }
 
+  beginStartup();
+
   {
-    ProgramExitStatus exitStatus = brlttyPrepare(argc, argv);
+    ProgramExitStatus exitStatus;
+
+    beginStartupPhase("prepare");
+    exitStatus = brlttyPrepare(argc, argv);
+    endStartupPhase();
+
     if (exitStatus != PROG_EXIT_SUCCESS) return exitStatus;
   }
 
@@ -1617,7 +1627,12 @@ brlttyConstruct (int argc, char *argv[]) {
   suspendUpdates();
 
   {
-    ProgramExitStatus exitStatus = brlttyStart();
+    ProgramExitStatus exitStatus;
+
+    beginStartupPhase("start");
+    exitStatus = brlttyStart();
+    endStartupPhase();
+
     if (exitStatus != PROG_EXIT_SUCCESS) return exitStatus;
   }
 
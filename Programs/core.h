@@ -192,6 +192,7 @@ extern void forgetDevices (void);
 
 extern void reconfigureBrailleWindow (void);
 extern int haveStatusCells (void);
+extern void prepareHelpPage (unsigned int pageNumber);
 
 typedef enum {
   SCT_WORD,
@@ -232,6 +233,8 @@ extern const ProfileDescriptor languageProfile;
 
 #define CORE_TASK_CALLBACK(name) void name (void *data)
 typedef CORE_TASK_CALLBACK(CoreTaskCallback);
+extern int startCoreTasks (void);
+extern void stopCoreTasks (void);
 extern int runCoreTask (CoreTaskCallback *callback, void *data, int wait);
 
 #ifdef __cplusplus
@@ -23,6 +23,13 @@
 #include "crc_generate.h"
 #include "crc_internal.h"
 #include "log.h"
+#include "lock.h"
+#include "program.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define CRC_HAVE_FOLDING
+#include <immintrin.h>
+#endif /* carry-less multiplication */
 
 crc_t
 crcMostSignificantBit (unsigned int width) {
@@ -105,6 +112,299 @@ crcMakeRemainderCache (CRCProperties *properties, const CRCAlgorithm *algorithm)
   }
 }
 
+static void
+crcFillSliceTables (
+  crc_t (*tables)[CRC_BYTE_INDEXED_TABLE_SIZE],
+  const CRCProperties *properties, const CRCAlgorithm *algorithm
+) {
+  crc_t *first = tables[0];
+
+  if (algorithm->reflectData) {
+    /* The register holds the reflected value so that data bytes needn't be
+     * reflected - the low-order byte is the next one to be divided.
+     */
+    for (unsigned int byte=0; byte<=UINT8_MAX; byte+=1) {
+      crc_t remainder = properties->remainderCache[crcReflectBits(byte, CRC_BYTE_WIDTH)];
+      crcReflectValue(&remainder, algorithm);
+      first[byte] = remainder;
+    }
+
+    for (unsigned int table=1; table<CRC_SLICE_TABLE_COUNT; table+=1) {
+      const crc_t *previous = tables[table - 1];
+      crc_t *current = tables[table];
+
+      for (unsigned int byte=0; byte<=UINT8_MAX; byte+=1) {
+        crc_t remainder = previous[byte];
+        current[byte] = (remainder >> CRC_BYTE_WIDTH) ^ first[remainder & UINT8_MAX];
+      }
+    }
+  } else {
+    /* The register holds the value in its high-order bits so that the next
+     * byte to be divided is always the most significant one.
+     */
+    for (unsigned int byte=0; byte<=UINT8_MAX; byte+=1) {
+      first[byte] = properties->remainderCache[byte] << properties->sliceShift;
+    }
+
+    for (unsigned int table=1; table<CRC_SLICE_TABLE_COUNT; table+=1) {
+      const crc_t *previous = tables[table - 1];
+      crc_t *current = tables[table];
+
+      for (unsigned int byte=0; byte<=UINT8_MAX; byte+=1) {
+        crc_t remainder = previous[byte];
+        current[byte] = (remainder << CRC_BYTE_WIDTH) ^ first[remainder >> 24];
+      }
+    }
+  }
+}
+
+/* The slicing tables only depend upon the width, the polynomial, and whether
+ * or not the data is reflected. They're made the first time that an
+ * algorithm is used and are then shared by all of its generators.
+ */
+typedef struct CRCSliceTablesEntryStruct CRCSliceTablesEntry;
+
+struct CRCSliceTablesEntryStruct {
+  CRCSliceTablesEntry *next;
+
+  unsigned int checksumWidth;
+  crc_t generatorPolynomial;
+  unsigned char reflectData;
+
+  crc_t tables[CRC_SLICE_TABLE_COUNT][CRC_BYTE_INDEXED_TABLE_SIZE];
+};
+
+static CRCSliceTablesEntry *crcSliceTablesEntries = NULL;
+
+static LockDescriptor *
+crcGetSliceTablesLock (void) {
+  static LockDescriptor *lock = NULL;
+  return getLockDescriptor(&lock, "crc-slice-tables");
+}
+
+static void
+crcExitSliceTables (void *data) {
+  while (crcSliceTablesEntries) {
+    CRCSliceTablesEntry *entry = crcSliceTablesEntries;
+    crcSliceTablesEntries = entry->next;
+    free(entry);
+  }
+}
+
+static CRCSliceTablesEntry *
+crcGetSliceTablesEntry (const CRCProperties *properties, const CRCAlgorithm *algorithm) {
+  CRCSliceTablesEntry *entry = crcSliceTablesEntries;
+
+  while (entry) {
+    if ((entry->checksumWidth == algorithm->checksumWidth) &&
+        (entry->generatorPolynomial == algorithm->generatorPolynomial) &&
+        (entry->reflectData == !!algorithm->reflectData)) {
+      return entry;
+    }
+
+    entry = entry->next;
+  }
+
+  if ((entry = malloc(sizeof(*entry)))) {
+    entry->checksumWidth = algorithm->checksumWidth;
+    entry->generatorPolynomial = algorithm->generatorPolynomial;
+    entry->reflectData = !!algorithm->reflectData;
+    crcFillSliceTables(entry->tables, properties, algorithm);
+
+    if (!crcSliceTablesEntries) onProgramExit("crc-slice-tables", crcExitSliceTables, NULL);
+    entry->next = crcSliceTablesEntries;
+    crcSliceTablesEntries = entry;
+  } else {
+    logMallocError();
+  }
+
+  return entry;
+}
+
+static void
+crcMakeSliceTables (CRCProperties *properties, const CRCAlgorithm *algorithm) {
+  properties->sliceShift = algorithm->reflectData? 0:
+                           (sizeof(crc_t) * CRC_BYTE_WIDTH) - algorithm->checksumWidth;
+
+  {
+    CRCSliceTablesEntry *entry;
+
+    obtainExclusiveLock(crcGetSliceTablesLock());
+      entry = crcGetSliceTablesEntry(properties, algorithm);
+    releaseLock(crcGetSliceTablesLock());
+
+    properties->sliceTables = entry? (const crc_t (*)[CRC_BYTE_INDEXED_TABLE_SIZE])entry->tables: NULL;
+  }
+}
+
+#ifdef CRC_HAVE_FOLDING
+typedef enum {
+  CRC_FOLD_BY_4_LOW,
+  CRC_FOLD_BY_4_HIGH,
+  CRC_FOLD_BY_1_LOW,
+  CRC_FOLD_BY_1_HIGH,
+  CRC_FOLD_TO_32,
+  CRC_BARRETT_POLYNOMIAL,
+  CRC_BARRETT_QUOTIENT,
+} CRCFoldingConstant;
+
+static uint64_t
+crcReflectWideBits (uint64_t fromValue, unsigned int width) {
+  uint64_t fromBit = UINT64_C(1) << (width - 1);
+  uint64_t toBit = 1;
+  uint64_t toValue = 0;
+
+  while (fromBit) {
+    if (fromValue & fromBit) toValue |= toBit;
+    fromBit >>= 1;
+    toBit <<= 1;
+  }
+
+  return toValue;
+}
+
+static uint64_t
+crcGetFoldingMultiplier (unsigned int exponent, crc_t polynomial) {
+  /* x^exponent mod P(x), reflected, and then shifted to match the product */
+  crc_t remainder = 1;
+
+  while (exponent--) {
+    if (remainder & UINT32_C(0X80000000)) {
+      remainder = (remainder << 1) ^ polynomial;
+    } else {
+      remainder <<= 1;
+    }
+  }
+
+  return (uint64_t)crcReflectBits(remainder, 32) << 1;
+}
+
+static uint64_t
+crcGetBarrettQuotient (crc_t polynomial) {
+  /* x^64 / P(x), reflected */
+  uint64_t divisor = (UINT64_C(1) << 32) | polynomial;
+  uint64_t remainder = 0;
+  uint64_t quotient = 0;
+
+  for (int bit=64; bit>=0; bit-=1) {
+    remainder = (remainder << 1) | (bit == 64);
+    quotient <<= 1;
+
+    if (remainder & (UINT64_C(1) << 32)) {
+      remainder ^= divisor;
+      quotient |= 1;
+    }
+  }
+
+  return crcReflectWideBits(quotient, 33);
+}
+
+static void
+crcMakeFoldingConstants (CRCProperties *properties, const CRCAlgorithm *algorithm) {
+  properties->canFold = 0;
+
+  if (algorithm->reflectData && (algorithm->checksumWidth == 32)) {
+    if (__builtin_cpu_supports("pclmul") && __builtin_cpu_supports("sse2")) {
+      uint64_t *constants = properties->foldingConstants;
+      crc_t polynomial = algorithm->generatorPolynomial;
+
+      constants[CRC_FOLD_BY_4_LOW] = crcGetFoldingMultiplier((4 * 128) + 32, polynomial);
+      constants[CRC_FOLD_BY_4_HIGH] = crcGetFoldingMultiplier((4 * 128) - 32, polynomial);
+      constants[CRC_FOLD_BY_1_LOW] = crcGetFoldingMultiplier(128 + 32, polynomial);
+      constants[CRC_FOLD_BY_1_HIGH] = crcGetFoldingMultiplier(128 - 32, polynomial);
+      constants[CRC_FOLD_TO_32] = crcGetFoldingMultiplier(64, polynomial);
+      constants[CRC_BARRETT_POLYNOMIAL] = ((uint64_t)crcReflectBits(polynomial, 32) << 1) | 1;
+      constants[CRC_BARRETT_QUOTIENT] = crcGetBarrettQuotient(polynomial);
+
+      properties->canFold = 1;
+    }
+  }
+}
+
+#define CRC_FOLD(block, multiplier, data) \
+  _mm_xor_si128( \
+    _mm_xor_si128( \
+      _mm_clmulepi64_si128((block), (multiplier), 0X00), \
+      _mm_clmulepi64_si128((block), (multiplier), 0X11) \
+    ), (data) \
+  )
+
+__attribute__((target("pclmul,sse2")))
+static crc_t
+crcFoldBlocks (const CRCProperties *properties, crc_t value, const uint8_t *data, size_t size) {
+  /* The size must be a multiple of 16 and at least 64. */
+  const uint64_t *constants = properties->foldingConstants;
+  const uint8_t *end = data + size;
+
+  __m128i block1 = _mm_loadu_si128((const __m128i *)data + 0);
+  __m128i block2 = _mm_loadu_si128((const __m128i *)data + 1);
+  __m128i block3 = _mm_loadu_si128((const __m128i *)data + 2);
+  __m128i block4 = _mm_loadu_si128((const __m128i *)data + 3);
+  block1 = _mm_xor_si128(block1, _mm_cvtsi32_si128(value));
+  data += 64;
+
+  {
+    __m128i multiplier = _mm_set_epi64x(
+      constants[CRC_FOLD_BY_4_HIGH], constants[CRC_FOLD_BY_4_LOW]
+    );
+
+    while ((end - data) >= 64) {
+      block1 = CRC_FOLD(block1, multiplier, _mm_loadu_si128((const __m128i *)data + 0));
+      block2 = CRC_FOLD(block2, multiplier, _mm_loadu_si128((const __m128i *)data + 1));
+      block3 = CRC_FOLD(block3, multiplier, _mm_loadu_si128((const __m128i *)data + 2));
+      block4 = CRC_FOLD(block4, multiplier, _mm_loadu_si128((const __m128i *)data + 3));
+      data += 64;
+    }
+  }
+
+  {
+    __m128i multiplier = _mm_set_epi64x(
+      constants[CRC_FOLD_BY_1_HIGH], constants[CRC_FOLD_BY_1_LOW]
+    );
+
+    block1 = CRC_FOLD(block1, multiplier, block2);
+    block1 = CRC_FOLD(block1, multiplier, block3);
+    block1 = CRC_FOLD(block1, multiplier, block4);
+
+    while (data < end) {
+      block1 = CRC_FOLD(block1, multiplier, _mm_loadu_si128((const __m128i *)data));
+      data += 16;
+    }
+
+    /* fold 128 bits down to 64 (which also appends 32 zero bits) */
+    block1 = _mm_xor_si128(
+      _mm_srli_si128(block1, 8),
+      _mm_clmulepi64_si128(multiplier, block1, 0X01)
+    );
+  }
+
+  {
+    __m128i mask = _mm_set_epi32(0, 0, 0, -1);
+
+    block1 = _mm_xor_si128(
+      _mm_srli_si128(block1, 4),
+      _mm_clmulepi64_si128(
+        _mm_and_si128(block1, mask),
+        _mm_set_epi64x(0, constants[CRC_FOLD_TO_32]),
+        0X00
+      )
+    );
+
+    {
+      __m128i barrett = _mm_set_epi64x(
+        constants[CRC_BARRETT_QUOTIENT], constants[CRC_BARRETT_POLYNOMIAL]
+      );
+
+      __m128i product = _mm_clmulepi64_si128(_mm_and_si128(block1, mask), barrett, 0X10);
+      product = _mm_clmulepi64_si128(_mm_and_si128(product, mask), barrett, 0X00);
+      block1 = _mm_xor_si128(block1, product);
+    }
+  }
+
+  return _mm_cvtsi128_si32(_mm_srli_si128(block1, 4));
+}
+#endif /* CRC_HAVE_FOLDING */
+
 void
 crcMakeProperties (CRCProperties *properties, const CRCAlgorithm *algorithm) {
   properties->byteShift = algorithm->checksumWidth - CRC_BYTE_WIDTH;
@@ -113,6 +413,13 @@ crcMakeProperties (CRCProperties *properties, const CRCAlgorithm *algorithm) {
 
   crcMakeDataTranslationTable(properties, algorithm);
   crcMakeRemainderCache(properties, algorithm);
+  crcMakeSliceTables(properties, algorithm);
+
+#ifdef CRC_HAVE_FOLDING
+  crcMakeFoldingConstants(properties, algorithm);
+#else /* CRC_HAVE_FOLDING */
+  properties->canFold = 0;
+#endif /* CRC_HAVE_FOLDING */
 }
 
 void
@@ -156,11 +463,131 @@ crcAddByte (CRCGenerator *crc, uint8_t byte) {
   crc->currentValue &= crc->properties.valueMask;
 }
 
+#define CRC_SLICE(table, byte) (tables[(table)][(byte)])
+
+#define CRC_REFLECTED_REGISTER_SLICES(count, value, bytes) \
+  ( CRC_SLICE((count)-1, (bytes)[0] ^ ((value) & UINT8_MAX)) \
+  ^ CRC_SLICE((count)-2, (bytes)[1] ^ (((value) >> 8) & UINT8_MAX)) \
+  ^ CRC_SLICE((count)-3, (bytes)[2] ^ (((value) >> 16) & UINT8_MAX)) \
+  ^ CRC_SLICE((count)-4, (bytes)[3] ^ ((value) >> 24)) \
+  )
+
+#define CRC_DIRECT_REGISTER_SLICES(count, value, bytes) \
+  ( CRC_SLICE((count)-1, (bytes)[0] ^ ((value) >> 24)) \
+  ^ CRC_SLICE((count)-2, (bytes)[1] ^ (((value) >> 16) & UINT8_MAX)) \
+  ^ CRC_SLICE((count)-3, (bytes)[2] ^ (((value) >> 8) & UINT8_MAX)) \
+  ^ CRC_SLICE((count)-4, (bytes)[3] ^ ((value) & UINT8_MAX)) \
+  )
+
+#define CRC_DATA_SLICES(count, bytes) \
+  ( CRC_SLICE((count)-5, (bytes)[4]) \
+  ^ CRC_SLICE((count)-6, (bytes)[5]) \
+  ^ CRC_SLICE((count)-7, (bytes)[6]) \
+  ^ CRC_SLICE((count)-8, (bytes)[7]) \
+  )
+
+#define CRC_MORE_DATA_SLICES(bytes) \
+  ( CRC_SLICE(7, (bytes)[8]) ^ CRC_SLICE(6, (bytes)[9]) \
+  ^ CRC_SLICE(5, (bytes)[10]) ^ CRC_SLICE(4, (bytes)[11]) \
+  ^ CRC_SLICE(3, (bytes)[12]) ^ CRC_SLICE(2, (bytes)[13]) \
+  ^ CRC_SLICE(1, (bytes)[14]) ^ CRC_SLICE(0, (bytes)[15]) \
+  )
+
+static crc_t
+crcAddReflectedSlices (const CRCProperties *properties, crc_t value, const uint8_t *byte, size_t size) {
+  const crc_t (*tables)[CRC_BYTE_INDEXED_TABLE_SIZE] = properties->sliceTables;
+  const uint8_t *end = byte + size;
+
+  while ((end - byte) >= 16) {
+    value = CRC_REFLECTED_REGISTER_SLICES(16, value, byte)
+          ^ CRC_DATA_SLICES(16, byte)
+          ^ CRC_MORE_DATA_SLICES(byte);
+    byte += 16;
+  }
+
+  if ((end - byte) >= 8) {
+    value = CRC_REFLECTED_REGISTER_SLICES(8, value, byte)
+          ^ CRC_DATA_SLICES(8, byte);
+    byte += 8;
+  }
+
+  while (byte < end) {
+    value = (value >> CRC_BYTE_WIDTH) ^ CRC_SLICE(0, (value ^ *byte++) & UINT8_MAX);
+  }
+
+  return value;
+}
+
+static crc_t
+crcAddDirectSlices (const CRCProperties *properties, crc_t value, const uint8_t *byte, size_t size) {
+  const crc_t (*tables)[CRC_BYTE_INDEXED_TABLE_SIZE] = properties->sliceTables;
+  const uint8_t *end = byte + size;
+
+  while ((end - byte) >= 16) {
+    value = CRC_DIRECT_REGISTER_SLICES(16, value, byte)
+          ^ CRC_DATA_SLICES(16, byte)
+          ^ CRC_MORE_DATA_SLICES(byte);
+    byte += 16;
+  }
+
+  if ((end - byte) >= 8) {
+    value = CRC_DIRECT_REGISTER_SLICES(8, value, byte)
+          ^ CRC_DATA_SLICES(8, byte);
+    byte += 8;
+  }
+
+  while (byte < end) {
+    value = (value << CRC_BYTE_WIDTH) ^ CRC_SLICE(0, (value >> 24) ^ *byte++);
+  }
+
+  return value;
+}
+
+/* Below this size, converting the value to and from the slicing register
+ * costs more than it saves.
+ */
+#define CRC_SLICING_THRESHOLD 16
+
+/* Below this size, setting up the carry-less multiplication costs more than
+ * slicing.
+ */
+#define CRC_FOLDING_THRESHOLD 128
+
 void
 crcAddData (CRCGenerator *crc, const void *data, size_t size) {
   const uint8_t *byte = data;
-  const uint8_t *end = byte + size;
-  while (byte < end) crcAddByte(crc, *byte++);
+
+  if ((size >= CRC_SLICING_THRESHOLD) && crc->properties.sliceTables) {
+    const CRCAlgorithm *algorithm = &crc->algorithm;
+    const CRCProperties *properties = &crc->properties;
+    crc_t value = crc->currentValue;
+
+    if (algorithm->reflectData) {
+      crcReflectValue(&value, algorithm);
+
+#ifdef CRC_HAVE_FOLDING
+      if (properties->canFold && (size >= CRC_FOLDING_THRESHOLD)) {
+        size_t count = size & ~(size_t)0XF;
+
+        value = crcFoldBlocks(properties, value, byte, count);
+        byte += count;
+        size -= count;
+      }
+#endif /* CRC_HAVE_FOLDING */
+
+      value = crcAddReflectedSlices(properties, value, byte, size);
+      crcReflectValue(&value, algorithm);
+    } else {
+      value <<= properties->sliceShift;
+      value = crcAddDirectSlices(properties, value, byte, size);
+      value >>= properties->sliceShift;
+    }
+
+    crc->currentValue = value;
+  } else {
+    const uint8_t *end = byte + size;
+    while (byte < end) crcAddByte(crc, *byte++);
+  }
 }
 
 crc_t
@@ -18,6 +18,7 @@
 
 #include "prologue.h"
 
+#include "log.h"
 #include "program.h"
 #include "options.h"
 #include "crc.h"
@@ -110,6 +111,79 @@ validateOptions (void) {
   return 1;
 }
 
+static void
+fillData (uint8_t *data, size_t size) {
+  for (size_t index=0; index<size; index+=1) data[index] = rand();
+}
+
+static crc_t
+getReferenceValue (const CRCAlgorithm *algorithm, const uint8_t *data, size_t size) {
+  CRCGenerator *crc = crcNewGenerator(algorithm);
+  crc_t value;
+
+  for (size_t index=0; index<size; index+=1) crcAddByte(crc, data[index]);
+  value = crcGetValue(crc);
+
+  crcDestroyGenerator(crc);
+  return value;
+}
+
+static int
+verifyAlgorithmAgainstReference (const CRCAlgorithm *algorithm) {
+  CRCGenerator *crc = crcNewGenerator(algorithm);
+  if (!crc) return 0;
+
+  uint8_t data[0X400];
+  fillData(data, sizeof(data));
+
+  static const size_t sizes[] = {
+    1, 7, 8, 15, 16, 17, 31, 63, 64, 65, 127, 128, 129, 255, 333, 1000, 0X400
+  };
+
+  int ok = 1;
+
+  for (unsigned int sizeIndex=0; sizeIndex<ARRAY_COUNT(sizes); sizeIndex+=1) {
+    size_t size = sizes[sizeIndex];
+    crc_t expected = getReferenceValue(algorithm, data, size);
+
+    /* add the data in two pieces so that the bulk path starts from a
+     * value other than the initial one
+     */
+    size_t split = rand() % (size + 1);
+
+    crcResetGenerator(crc);
+    crcAddData(crc, data, split);
+    crcAddData(crc, &data[split], size - split);
+
+    crc_t actual = crcGetValue(crc);
+
+    if (actual != expected) {
+      logMessage(LOG_WARNING,
+        "CRC reference mismatch: %s: Size:%zu Split:%zu Actual:%"PRIcrc " Expected:%"PRIcrc,
+        algorithm->primaryName, size, split, actual, expected
+      );
+
+      ok = 0;
+    }
+  }
+
+  crcDestroyGenerator(crc);
+  return ok;
+}
+
+static int
+verifyAlgorithmsAgainstReference (void) {
+  int ok = 1;
+  const CRCAlgorithm **algorithm = crcProvidedAlgorithms;
+
+  while (*algorithm) {
+    if (!verifyAlgorithmAgainstReference(*algorithm)) ok = 0;
+    algorithm += 1;
+  }
+
+  return ok;
+}
+
 int
 main (int argc, char *argv[]) {
   {
@@ -125,5 +199,9 @@ main (int argc, char *argv[]) {
   if (!validateOptions()) return PROG_EXIT_SYNTAX;
 
   if (!crcVerifyProvidedAlgorithms()) return PROG_EXIT_FATAL;
+
+  srand(1);
+  if (!verifyAlgorithmsAgainstReference()) return PROG_EXIT_FATAL;
+
   return PROG_EXIT_SUCCESS;
 }
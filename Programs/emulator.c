@@ -0,0 +1,641 @@
+/*
+ * BRLTTY - A background process providing access to the console screen (when in
+ *          text mode) for a blind person using a refreshable braille display.
+ *
+ * Copyright (C) 1995-2021 by The BRLTTY Developers.
+ *
+ * BRLTTY comes with ABSOLUTELY NO WARRANTY.
+ *
+ * This is free software, placed under the terms of the
+ * GNU Lesser General Public License, as published by the Free Software
+ * Foundation; either version 2.1 of the License, or (at your option) any
+ * later version. Please see the file LICENSE-LGPL for details.
+ *
+ * Web Page: http://brltty.app/
+ *
+ * This software is maintained by Dave Mielke <dave@mielke.cc>.
+ */
+
+/*
+ * This emulates a few braille devices on a pseudo-terminal so that their
+ * drivers can be exercised (and timed) without any hardware. Each protocol
+ * implements just enough of the device's side of the conversation for the
+ * driver to identify it, write its cells, and receive key events.
+ */
+
+#include "prologue.h"
+
+#include <string.h>
+#include <fcntl.h>
+
+#ifdef HAVE_POSIX_OPENPT
+#include <termios.h>
+#endif /* HAVE_POSIX_OPENPT */
+
+#include "log.h"
+#include "emulator.h"
+#include "async_io.h"
+#include "io_misc.h"
+#include "timing.h"
+#include "ascii.h"
+
+#define EMULATOR_CELL_LIMIT 0X100
+
+typedef struct {
+  const char *name;
+  const char *driver;
+  unsigned int cellCount;
+
+  size_t (*handleInput) (Emulator *emulator, const unsigned char *bytes, size_t length);
+  int (*writeActionKey) (Emulator *emulator, int press);
+  int (*writeRoutingKey) (Emulator *emulator, unsigned int key, int press);
+} EmulatorProtocol;
+
+struct EmulatorStruct {
+  const EmulatorProtocol *protocol;
+
+  int master;
+  int slave;
+  char *device;
+  AsyncHandle inputMonitor;
+
+  unsigned char cells[EMULATOR_CELL_LIMIT];
+  unsigned int cellCount;
+  unsigned connected:1;
+
+  unsigned actionPending:1;
+  TimeValue actionTime;
+
+  EmulatorStatistics statistics;
+};
+
+static int
+writeEmulatorBytes (Emulator *emulator, const unsigned char *bytes, size_t count) {
+  ssize_t result = writeFile(emulator->master, bytes, count);
+
+  if (result == -1) return 0;
+  emulator->statistics.bytesSent += result;
+  return 1;
+}
+
+static void
+setEmulatorConnected (Emulator *emulator) {
+  if (!emulator->connected) {
+    emulator->connected = 1;
+    logMessage(LOG_INFO, "emulated %s device connected", emulator->protocol->name);
+  }
+}
+
+static void
+updateEmulatorCells (Emulator *emulator, unsigned int start, const unsigned char *cells, unsigned int count) {
+  EmulatorStatistics *statistics = &emulator->statistics;
+
+  if (start > emulator->cellCount) start = emulator->cellCount;
+  if (count > (emulator->cellCount - start)) count = emulator->cellCount - start;
+
+  for (unsigned int index=0; index<count; index+=1) {
+    unsigned char *cell = &emulator->cells[start + index];
+
+    if (*cell != cells[index]) {
+      *cell = cells[index];
+      statistics->cellsChanged += 1;
+    }
+  }
+
+  statistics->cellUpdates += 1;
+
+  if (emulator->actionPending) {
+    long int latency = getMonotonicNanosecondsElapsed(&emulator->actionTime) / NSECS_PER_USEC;
+
+    emulator->actionPending = 0;
+    statistics->latencyCount += 1;
+    statistics->latencyTotal += latency;
+    if (latency > statistics->latencyMaximum) statistics->latencyMaximum = latency;
+  }
+}
+
+static size_t
+skipEmulatorByte (Emulator *emulator, const unsigned char *bytes) {
+  logMessage(LOG_DEBUG, "emulated %s device ignored byte: %02X",
+             emulator->protocol->name, bytes[0]);
+  return 1;
+}
+
+/* Baum: escape-framed packets (ESC, code, data...) with any ESC within them
+ * doubled. There's no length field so each request's size must be known.
+ */
+
+#define BAUM_REQ_DisplayData 0X01
+#define BAUM_REQ_GetVersionNumber 0X05
+#define BAUM_REQ_GetKeys 0X08
+#define BAUM_REQ_GetMode 0X11
+#define BAUM_REQ_SetMode 0X12
+#define BAUM_REQ_SetProtocolState 0X15
+#define BAUM_REQ_ModuleRegistration 0X50
+#define BAUM_REQ_DeviceIdentity 0X84
+#define BAUM_REQ_SerialNumber 0X8A
+
+#define BAUM_RSP_CellCount 0X01
+#define BAUM_RSP_RoutingKeys 0X22
+#define BAUM_RSP_DisplayKeys 0X24
+
+/* Display1+Display2+Display5 is bound to HELP. */
+#define BAUM_ACTION_KEYS 0X13
+
+static int
+writeBaumPacket (Emulator *emulator, const unsigned char *packet, size_t length) {
+  unsigned char buffer[1 + (length * 2)];
+  unsigned char *byte = buffer;
+
+  *byte++ = ESC;
+
+  for (size_t index=0; index<length; index+=1) {
+    if ((*byte++ = packet[index]) == ESC) *byte++ = ESC;
+  }
+
+  return writeEmulatorBytes(emulator, buffer, (byte - buffer));
+}
+
+static int
+getBaumPayloadSize (Emulator *emulator, const unsigned char *packet, size_t length) {
+  switch (packet[0]) {
+    case BAUM_REQ_DisplayData:
+      /* The driver asks for the cell count by writing just one cell. */
+      return emulator->connected? emulator->cellCount: 1;
+
+    case BAUM_REQ_GetVersionNumber:
+    case BAUM_REQ_GetKeys:
+    case BAUM_REQ_GetMode:
+    case BAUM_REQ_DeviceIdentity:
+    case BAUM_REQ_SerialNumber:
+      return 0;
+
+    case BAUM_REQ_SetMode:
+      return 2;
+
+    case BAUM_REQ_ModuleRegistration:
+      if (length < 2) return -2;
+      return 1 + packet[1];
+
+    default:
+      return -1;
+  }
+}
+
+static size_t
+handleBaumInput (Emulator *emulator, const unsigned char *bytes, size_t length) {
+  unsigned char packet[1 + EMULATOR_CELL_LIMIT];
+  size_t size = 0;
+  size_t index = 1;
+  int payload = -2;
+
+  if (bytes[0] != ESC) return skipEmulatorByte(emulator, bytes);
+
+  while (1) {
+    if (payload >= 0) {
+      if (size == (1 + payload)) break;
+    }
+
+    if (index == length) return 0;
+
+    if (bytes[index] == ESC) {
+      if ((index + 1) == length) return 0;
+
+      /* an undoubled escape starts the next packet */
+      if (bytes[index+1] != ESC) break;
+      index += 1;
+    }
+
+    if (size < sizeof(packet)) packet[size++] = bytes[index];
+    index += 1;
+
+    if (payload < -1) payload = getBaumPayloadSize(emulator, packet, size);
+  }
+
+  if (!size) return index;
+
+  switch (packet[0]) {
+    case BAUM_REQ_DisplayData:
+      if (size == 2) {
+        const unsigned char response[] = {BAUM_RSP_CellCount, emulator->cellCount};
+
+        if (!writeBaumPacket(emulator, response, sizeof(response))) return 0;
+        setEmulatorConnected(emulator);
+      } else if (size == (1 + emulator->cellCount)) {
+        updateEmulatorCells(emulator, 0, &packet[1], emulator->cellCount);
+      }
+      break;
+
+    default:
+      break;
+  }
+
+  return index;
+}
+
+static size_t
+getBaumRoutingKeysSize (const Emulator *emulator) {
+  size_t size = (emulator->cellCount + 7) / 8;
+
+  if ((size > 2) && (size < 5)) size = 5;
+  return size;
+}
+
+static int
+writeBaumActionKey (Emulator *emulator, int press) {
+  const unsigned char packet[] = {
+    BAUM_RSP_DisplayKeys,
+    press? BAUM_ACTION_KEYS: 0
+  };
+
+  return writeBaumPacket(emulator, packet, sizeof(packet));
+}
+
+static int
+writeBaumRoutingKey (Emulator *emulator, unsigned int key, int press) {
+  size_t size = getBaumRoutingKeysSize(emulator);
+  unsigned char packet[1 + size];
+
+  memset(packet, 0, sizeof(packet));
+  packet[0] = BAUM_RSP_RoutingKeys;
+  if (press) packet[1 + (key / 8)] |= 1 << (key % 8);
+
+  return writeBaumPacket(emulator, packet, sizeof(packet));
+}
+
+/* HandyTech: a Braille Star 40 (single byte key codes, cells written via
+ * a plain braille packet which must be acknowledged).
+ */
+
+#define HT_PKT_Braille 0X01
+#define HT_PKT_Extended 0X79
+#define HT_PKT_ACK 0X7E
+#define HT_PKT_OK 0XFE
+#define HT_PKT_Reset 0XFF
+
+#define HT_MODEL_BrailleStar40 0X74
+#define HT_KEY_B8 0X1F
+#define HT_KEY_ROUTING 0X20
+#define HT_KEY_RELEASE 0X80
+
+static size_t
+handleHandyTechInput (Emulator *emulator, const unsigned char *bytes, size_t length) {
+  switch (bytes[0]) {
+    case HT_PKT_Reset: {
+      static const unsigned char response[] = {HT_PKT_OK, HT_MODEL_BrailleStar40};
+
+      if (!writeEmulatorBytes(emulator, response, sizeof(response))) return 0;
+      setEmulatorConnected(emulator);
+      return 1;
+    }
+
+    case HT_PKT_Braille: {
+      static const unsigned char response[] = {HT_PKT_ACK};
+      size_t size = 1 + emulator->cellCount;
+
+      if (length < size) return 0;
+      updateEmulatorCells(emulator, 0, &bytes[1], emulator->cellCount);
+      if (!writeEmulatorBytes(emulator, response, sizeof(response))) return 0;
+      return size;
+    }
+
+    case HT_PKT_Extended: {
+      size_t size;
+
+      if (length < 3) return 0;
+      size = 3 + bytes[2] + 1;
+      if (length < size) return 0;
+      return size;
+    }
+
+    default:
+      return skipEmulatorByte(emulator, bytes);
+  }
+}
+
+static int
+writeHandyTechKey (Emulator *emulator, unsigned char key, int press) {
+  if (!press) key |= HT_KEY_RELEASE;
+  return writeEmulatorBytes(emulator, &key, 1);
+}
+
+static int
+writeHandyTechActionKey (Emulator *emulator, int press) {
+  /* B8 is bound to HELP. */
+  return writeHandyTechKey(emulator, HT_KEY_B8, press);
+}
+
+static int
+writeHandyTechRoutingKey (Emulator *emulator, unsigned int key, int press) {
+  return writeHandyTechKey(emulator, (HT_KEY_ROUTING + key), press);
+}
+
+/* Alva: an ABT 340 (protocol 1) - three status cells followed by forty
+ * text cells, any range of which may be written.
+ */
+
+#define AL_MODEL_ABT340 0X01
+#define AL_GRP_OperatingKeys 0X71
+#define AL_GRP_RoutingKeys 0X72
+#define AL_KEY_Prog 0X00
+#define AL_KEY_RELEASE 0X80
+
+static size_t
+handleAlvaInput (Emulator *emulator, const unsigned char *bytes, size_t length) {
+  switch (bytes[0]) {
+    case ESC: {
+      static const unsigned char function[] = {ESC, 'F', 'U', 'N'};
+      static const unsigned char parameter[] = {ESC, 'P', 'A'};
+
+      if (length < sizeof(function)) return 0;
+
+      if (memcmp(bytes, function, sizeof(function)) == 0) {
+        if (length < 6) return 0;
+
+        if (bytes[4] == 0X06) {
+          static const unsigned char response[] = {ESC, 'I', 'D', '=', AL_MODEL_ABT340};
+
+          if (!writeEmulatorBytes(emulator, response, sizeof(response))) return 0;
+          setEmulatorConnected(emulator);
+        }
+
+        return 6;
+      }
+
+      if (memcmp(bytes, parameter, sizeof(parameter)) == 0) {
+        if (length < 8) return 0;
+        return 8;
+      }
+
+      break;
+    }
+
+    case CR: {
+      size_t size;
+
+      if (length < 5) return 0;
+      if ((bytes[1] != ESC) || (bytes[2] != 'B')) break;
+
+      size = 5 + bytes[4] + 1;
+      if (length < size) return 0;
+
+      updateEmulatorCells(emulator, bytes[3], &bytes[5], bytes[4]);
+      return size;
+    }
+
+    default:
+      break;
+  }
+
+  return skipEmulatorByte(emulator, bytes);
+}
+
+static int
+writeAlvaKey (Emulator *emulator, unsigned char group, unsigned char key, int press) {
+  const unsigned char packet[] = {
+    group,
+    press? key: (key | AL_KEY_RELEASE)
+  };
+
+  return writeEmulatorBytes(emulator, packet, sizeof(packet));
+}
+
+static int
+writeAlvaActionKey (Emulator *emulator, int press) {
+  /* Prog is bound to HELP. */
+  return writeAlvaKey(emulator, AL_GRP_OperatingKeys, AL_KEY_Prog, press);
+}
+
+static int
+writeAlvaRoutingKey (Emulator *emulator, unsigned int key, int press) {
+  return writeAlvaKey(emulator, AL_GRP_RoutingKeys, key, press);
+}
+
+static const EmulatorProtocol emulatorProtocols[] = {
+  { .name = "baum",
+    .driver = "bm",
+    .cellCount = 40,
+
+    .handleInput = handleBaumInput,
+    .writeActionKey = writeBaumActionKey,
+    .writeRoutingKey = writeBaumRoutingKey
+  },
+
+  { .name = "handytech",
+    .driver = "ht",
+    .cellCount = 40,
+
+    .handleInput = handleHandyTechInput,
+    .writeActionKey = writeHandyTechActionKey,
+    .writeRoutingKey = writeHandyTechRoutingKey
+  },
+
+  { .name = "alva",
+    .driver = "al",
+    .cellCount = 3 + 40,
+
+    .handleInput = handleAlvaInput,
+    .writeActionKey = writeAlvaActionKey,
+    .writeRoutingKey = writeAlvaRoutingKey
+  },
+};
+
+const char *const *
+getEmulatorProtocolNames (void) {
+  static const char *names[ARRAY_COUNT(emulatorProtocols) + 1] = {NULL};
+
+  if (!names[0]) {
+    for (unsigned int index=0; index<ARRAY_COUNT(emulatorProtocols); index+=1) {
+      names[index] = emulatorProtocols[index].name;
+    }
+  }
+
+  return names;
+}
+
+static const EmulatorProtocol *
+getEmulatorProtocol (const char *name) {
+  for (unsigned int index=0; index<ARRAY_COUNT(emulatorProtocols); index+=1) {
+    const EmulatorProtocol *protocol = &emulatorProtocols[index];
+    if (strcmp(name, protocol->name) == 0) return protocol;
+  }
+
+  logMessage(LOG_ERR, "unknown emulator protocol: %s", name);
+  return NULL;
+}
+
+ASYNC_INPUT_CALLBACK(handleEmulatorInput) {
+  Emulator *emulator = parameters->data;
+
+  if (parameters->error) {
+    logMessage(LOG_WARNING, "emulator input error: %s", strerror(parameters->error));
+  } else if (!parameters->end) {
+    const unsigned char *bytes = parameters->buffer;
+    size_t length = parameters->length;
+
+    while (length) {
+      size_t count = emulator->protocol->handleInput(emulator, bytes, length);
+      if (!count) break;
+
+      emulator->statistics.bytesReceived += count;
+      bytes += count;
+      length -= count;
+    }
+
+    return parameters->length - length;
+  }
+
+  return 0;
+}
+
+#ifdef HAVE_POSIX_OPENPT
+static int
+openPseudoTerminal (Emulator *emulator) {
+  if ((emulator->master = posix_openpt(O_RDWR | O_NOCTTY)) != -1) {
+    if ((grantpt(emulator->master) != -1) && (unlockpt(emulator->master) != -1)) {
+      const char *path = ptsname(emulator->master);
+
+      if (path) {
+        if ((emulator->device = strdup(path))) {
+          /* Keep the slave side open so that the master doesn't see a
+           * hangup whenever the driver closes (or reopens) the device.
+           */
+          if ((emulator->slave = open(path, (O_RDWR | O_NOCTTY))) != -1) {
+            struct termios attributes;
+
+            if (tcgetattr(emulator->slave, &attributes) != -1) {
+              cfmakeraw(&attributes);
+              tcsetattr(emulator->slave, TCSANOW, &attributes);
+            }
+
+            return 1;
+          } else {
+            logSystemError("open");
+          }
+
+          free(emulator->device);
+          emulator->device = NULL;
+        } else {
+          logMallocError();
+        }
+      } else {
+        logSystemError("ptsname");
+      }
+    } else {
+      logSystemError("grantpt");
+    }
+
+    close(emulator->master);
+  } else {
+    logSystemError("posix_openpt");
+  }
+
+  return 0;
+}
+#else /* HAVE_POSIX_OPENPT */
+static int
+openPseudoTerminal (Emulator *emulator) {
+  logUnsupportedOperation("posix_openpt");
+  return 0;
+}
+#endif /* HAVE_POSIX_OPENPT */
+
+Emulator *
+newEmulator (const char *name) {
+  const EmulatorProtocol *protocol = getEmulatorProtocol(name);
+
+  if (protocol) {
+    Emulator *emulator;
+
+    if ((emulator = malloc(sizeof(*emulator)))) {
+      memset(emulator, 0, sizeof(*emulator));
+      emulator->protocol = protocol;
+      emulator->cellCount = protocol->cellCount;
+      emulator->device = NULL;
+      emulator->inputMonitor = NULL;
+
+      if (openPseudoTerminal(emulator)) {
+        if (asyncReadFile(&emulator->inputMonitor, emulator->master,
+                          0X1000, handleEmulatorInput, emulator)) {
+          return emulator;
+        }
+
+        close(emulator->slave);
+        close(emulator->master);
+        free(emulator->device);
+      }
+
+      free(emulator);
+    } else {
+      logMallocError();
+    }
+  }
+
+  return NULL;
+}
+
+void
+destroyEmulator (Emulator *emulator) {
+  asyncCancelRequest(emulator->inputMonitor);
+  close(emulator->slave);
+  close(emulator->master);
+  free(emulator->device);
+  free(emulator);
+}
+
+const char *
+getEmulatorDevice (const Emulator *emulator) {
+  return emulator->device;
+}
+
+const char *
+getEmulatorDriver (const Emulator *emulator) {
+  return emulator->protocol->driver;
+}
+
+unsigned int
+getEmulatorCellCount (const Emulator *emulator) {
+  return emulator->cellCount;
+}
+
+int
+isEmulatorConnected (const Emulator *emulator) {
+  return emulator->connected;
+}
+
+int
+sendEmulatorActionKey (Emulator *emulator) {
+  const EmulatorProtocol *protocol = emulator->protocol;
+
+  if (!protocol->writeActionKey(emulator, 1)) return 0;
+  if (!protocol->writeActionKey(emulator, 0)) return 0;
+
+  /* the driver acts when the key is released */
+  getMonotonicTime(&emulator->actionTime);
+  emulator->actionPending = 1;
+  emulator->statistics.actionKeys += 1;
+  return 1;
+}
+
+int
+sendEmulatorRoutingKey (Emulator *emulator, unsigned int key) {
+  const EmulatorProtocol *protocol = emulator->protocol;
+
+  if (key >= emulator->cellCount) key %= emulator->cellCount;
+  if (!protocol->writeRoutingKey(emulator, key, 1)) return 0;
+  if (!protocol->writeRoutingKey(emulator, key, 0)) return 0;
+
+  emulator->statistics.routingKeys += 1;
+  return 1;
+}
+
+void
+getEmulatorStatistics (const Emulator *emulator, EmulatorStatistics *statistics) {
+  *statistics = emulator->statistics;
+}
+
+void
+resetEmulatorStatistics (Emulator *emulator) {
+  memset(&emulator->statistics, 0, sizeof(emulator->statistics));
+  emulator->actionPending = 0;
+}
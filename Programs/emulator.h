@@ -0,0 +1,62 @@
+/*
+ * BRLTTY - A background process providing access to the console screen (when in
+ *          text mode) for a blind person using a refreshable braille display.
+ *
+ * Copyright (C) 1995-2021 by The BRLTTY Developers.
+ *
+ * BRLTTY comes with ABSOLUTELY NO WARRANTY.
+ *
+ * This is free software, placed under the terms of the
+ * GNU Lesser General Public License, as published by the Free Software
+ * Foundation; either version 2.1 of the License, or (at your option) any
+ * later version. Please see the file LICENSE-LGPL for details.
+ *
+ * Web Page: http://brltty.app/
+ *
+ * This software is maintained by Dave Mielke <dave@mielke.cc>.
+ */
+
+#ifndef BRLTTY_INCLUDED_EMULATOR
+#define BRLTTY_INCLUDED_EMULATOR
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+typedef struct EmulatorStruct Emulator;
+
+typedef struct {
+  unsigned long cellUpdates;
+  unsigned long cellsChanged;
+  unsigned long bytesReceived;
+  unsigned long bytesSent;
+
+  unsigned long actionKeys;
+  unsigned long routingKeys;
+
+  unsigned long latencyCount;
+  long int latencyTotal;
+  long int latencyMaximum;
+} EmulatorStatistics;
+
+extern const char *const *getEmulatorProtocolNames (void);
+
+extern Emulator *newEmulator (const char *protocol);
+extern void destroyEmulator (Emulator *emulator);
+
+extern const char *getEmulatorDevice (const Emulator *emulator);
+extern const char *getEmulatorDriver (const Emulator *emulator);
+extern unsigned int getEmulatorCellCount (const Emulator *emulator);
+extern int isEmulatorConnected (const Emulator *emulator);
+
+extern int sendEmulatorActionKey (Emulator *emulator);
+extern int sendEmulatorRoutingKey (Emulator *emulator, unsigned int key);
+
+extern void getEmulatorStatistics (const Emulator *emulator, EmulatorStatistics *statistics);
+extern void resetEmulatorStatistics (Emulator *emulator);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* BRLTTY_INCLUDED_EMULATOR */
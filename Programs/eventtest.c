@@ -0,0 +1,180 @@
+/*
+ * BRLTTY - A background process providing access to the console screen (when in
+ *          text mode) for a blind person using a refreshable braille display.
+ *
+ * Copyright (C) 1995-2021 by The BRLTTY Developers.
+ *
+ * BRLTTY comes with ABSOLUTELY NO WARRANTY.
+ *
+ * This is free software, placed under the terms of the
+ * GNU Lesser General Public License, as published by the Free Software
+ * Foundation; either version 2.1 of the License, or (at your option) any
+ * later version. Please see the file LICENSE-LGPL for details.
+ *
+ * Web Page: http://brltty.app/
+ *
+ * This software is maintained by Dave Mielke <dave@mielke.cc>.
+ */
+
+#include "prologue.h"
+
+#include <string.h>
+
+#include "log.h"
+#include "program.h"
+#include "options.h"
+#include "parse.h"
+#include "thread.h"
+#include "async_event.h"
+#include "async_wait.h"
+
+static char *opt_iterations;
+
+BEGIN_OPTION_TABLE(programOptions)
+  { .word = "iterations",
+    .letter = 'i',
+    .argument = "count",
+    .setting.string = &opt_iterations,
+    .description = "the number of events sent by each producer"
+  },
+END_OPTION_TABLE
+
+#ifdef GOT_PTHREADS
+#define PRODUCER_COUNT 4
+#define PRODUCER_SHIFT 24
+
+typedef struct {
+  AsyncEvent *event;
+  unsigned int count;
+  unsigned int expected;
+
+  unsigned int received;
+  unsigned int nextSequence[PRODUCER_COUNT];
+  int outOfOrder;
+} TestState;
+
+typedef struct {
+  TestState *state;
+  unsigned int producer;
+} ProducerArgument;
+
+ASYNC_EVENT_CALLBACK(handleSequencedEvent) {
+  TestState *state = parameters->eventData;
+  uintptr_t value = (uintptr_t)parameters->signalData;
+  unsigned int producer = value >> PRODUCER_SHIFT;
+  unsigned int sequence = value & ((1 << PRODUCER_SHIFT) - 1);
+
+  if (sequence != state->nextSequence[producer]) state->outOfOrder = 1;
+  state->nextSequence[producer] = sequence + 1;
+  state->received += 1;
+}
+
+THREAD_FUNCTION(sendSequencedEvents) {
+  ProducerArgument *producer = argument;
+  TestState *state = producer->state;
+  uintptr_t base = (uintptr_t)producer->producer << PRODUCER_SHIFT;
+
+  for (unsigned int sequence=0; sequence<state->count; sequence+=1) {
+    if (!asyncSignalEvent(state->event, (void *)(base | sequence))) break;
+  }
+
+  return NULL;
+}
+
+ASYNC_CONDITION_TESTER(testAllReceived) {
+  TestState *state = data;
+  return state->received == state->expected;
+}
+
+static int
+sendFromProducers (TestState *state, unsigned int count) {
+  pthread_t threads[PRODUCER_COUNT];
+  ProducerArgument arguments[PRODUCER_COUNT];
+  unsigned int started = 0;
+
+  memset(state, 0, sizeof(*state));
+  state->count = count;
+  state->expected = count * PRODUCER_COUNT;
+  if (!(state->event = asyncNewEvent(handleSequencedEvent, state))) return 0;
+
+  while (started < PRODUCER_COUNT) {
+    ProducerArgument *argument = &arguments[started];
+
+    argument->state = state;
+    argument->producer = started;
+
+    if (createThread("event-producer", &threads[started], NULL,
+                     sendSequencedEvents, argument)) {
+      break;
+    }
+
+    started += 1;
+  }
+
+  if (started == PRODUCER_COUNT) asyncWaitFor(testAllReceived, state);
+  while (started) pthread_join(threads[--started], NULL);
+
+  asyncDiscardEvent(state->event);
+  return state->received == state->expected;
+}
+
+static const char *
+getImplementationName (int queued) {
+  return queued? "queue": "pipe";
+}
+
+static int
+verifyEvents (unsigned int count) {
+  for (int queued=0; queued<2; queued+=1) {
+    if (!asyncSetEventQueueing(queued)) continue;
+
+    TestState state;
+    const char *name = getImplementationName(queued);
+
+    if (!sendFromProducers(&state, count)) {
+      logMessage(LOG_ERR, "%s: %u of %u events received",
+                 name, state.received, state.expected);
+      return 0;
+    }
+
+    if (state.outOfOrder) {
+      logMessage(LOG_ERR, "%s: events received out of order", name);
+      return 0;
+    }
+  }
+
+  return 1;
+}
+#endif /* GOT_PTHREADS */
+
+int
+main (int argc, char *argv[]) {
+  int iterations = 10000;
+
+  {
+    static const OptionsDescriptor descriptor = {
+      OPTION_TABLE(programOptions),
+      .applicationName = "eventtest",
+      .argumentsSummary = ""
+    };
+
+    PROCESS_OPTIONS(descriptor, argc, argv);
+  }
+
+  if (opt_iterations && *opt_iterations) {
+    static const int minimum = 1;
+
+    if (!validateInteger(&iterations, opt_iterations, &minimum, NULL)) {
+      logMessage(LOG_ERR, "invalid iteration count: %s", opt_iterations);
+      return PROG_EXIT_SYNTAX;
+    }
+  }
+
+#ifdef GOT_PTHREADS
+  if (!verifyEvents(iterations)) return PROG_EXIT_FATAL;
+#else /* GOT_PTHREADS */
+  logMessage(LOG_WARNING, "threads not supported");
+#endif /* GOT_PTHREADS */
+
+  return PROG_EXIT_SUCCESS;
+}
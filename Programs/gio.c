@@ -399,6 +399,18 @@ gioGetMillisecondsToTransfer (GioEndpoint *endpoint, size_t bytes) {
   return endpoint->bytesPerSecond? (((bytes * 1000) / endpoint->bytesPerSecond) + 1): 0;
 }
 
+ssize_t
+gioGetPendingOutput (GioEndpoint *endpoint) {
+  GioGetPendingOutputMethod *method = endpoint->methods->getPendingOutput;
+
+  if (!method) {
+    errno = ENOSYS;
+    return -1;
+  }
+
+  return method(endpoint->handle);
+}
+
 ssize_t
 gioTellResource (
   GioEndpoint *endpoint,
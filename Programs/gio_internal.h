@@ -38,6 +38,8 @@ typedef char *GioGetResourceNameMethod (GioHandle *handle, int timeout);
 
 typedef ssize_t GioWriteDataMethod (GioHandle *handle, const void *data, size_t size, int timeout);
 
+typedef ssize_t GioGetPendingOutputMethod (GioHandle *handle);
+
 typedef int GioAwaitInputMethod (GioHandle *handle, int timeout);
 
 typedef ssize_t GioReadDataMethod (
@@ -94,6 +96,7 @@ typedef struct {
   GioGetResourceNameMethod *getResourceName;
 
   GioWriteDataMethod *writeData;
+  GioGetPendingOutputMethod *getPendingOutput;
   GioAwaitInputMethod *awaitInput;
   GioReadDataMethod *readData;
 
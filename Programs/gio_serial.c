@@ -47,6 +47,11 @@ writeSerialData (GioHandle *handle, const void *data, size_t size, int timeout)
   return serialWriteData(handle->device, data, size);
 }
 
+static ssize_t
+getSerialPendingOutput (GioHandle *handle) {
+  return serialGetPendingOutput(handle->device);
+}
+
 static int
 awaitSerialInput (GioHandle *handle, int timeout) {
   return serialAwaitInput(handle->device, timeout);
@@ -85,6 +90,7 @@ static const GioMethods gioSerialMethods = {
   .makeResourceIdentifier = makeSerialResourceIdentifier,
 
   .writeData = writeSerialData,
+  .getPendingOutput = getSerialPendingOutput,
   .awaitInput = awaitSerialInput,
   .readData = readSerialData,
 
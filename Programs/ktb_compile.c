@@ -186,6 +186,8 @@ getKeyContext (KeyTableData *ktd, unsigned char context) {
       ctx->keyBindings.table = NULL;
       ctx->keyBindings.size = 0;
       ctx->keyBindings.count = 0;
+      ctx->keyBindings.hashTable = NULL;
+      ctx->keyBindings.hashMask = 0;
 
       ctx->hotkeys.table = NULL;
       ctx->hotkeys.size = 0;
@@ -881,6 +883,99 @@ compareKeyBindings (const KeyBinding *binding1, const KeyBinding *binding2) {
   return compareKeyCombinations(&binding1->keyCombination, &binding2->keyCombination);
 }
 
+static unsigned int
+hashKeyCombination (const KeyCombination *combination) {
+  unsigned int hash = 2166136261U;
+
+#define HASH_BYTE(byte) (hash = (hash ^ (byte)) * 16777619U)
+  HASH_BYTE(combination->modifierCount);
+
+  if (combination->flags & KCF_IMMEDIATE_KEY) {
+    HASH_BYTE(combination->immediateKey.group);
+    HASH_BYTE(combination->immediateKey.number);
+  } else {
+    HASH_BYTE(KTB_KEY_ANY);
+    HASH_BYTE(KTB_KEY_ANY);
+  }
+
+  {
+    const KeyValue *modifier = combination->modifierKeys;
+    const KeyValue *end = modifier + combination->modifierCount;
+
+    while (modifier < end) {
+      HASH_BYTE(modifier->group);
+      HASH_BYTE(modifier->number);
+      modifier += 1;
+    }
+  }
+#undef HASH_BYTE
+
+  return hash ^ (hash >> 16);
+}
+
+const KeyBinding *
+getKeyBinding (const KeyContext *ctx, const KeyCombination *combination) {
+  const unsigned int *hashTable = ctx->keyBindings.hashTable;
+
+  if (hashTable) {
+    unsigned int mask = ctx->keyBindings.hashMask;
+    unsigned int slot = hashKeyCombination(combination) & mask;
+    unsigned int index;
+
+    while ((index = hashTable[slot])) {
+      const KeyBinding *binding = &ctx->keyBindings.table[index - 1];
+
+      if (compareKeyCombinations(combination, &binding->keyCombination) == 0) {
+        return binding;
+      }
+
+      slot = (slot + 1) & mask;
+    }
+  }
+
+  return NULL;
+}
+
+static int
+makeKeyBindingHashTable (KeyContext *ctx) {
+  unsigned int count = ctx->keyBindings.count;
+
+  if (ctx->keyBindings.hashTable) {
+    free(ctx->keyBindings.hashTable);
+    ctx->keyBindings.hashTable = NULL;
+    ctx->keyBindings.hashMask = 0;
+  }
+
+  if (count) {
+    unsigned int size = 0X10;
+    unsigned int *hashTable;
+
+    while (size < (count * 2)) size <<= 1;
+
+    if (!(hashTable = calloc(size, sizeof(*hashTable)))) {
+      logMallocError();
+      return 0;
+    }
+
+    {
+      unsigned int mask = size - 1;
+
+      for (unsigned int index=0; index<count; index+=1) {
+        const KeyBinding *binding = &ctx->keyBindings.table[index];
+        unsigned int slot = hashKeyCombination(&binding->keyCombination) & mask;
+
+        while (hashTable[slot]) slot = (slot + 1) & mask;
+        hashTable[slot] = index + 1;
+      }
+
+      ctx->keyBindings.hashTable = hashTable;
+      ctx->keyBindings.hashMask = mask;
+    }
+  }
+
+  return 1;
+}
+
 static int
 findKeyBinding (
   const KeyBinding *bindings, unsigned int count,
@@ -1555,7 +1650,7 @@ prepareKeyBindings (KeyContext *ctx) {
     ctx->keyBindings.size = ctx->keyBindings.count;
   }
 
-  return 1;
+  return makeKeyBindingHashTable(ctx);
 }
 
 int
@@ -1706,6 +1801,7 @@ destroyKeyTable (KeyTable *table) {
     if (ctx->title) free(ctx->title);
 
     if (ctx->keyBindings.table) free(ctx->keyBindings.table);
+    if (ctx->keyBindings.hashTable) free(ctx->keyBindings.hashTable);
     if (ctx->hotkeys.table) free(ctx->hotkeys.table);
     if (ctx->mappedKeys.table) free(ctx->mappedKeys.table);
   }
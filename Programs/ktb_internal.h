@@ -102,6 +102,9 @@ typedef struct {
     KeyBinding *table;
     unsigned int size;
     unsigned int count;
+
+    unsigned int *hashTable;
+    unsigned int hashMask;
   } keyBindings;
 
   struct {
@@ -192,6 +195,7 @@ extern void removeKeyValue (KeyValue *values, unsigned int *count, unsigned int
 extern int deleteKeyValue (KeyValue *values, unsigned int *count, const KeyValue *value);
 
 extern int compareKeyBindings (const KeyBinding *binding1, const KeyBinding *binding2);
+extern const KeyBinding *getKeyBinding (const KeyContext *ctx, const KeyCombination *combination);
 extern int compareHotkeyEntries (const HotkeyEntry *hotkey1, const HotkeyEntry *hotkey2);
 extern int compareMappedKeyEntries (const MappedKeyEntry *map1, const MappedKeyEntry *map2);
 
@@ -697,31 +697,29 @@ listKeyContext (ListGenerationData *lgd, const KeyContext *ctx) {
 }
 
 static int
-listSpecialKeyContexts (ListGenerationData *lgd) {
+listSpecialKeyContext (ListGenerationData *lgd, unsigned int item, int *more) {
   static const unsigned char contexts[] = {
     KTB_CTX_DEFAULT,
     KTB_CTX_MENU
   };
 
-  const unsigned char *context = contexts;
-  unsigned int count = ARRAY_COUNT(contexts);
-
-  while (count) {
-    const KeyContext *ctx = getKeyContext(lgd->keyTable, *context);
+  if (item < ARRAY_COUNT(contexts)) {
+    const KeyContext *ctx = getKeyContext(lgd->keyTable, contexts[item]);
 
     if (ctx) {
       if (!listKeyContext(lgd, ctx)) return 0;
     }
-
-    context += 1, count -= 1;
   }
 
+  *more = (item + 1) < ARRAY_COUNT(contexts);
   return 1;
 }
 
 static int
-listPersistentKeyContexts (ListGenerationData *lgd) {
-  for (unsigned int context=KTB_CTX_DEFAULT+1; context<lgd->keyTable->keyContexts.count; context+=1) {
+listPersistentKeyContext (ListGenerationData *lgd, unsigned int item, int *more) {
+  unsigned int context = KTB_CTX_DEFAULT + 1 + item;
+
+  if (context < lgd->keyTable->keyContexts.count) {
     const KeyContext *ctx = getKeyContext(lgd->keyTable, context);
 
     if (ctx && !isTemporaryKeyContext(lgd->keyTable, ctx)) {
@@ -729,11 +727,13 @@ listPersistentKeyContexts (ListGenerationData *lgd) {
     }
   }
 
+  *more = (context + 1) < lgd->keyTable->keyContexts.count;
   return 1;
 }
 
 static int
-listKeyTableTitle (ListGenerationData *lgd) {
+listKeyTableTitle (ListGenerationData *lgd, unsigned int item UNUSED, int *more) {
+  *more = 0;
   if (!putUtf8String(lgd, gettext("Key Table"))) return 0;
 
   if (lgd->keyTable->title) {
@@ -749,9 +749,11 @@ listKeyTableTitle (ListGenerationData *lgd) {
 }
 
 static int
-listKeyTableNotes (ListGenerationData *lgd) {
+listKeyTableNotes (ListGenerationData *lgd, unsigned int item UNUSED, int *more) {
   unsigned int noteIndex;
 
+  *more = 0;
+
   if (!beginList(lgd, "Notes")) return 0;
 
   for (noteIndex=0; noteIndex<lgd->keyTable->notes.count; noteIndex+=1) {
@@ -787,25 +789,38 @@ listKeyTableNotes (ListGenerationData *lgd) {
   return 1;
 }
 
-static int
-listKeyTableSections (ListGenerationData *lgd) {
-  typedef int Lister (ListGenerationData *lgd);
+typedef int KeyTableSectionLister (ListGenerationData *lgd, unsigned int item, int *more);
 
-  static Lister *const listerTable[] = {
-    listKeyTableTitle,
-    listKeyTableNotes,
-    listSpecialKeyContexts,
-    listPersistentKeyContexts
-  };
+static KeyTableSectionLister *const sectionListers[] = {
+  listKeyTableTitle,
+  listKeyTableNotes,
+  listSpecialKeyContext,
+  listPersistentKeyContext
+};
 
-  Lister *const *lister = listerTable;
-  Lister *const *end = lister + ARRAY_COUNT(listerTable);
+struct KeyTableListerStruct {
+  ListGenerationData lgd;
 
-  while (lister < end) {
-    if (!(*lister)(lgd)) return 0;
-    lister += 1;
+  unsigned int section;
+  unsigned int item;
+};
+
+int
+listKeyTableSection (KeyTableLister *ktl, int *done) {
+  if (ktl->section < ARRAY_COUNT(sectionListers)) {
+    int more;
+
+    if (!sectionListers[ktl->section](&ktl->lgd, ktl->item, &more)) return 0;
+
+    if (more) {
+      ktl->item += 1;
+    } else {
+      ktl->section += 1;
+      ktl->item = 0;
+    }
   }
 
+  *done = ktl->section == ARRAY_COUNT(sectionListers);
   return 1;
 }
 
@@ -858,50 +873,88 @@ internalEndList (void *data) {
   return 1;
 }
 
-int
-listKeyTable (KeyTable *table, const KeyTableListMethods *methods, KeyTableWriteLineMethod *writeLine, void *data) {
-  static const KeyTableListMethods internalMethods = {
-    .writeHeader = internalWriteHeader,
-    .beginElement = internalBeginElement,
-    .endList = internalEndList
-  };
+static const KeyTableListMethods internalMethods = {
+  .writeHeader = internalWriteHeader,
+  .beginElement = internalBeginElement,
+  .endList = internalEndList
+};
 
-  ListGenerationData lgd = {
-    .keyTable = table,
+KeyTableLister *
+newKeyTableLister (KeyTable *table, const KeyTableListMethods *methods, KeyTableWriteLineMethod *writeLine, void *data) {
+  KeyTableLister *ktl;
+
+  if ((ktl = malloc(sizeof(*ktl)))) {
+    const KeyTableLister lister = {
+      .lgd = {
+        .keyTable = table,
+
+        .topicHeader = NULL,
+        .listHeader = NULL,
+
+        .line = {
+          .characters = NULL,
+          .size = 0,
+          .length = 0,
+        },
+
+        .list = {
+          .methods = methods? methods: &internalMethods,
+          .writeLine = writeLine,
+          .data = data,
+          .internal = !methods,
+
+          .elementLevel = 0
+        },
+
+        .binding = {
+          .lines = NULL,
+          .size = 0,
+          .count = 0
+        }
+      },
 
-    .topicHeader = NULL,
-    .listHeader = NULL,
+      .section = 0,
+      .item = 0
+    };
 
-    .line = {
-      .characters = NULL,
-      .size = 0,
-      .length = 0,
-    },
+    memcpy(ktl, &lister, sizeof(*ktl));
+    return ktl;
+  } else {
+    logMallocError();
+  }
 
-    .list = {
-      .methods = methods? methods: &internalMethods,
-      .writeLine = writeLine,
-      .data = data,
-      .internal = !methods,
+  return NULL;
+}
 
-      .elementLevel = 0
-    },
+void
+destroyKeyTableLister (KeyTableLister *ktl) {
+  ListGenerationData *lgd = &ktl->lgd;
 
-    .binding = {
-      .lines = NULL,
-      .size = 0,
-      .count = 0
-    }
-  };
+  if (lgd->binding.lines) {
+    removeBindingLines(lgd);
+    free(lgd->binding.lines);
+  }
+
+  if (lgd->line.characters) free(lgd->line.characters);
+  free(ktl);
+}
+
+int
+listKeyTable (KeyTable *table, const KeyTableListMethods *methods, KeyTableWriteLineMethod *writeLine, void *data) {
+  int result = 0;
+  KeyTableLister *ktl = newKeyTableLister(table, methods, writeLine, data);
+
+  if (ktl) {
+    int done = 0;
 
-  int result = listKeyTableSections(&lgd);
+    do {
+      if (!listKeyTableSection(ktl, &done)) break;
+    } while (!done);
 
-  if (lgd.binding.lines) {
-    removeBindingLines(&lgd);
-    free(lgd.binding.lines);
+    if (done) result = 1;
+    destroyKeyTableLister(ktl);
   }
 
-  if (lgd.line.characters) free(lgd.line.characters);
   return result;
 }
 
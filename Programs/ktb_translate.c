@@ -93,13 +93,6 @@ sortModifierKeys (const void *element1, const void *element2) {
   return compareKeyValues(modifier1, modifier2);
 }
 
-static int
-searchKeyBinding (const void *target, const void *element) {
-  const KeyBinding *reference = target;
-  const KeyBinding *binding = element;
-  return compareKeyBindings(reference, binding);
-}
-
 static const KeyBinding *
 findKeyBinding (KeyTable *table, unsigned char context, const KeyValue *immediate, int *isIncomplete) {
   const KeyContext *ctx = getKeyContext(table, context);
@@ -108,13 +101,13 @@ findKeyBinding (KeyTable *table, unsigned char context, const KeyValue *immediat
   if (!ctx->keyBindings.table) return NULL;
   if (table->pressedKeys.count > MAX_MODIFIERS_PER_COMBINATION) return NULL;
 
-  KeyBinding target = {
-    .keyCombination.modifierCount = table->pressedKeys.count
+  KeyCombination target = {
+    .modifierCount = table->pressedKeys.count
   };
 
   if (immediate) {
-    target.keyCombination.immediateKey = *immediate;
-    target.keyCombination.flags |= KCF_IMMEDIATE_KEY;
+    target.immediateKey = *immediate;
+    target.flags |= KCF_IMMEDIATE_KEY;
   }
 
   while (1) {
@@ -126,23 +119,22 @@ findKeyBinding (KeyTable *table, unsigned char context, const KeyValue *immediat
         unsigned int bit;
 
         for (index=0, bit=1; index<table->pressedKeys.count; index+=1, bit<<=1) {
-          KeyValue *modifier = &target.keyCombination.modifierKeys[index];
+          KeyValue *modifier = &target.modifierKeys[index];
 
           *modifier = table->pressedKeys.table[index];
           if (bits & bit) modifier->number = KTB_KEY_ANY;
         }
       }
 
-      qsort(
-        target.keyCombination.modifierKeys, table->pressedKeys.count,
-        sizeof(*target.keyCombination.modifierKeys), sortModifierKeys
-      );
+      if (bits) {
+        qsort(
+          target.modifierKeys, table->pressedKeys.count,
+          sizeof(*target.modifierKeys), sortModifierKeys
+        );
+      }
 
       {
-        const KeyBinding *binding = bsearch(&target, ctx->keyBindings.table,
-                                            ctx->keyBindings.count,
-                                            sizeof(*ctx->keyBindings.table),
-                                            searchKeyBinding);
+        const KeyBinding *binding = getKeyBinding(ctx, &target);
 
         if (binding) {
           if (binding->primaryCommand.value != EOF) return binding;
@@ -151,9 +143,9 @@ findKeyBinding (KeyTable *table, unsigned char context, const KeyValue *immediat
       }
     }
 
-    if (!(target.keyCombination.flags & KCF_IMMEDIATE_KEY)) break;
-    if (target.keyCombination.immediateKey.number == KTB_KEY_ANY) break;
-    target.keyCombination.immediateKey.number = KTB_KEY_ANY;
+    if (!(target.flags & KCF_IMMEDIATE_KEY)) break;
+    if (target.immediateKey.number == KTB_KEY_ANY) break;
+    target.immediateKey.number = KTB_KEY_ANY;
   }
 
   return NULL;
@@ -490,6 +482,28 @@ isRepeatableCommand (int command) {
   return 0;
 }
 
+static const HotkeyEntry *
+findHotkey (KeyTable *table, unsigned char context, const KeyValue *keyValue) {
+  const HotkeyEntry *hotkey = findHotkeyEntry(table, context, keyValue);
+
+  if (!hotkey) {
+    const KeyValue anyKey = {
+      .group = keyValue->group,
+      .number = KTB_KEY_ANY
+    };
+
+    hotkey = findHotkeyEntry(table, context, &anyKey);
+  }
+
+  return hotkey;
+}
+
+static void
+beginKeyCombination (KeyTable *table) {
+  table->context.current = table->context.next;
+  table->context.next = table->context.persistent;
+}
+
 KeyTableState
 processKeyEvent (
   KeyTable *table, unsigned char context,
@@ -504,22 +518,10 @@ processKeyEvent (
   int command = EOF;
   const HotkeyEntry *hotkey;
 
-  if (press && !table->pressedKeys.count) {
-    table->context.current = table->context.next;
-    table->context.next = table->context.persistent;
-  }
+  if (press && !table->pressedKeys.count) beginKeyCombination(table);
   if (context == KTB_CTX_DEFAULT) context = table->context.current;
 
-  if (!(hotkey = findHotkeyEntry(table, context, &keyValue))) {
-    const KeyValue anyKey = {
-      .group = keyValue.group,
-      .number = KTB_KEY_ANY
-    };
-
-    hotkey = findHotkeyEntry(table, context, &anyKey);
-  }
-
-  if (hotkey) {
+  if ((hotkey = findHotkey(table, context, &keyValue))) {
     const BoundCommand *cmd = press? &hotkey->pressCommand: &hotkey->releaseCommand;
 
     if (cmd->value != BRL_CMD_NOOP) processCommand(table, (command = cmd->value));
@@ -640,11 +642,136 @@ processKeyEvent (
   return state;
 }
 
+static unsigned char
+getEventContext (KeyTable *table, unsigned char context, const KeyTableEvent *event) {
+  if (context == KTB_CTX_DEFAULT) {
+    context = (event->press && !table->pressedKeys.count)?
+              table->context.next:
+              table->context.current;
+  }
+
+  return context;
+}
+
+static int
+isHotkeyEvent (KeyTable *table, unsigned char context, const KeyTableEvent *event) {
+  const KeyValue keyValue = {
+    .group = event->group,
+    .number = event->number
+  };
+
+  return !!findHotkey(table, getEventContext(table, context, event), &keyValue);
+}
+
+static int
+canDeferKeyEvent (
+  KeyTable *table, unsigned char context,
+  const KeyTableEvent *event, const KeyTableEvent *next
+) {
+  if (next->press != event->press) return 0;
+  if (isHotkeyEvent(table, context, event)) return 0;
+  if (isHotkeyEvent(table, context, next)) return 0;
+
+  if (event->press) {
+    /* A deferred press mustn't have any effect of its own, and the next
+     * press must replace whatever it would have left pending.
+     */
+    const KeyValue keyValue = {
+      .group = event->group,
+      .number = event->number
+    };
+
+    const KeyValue nextValue = {
+      .group = next->group,
+      .number = next->number
+    };
+
+    unsigned int keyPosition;
+    int isIncomplete = 0;
+
+    context = getEventContext(table, context, event);
+    if (context == KTB_CTX_WAITING) return 0;
+
+    if (compareKeyValues(&keyValue, &nextValue) == 0) return 0;
+    if (findPressedKey(table, &keyValue, &keyPosition)) return 0;
+    if (findPressedKey(table, &nextValue, &keyPosition)) return 0;
+
+    if (findKeyBinding(table, context, &keyValue, &isIncomplete)) return 0;
+
+    if (context != KTB_CTX_DEFAULT) {
+      if (findKeyBinding(table, KTB_CTX_DEFAULT, &keyValue, &isIncomplete)) return 0;
+    }
+  }
+
+  return 1;
+}
+
+static void
+updatePressedKeys (KeyTable *table, unsigned char context, const KeyTableEvent *event) {
+  const KeyValue keyValue = {
+    .group = event->group,
+    .number = event->number
+  };
+
+  unsigned int keyPosition;
+  int wasPressed = findPressedKey(table, &keyValue, &keyPosition);
+
+  if (event->press) {
+    if (!table->pressedKeys.count) beginKeyCombination(table);
+    if (!wasPressed) insertPressedKey(table, &keyValue, keyPosition);
+  } else if (wasPressed) {
+    removePressedKey(table, keyPosition);
+  }
+
+  if (context == KTB_CTX_DEFAULT) context = table->context.current;
+  logKeyEvent(table, (event->press? "press": "release"), context, &keyValue, EOF);
+}
+
+KeyTableState
+processKeyEvents (
+  KeyTable *table, unsigned char context,
+  const KeyTableEvent *events, unsigned int count
+) {
+  KeyTableState state = KTS_UNBOUND;
+  const KeyTableEvent *event = events;
+  const KeyTableEvent *end = event + count;
+
+  while (event < end) {
+    const KeyTableEvent *next = event + 1;
+
+    if ((next < end) && canDeferKeyEvent(table, context, event, next)) {
+      /* Within a run of presses (or releases), an event which wouldn't
+       * itself generate a command just updates the set of pressed keys so
+       * that the whole chord is looked up (and its alarms are set) once.
+       */
+      updatePressedKeys(table, context, event);
+    } else {
+      state = processKeyEvent(table, context, event->group, event->number, event->press);
+    }
+
+    event = next;
+  }
+
+  return state;
+}
+
 void
 releaseAllKeys (KeyTable *table) {
-  while (table->pressedKeys.count) {
-    const KeyValue *kv = &table->pressedKeys.table[0];
-    processKeyEvent(table, KTB_CTX_DEFAULT, kv->group, kv->number, 0);
+  unsigned int count = table->pressedKeys.count;
+
+  if (count) {
+    KeyTableEvent events[count];
+
+    for (unsigned int index=0; index<count; index+=1) {
+      const KeyValue *kv = &table->pressedKeys.table[index];
+      KeyTableEvent *event = &events[index];
+
+      event->group = kv->group;
+      event->number = kv->number;
+      event->press = 0;
+    }
+
+    processKeyEvents(table, KTB_CTX_DEFAULT, events, count);
   }
 }
 
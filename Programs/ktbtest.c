@@ -0,0 +1,410 @@
+/*
+ * BRLTTY - A background process providing access to the console screen (when in
+ *          text mode) for a blind person using a refreshable braille display.
+ *
+ * Copyright (C) 1995-2021 by The BRLTTY Developers.
+ *
+ * BRLTTY comes with ABSOLUTELY NO WARRANTY.
+ *
+ * This is free software, placed under the terms of the
+ * GNU Lesser General Public License, as published by the Free Software
+ * Foundation; either version 2.1 of the License, or (at your option) any
+ * later version. Please see the file LICENSE-LGPL for details.
+ *
+ * Web Page: http://brltty.app/
+ *
+ * This software is maintained by Dave Mielke <dave@mielke.cc>.
+ */
+
+#include "prologue.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "log.h"
+#include "program.h"
+#include "options.h"
+#include "parse.h"
+#include "dynld.h"
+#include "prefs.h"
+#include "brl_cmds.h"
+#include "cmd_enqueue.h"
+#include "ktb.h"
+#include "ktb_keyboard.h"
+#include "ktb_internal.h"
+#include "ktb_inspect.h"
+#include "brl.h"
+
+static char *opt_tablesDirectory;
+char *opt_driversDirectory;
+static char *opt_keyboardTable;
+static char *opt_driverTable;
+
+BEGIN_OPTION_TABLE(programOptions)
+  { .word = "driver-table",
+    .letter = 'd',
+    .argument = "driver-device",
+    .setting.string = &opt_driverTable,
+    .description = "the braille driver key table whose bound keys are chorded"
+  },
+
+  { .word = "keyboard-table",
+    .letter = 'k',
+    .argument = "name",
+    .setting.string = &opt_keyboardTable,
+    .internal.setting = "braille",
+    .description = "the keyboard table whose mapped keys are chorded"
+  },
+
+  { .word = "tables-directory",
+    .letter = 'T',
+    .argument = "directory",
+    .setting.string = &opt_tablesDirectory,
+    .internal.setting = TABLES_DIRECTORY,
+    .internal.adjust = fixInstallPath,
+    .description = "path to directory containing tables"
+  },
+
+  { .word = "drivers-directory",
+    .letter = 'D',
+    .argument = "directory",
+    .setting.string = &opt_driversDirectory,
+    .internal.setting = DRIVERS_DIRECTORY,
+    .internal.adjust = fixInstallPath,
+    .description = "path to directory for loading drivers"
+  },
+END_OPTION_TABLE
+
+typedef struct {
+  int *array;
+  unsigned int size;
+  unsigned int count;
+} CommandList;
+
+static CommandList *commandList = NULL;
+
+int
+enqueueCommand (int command) {
+  if (command == EOF) return 1;
+  if (command == BRL_CMD_NOOP) return 1;
+
+  if (commandList) {
+    CommandList *list = commandList;
+
+    if (list->count == list->size) {
+      unsigned int newSize = list->size? list->size<<1: 0X100;
+      int *newArray = realloc(list->array, ARRAY_SIZE(newArray, newSize));
+
+      if (!newArray) {
+        logMallocError();
+        return 0;
+      }
+
+      list->array = newArray;
+      list->size = newSize;
+    }
+
+    list->array[list->count++] = command;
+  }
+
+  return 1;
+}
+
+typedef struct {
+  KeyValue keys[MAX_MODIFIERS_PER_COMBINATION];
+  unsigned int count;
+} ChordKeys;
+
+typedef struct {
+  KEY_NAME_TABLES_REFERENCE names;
+  char *path;
+} ChordTable;
+
+static void *driverObject = NULL;
+
+static int
+getDriverChordTable (ChordTable *table, const char *name) {
+  int ok = 0;
+  int count;
+  char **components = splitString(name, '-', &count);
+
+  if (components) {
+    if (count == 2) {
+      const char *driverCode = components[0];
+      const char *deviceType = components[1];
+
+      if (loadBrailleDriver(driverCode, &driverObject, opt_driversDirectory)) {
+        char *symbol;
+
+        {
+          const char *strings[] = {"brl_ktb_", driverCode};
+          symbol = joinStrings(strings, ARRAY_COUNT(strings));
+        }
+
+        if (symbol) {
+          const KeyTableDefinition *const *definition;
+
+          if (findSharedSymbol(driverObject, symbol, &definition)) {
+            while (*definition) {
+              if (strcmp(deviceType, (*definition)->bindings) == 0) {
+                table->names = (*definition)->names;
+                if ((table->path = makeInputTablePath(opt_tablesDirectory, driverCode, deviceType))) ok = 1;
+                break;
+              }
+
+              definition += 1;
+            }
+
+            if (!*definition) {
+              logMessage(LOG_ERR, "unknown braille device type: %s", name);
+            }
+          }
+
+          free(symbol);
+        } else {
+          logMallocError();
+        }
+      }
+    } else {
+      logMessage(LOG_ERR, "driver table name not driver-device: %s", name);
+    }
+
+    deallocateStrings(components);
+  }
+
+  return ok;
+}
+
+static int
+getChordTable (ChordTable *table) {
+  table->names = NULL;
+  table->path = NULL;
+
+  if (opt_driverTable && *opt_driverTable) {
+    return getDriverChordTable(table, opt_driverTable);
+  }
+
+  table->names = KEY_NAME_TABLES(keyboard);
+  return !!(table->path = makeKeyboardTablePath(opt_tablesDirectory, opt_keyboardTable));
+}
+
+static KeyTable *
+compileChordTable (const ChordTable *table) {
+  KeyTable *keyTable = compileKeyTable(table->path, table->names);
+
+  if (!keyTable) logMessage(LOG_ERR, "cannot compile key table: %s", table->path);
+  return keyTable;
+}
+
+static void
+addChordKey (ChordKeys *chord, const KeyValue *key) {
+  if (chord->count == ARRAY_COUNT(chord->keys)) return;
+  if (key->number == KTB_KEY_ANY) return;
+
+  for (unsigned int index=0; index<chord->count; index+=1) {
+    if (compareKeyValues(&chord->keys[index], key) == 0) return;
+  }
+
+  chord->keys[chord->count++] = *key;
+}
+
+static int
+getChordKeys (KeyTable *table, const ChordTable *chordTable, ChordKeys *chord) {
+  const KeyContext *ctx = getKeyContext(table, KTB_CTX_DEFAULT);
+
+  chord->count = 0;
+
+  if (ctx) {
+    for (unsigned int index=0; index<ctx->mappedKeys.count; index+=1) {
+      addChordKey(chord, &ctx->mappedKeys.table[index].keyValue);
+    }
+
+    /* Driver tables don't map keys, so chord the keys of the bindings.
+     * Immediate (!) keys come first so that they're always included.
+     */
+    for (unsigned int index=0; index<ctx->keyBindings.count; index+=1) {
+      const KeyCombination *combination = &ctx->keyBindings.table[index].keyCombination;
+
+      if (combination->flags & KCF_IMMEDIATE_KEY) {
+        addChordKey(chord, &combination->immediateKey);
+      }
+    }
+
+    for (unsigned int index=0; index<ctx->keyBindings.count; index+=1) {
+      const KeyCombination *combination = &ctx->keyBindings.table[index].keyCombination;
+
+      for (unsigned int modifier=0; modifier<combination->modifierCount; modifier+=1) {
+        addChordKey(chord, &combination->modifierKeys[modifier]);
+      }
+    }
+  }
+
+  if (chord->count) return 1;
+  logMessage(LOG_ERR, "key table has no keys to chord: %s", chordTable->path);
+  return 0;
+}
+
+static unsigned int
+makeChord (const ChordKeys *keys, unsigned int size, KeyTableEvent *presses) {
+  unsigned char used[keys->count];
+  unsigned int count = 0;
+
+  memset(used, 0, sizeof(used));
+  if (size > keys->count) size = keys->count;
+
+  while (count < size) {
+    unsigned int index = rand() % keys->count;
+
+    if (!used[index]) {
+      KeyTableEvent *event = &presses[count++];
+
+      used[index] = 1;
+      event->group = keys->keys[index].group;
+      event->number = keys->keys[index].number;
+      event->press = 1;
+    }
+  }
+
+  return count;
+}
+
+static void
+makeReleases (const KeyTableEvent *presses, unsigned int count, KeyTableEvent *releases) {
+  for (unsigned int index=0; index<count; index+=1) {
+    releases[index] = presses[index];
+    releases[index].press = 0;
+  }
+}
+
+static void
+typeChordSequentially (KeyTable *table, const KeyTableEvent *presses, const KeyTableEvent *releases, unsigned int count) {
+  for (unsigned int index=0; index<count; index+=1) {
+    const KeyTableEvent *event = &presses[index];
+    processKeyEvent(table, KTB_CTX_DEFAULT, event->group, event->number, 1);
+  }
+
+  for (unsigned int index=0; index<count; index+=1) {
+    const KeyTableEvent *event = &releases[index];
+    processKeyEvent(table, KTB_CTX_DEFAULT, event->group, event->number, 0);
+  }
+}
+
+static void
+typeChordInBatches (KeyTable *table, const KeyTableEvent *presses, const KeyTableEvent *releases, unsigned int count) {
+  processKeyEvents(table, KTB_CTX_DEFAULT, presses, count);
+  processKeyEvents(table, KTB_CTX_DEFAULT, releases, count);
+}
+
+static int
+verifyChordTranslation (KeyTable *sequential, KeyTable *batched, const ChordKeys *keys) {
+  CommandList sequentialCommands = { .array = NULL };
+  CommandList batchedCommands = { .array = NULL };
+  int ok = 1;
+
+  for (unsigned int chord=0; chord<1000; chord+=1) {
+    KeyTableEvent presses[keys->count];
+    KeyTableEvent releases[keys->count];
+    unsigned int count = makeChord(keys, (rand() % keys->count) + 1, presses);
+    makeReleases(presses, count, releases);
+
+    commandList = &sequentialCommands;
+    typeChordSequentially(sequential, presses, releases, count);
+
+    commandList = &batchedCommands;
+    typeChordInBatches(batched, presses, releases, count);
+
+    commandList = NULL;
+
+    if ((sequentialCommands.count != batchedCommands.count) ||
+        (memcmp(sequentialCommands.array, batchedCommands.array,
+                ARRAY_SIZE(sequentialCommands.array, sequentialCommands.count)) != 0)) {
+      logMessage(LOG_ERR, "chord %u: batched translation differs (%u keys, %u/%u commands)",
+                 chord, count, sequentialCommands.count, batchedCommands.count);
+      ok = 0;
+      break;
+    }
+
+    if (sequential->pressedKeys.count || batched->pressedKeys.count) {
+      logMessage(LOG_ERR, "chord %u: keys still pressed", chord);
+      ok = 0;
+      break;
+    }
+  }
+
+  if (ok) {
+    if (!sequentialCommands.count) {
+      logMessage(LOG_ERR, "no commands generated");
+      ok = 0;
+    } else {
+      printf("chord translation verified: %u commands\n", sequentialCommands.count);
+    }
+  }
+
+  if (sequentialCommands.array) free(sequentialCommands.array);
+  if (batchedCommands.array) free(batchedCommands.array);
+  return ok;
+}
+
+int
+main (int argc, char *argv[]) {
+  ProgramExitStatus exitStatus = PROG_EXIT_FATAL;
+
+  {
+    static const OptionsDescriptor descriptor = {
+      OPTION_TABLE(programOptions),
+      .applicationName = "ktbtest",
+      .argumentsSummary = ""
+    };
+
+    PROCESS_OPTIONS(descriptor, argc, argv);
+  }
+
+  resetPreferences();
+  srand(1);
+
+  {
+    ChordTable chordTable;
+
+    if (getChordTable(&chordTable)) {
+      KeyTable *sequential = compileChordTable(&chordTable);
+
+      if (sequential) {
+        KeyTable *batched = compileChordTable(&chordTable);
+
+        if (batched) {
+          ChordKeys keys;
+
+          if (getChordKeys(sequential, &chordTable, &keys)) {
+            if (verifyChordTranslation(sequential, batched, &keys)) exitStatus = PROG_EXIT_SUCCESS;
+          }
+
+          destroyKeyTable(batched);
+        }
+
+        destroyKeyTable(sequential);
+      }
+    }
+
+    if (chordTable.path) free(chordTable.path);
+  }
+
+  if (driverObject) unloadSharedObject(driverObject);
+  return exitStatus;
+}
+
+#include "cmd_queue.h"
+
+KeyTableCommandContext
+getCurrentCommandContext (void) {
+  return KTB_CTX_DEFAULT;
+}
+
+#include "alert.h"
+
+void
+alert (AlertIdentifier identifier) {
+}
+
+#include "api_control.h"
+
+const ApiMethods api;
@@ -125,6 +125,18 @@ static const LogCategoryEntry logCategoryTable[LOG_CATEGORY_COUNT] = {
     .prefix = "server"
   },
 
+  [LOG_CATEGORY_INDEX(STARTUP_EVENTS)] = {
+    .name = "startup",
+    .title = strtext("Startup Events"),
+    .prefix = "startup"
+  },
+
+  [LOG_CATEGORY_INDEX(QUEUE_EVENTS)] = {
+    .name = "queue",
+    .title = strtext("Queue Events"),
+    .prefix = "queue"
+  },
+
   [LOG_CATEGORY_INDEX(SERIAL_IO)] = {
     .name = "serial",
     .title = strtext("Serial I/O"),
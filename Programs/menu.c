@@ -29,45 +29,26 @@
 #include <langinfo.h>
 #endif /* HAVE_LANGINFO_H */
 
-#undef CAN_GLOB
-#if defined(HAVE_GLOB)
-#define CAN_GLOB
-#include <glob.h>
-
-#elif defined(__MINGW32__)
-#define CAN_GLOB
-#include <io.h>
-
-#else /* glob: paradigm-specific global definitions */
-#warning file globbing support not available on this platform
-#endif /* glob: paradigm-specific global definitions */
-
 #include "log.h"
 #include "menu.h"
 #include "prefs.h"
 #include "timing.h"
 #include "parse.h"
 #include "file.h"
+#include "catalog.h"
 
 typedef struct {
-  char *directory;
+  FileCatalog *catalog;
+  FileCatalogListing *listing;
   const char *extension;
-  const char *pattern;
   char *initial;
   char *current;
   unsigned none:1;
 
-#if defined(HAVE_GLOB)
-  glob_t glob;
-#elif defined(__MINGW32__)
-  char **names;
-  int offset;
-#endif /* glob: paradigm-specific field declarations */
-
-  char **paths;
-  int count;
+  const char **paths;
+  unsigned int count;
   unsigned char setting;
-  char *pathsArea[3];
+  const char **pathsArea;
 } FileData;
 
 typedef struct {
@@ -522,115 +503,45 @@ newBooleanMenuItem (Menu *menu, unsigned char *setting, const MenuString *name)
   return newEnumeratedMenuItem(menu, setting, name, strings);
 }
 
-static int
-qsortCompare_fileNames (const void *element1, const void *element2) {
-  const char *const *name1 = element1;
-  const char *const *name2 = element2;
-  return strcmp(*name1, *name2);
-}
-
 static int
 beginItem_files (MenuItem *item) {
   FileData *files = item->data.files;
-  int index;
+  unsigned int count;
+  unsigned int index;
+  int haveInitial;
 
-  files->paths = files->pathsArea;
-  files->count = ARRAY_COUNT(files->pathsArea) - 1;
-  files->paths[files->count] = NULL;
-  index = files->count;
+  files->listing = getFileCatalogListing(files->catalog);
+  count = files->listing? getFileCatalogCount(files->listing): 0;
 
-#ifdef CAN_GLOB
-  {
-#ifdef HAVE_FCHDIR
-    int originalDirectory = open(".", O_RDONLY);
-
-    if (originalDirectory != -1)
-#else /* HAVE_FCHDIR */
-    char *originalDirectory = getWorkingDirectory();
-
-    if (originalDirectory)
-#endif /* HAVE_FCHDIR */
-    {
-      if (chdir(files->directory) != -1) {
-#if defined(HAVE_GLOB)
-        memset(&files->glob, 0, sizeof(files->glob));
-        files->glob.gl_offs = files->count;
-
-        if (glob(files->pattern, GLOB_DOOFFS, NULL, &files->glob) == 0) {
-          files->paths = files->glob.gl_pathv;
-
-          /* The behaviour of gl_pathc is inconsistent. Some implementations
-           * include the leading NULL pointers and some don't. Let's just
-           * figure it out the hard way by finding the trailing NULL.
-           */
-          while (files->paths[files->count]) files->count += 1;
-        }
-#elif defined(__MINGW32__)
-        struct _finddata_t findData;
-        long findHandle = _findfirst(files->pattern, &findData);
-        int allocated = files->count | 0XF;
-
-        files->offset = files->count;
-        files->names = malloc(allocated * sizeof(*files->names));
-
-        if (findHandle != -1) {
-          do {
-            if (files->count >= allocated) {
-              allocated = allocated * 2;
-              files->names = realloc(files->names, allocated * sizeof(*files->names));
-            }
+  if (!(files->pathsArea = malloc(ARRAY_SIZE(files->pathsArea, count + 2)))) {
+    logMallocError();
+    if (files->listing) releaseFileCatalogListing(files->listing);
+    files->listing = NULL;
+    return 0;
+  }
 
-            files->names[files->count++] = strdup(findData.name);
-          } while (_findnext(findHandle, &findData) == 0);
+  files->paths = files->pathsArea;
 
-          _findclose(findHandle);
-        }
+  haveInitial = files->none && !*files->initial;
+  files->count = 1;
+  if (files->none) files->paths[files->count++] = "";
 
-        files->names = realloc(files->names, files->count * sizeof(*files->names));
-        files->paths = files->names;
-#endif /* glob: paradigm-specific field initialization */
+  for (index=0; index<count; index+=1) {
+    const char *name = getFileCatalogName(files->listing, index);
 
-#ifdef HAVE_FCHDIR
-        if (fchdir(originalDirectory) == -1) logSystemError("fchdir");
-#else /* HAVE_FCHDIR */
-        if (chdir(originalDirectory) == -1) logSystemError("chdir");
-#endif /* HAVE_FCHDIR */
-      } else {
-        logMessage(LOG_ERR, "%s: %s: %s",
-                   gettext("cannot set working directory"), files->directory, strerror(errno));
-      }
+    if (strcmp(name, files->initial) == 0) haveInitial = 1;
+    files->paths[files->count++] = name;
+  }
 
-#ifdef HAVE_FCHDIR
-      close(originalDirectory);
-#else /* HAVE_FCHDIR */
-      free(originalDirectory);
-#endif /* HAVE_FCHDIR */
-    } else {
-#ifdef HAVE_FCHDIR
-      logMessage(LOG_ERR, "%s: %s",
-                 gettext("cannot open working directory"), strerror(errno));
-#else /* HAVE_FCHDIR */
-      logMessage(LOG_ERR, "%s", gettext("cannot determine working directory"));
-#endif /* HAVE_FCHDIR */
-    }
+  if (haveInitial) {
+    files->paths += 1;
+    files->count -= 1;
+  } else {
+    files->paths[0] = files->initial;
   }
-#endif /* CAN_GLOB */
 
-  qsort(&files->paths[index], files->count-index, sizeof(*files->paths), qsortCompare_fileNames);
-  if (files->none) files->paths[--index] = "";
-  files->paths[--index] = files->initial;
-  files->paths += index;
-  files->count -= index;
   files->setting = 0;
 
-  for (index=1; index<files->count; index+=1) {
-    if (strcmp(files->paths[index], files->initial) == 0) {
-      files->paths += 1;
-      files->count -= 1;
-      break;
-    }
-  }
-
   for (index=0; index<files->count; index+=1) {
     if (strcmp(files->paths[index], files->current) == 0) {
       files->setting = index;
@@ -649,21 +560,16 @@ endItem_files (MenuItem *item, int deallocating) {
   if (files->current) free(files->current);
   files->current = deallocating? NULL: strdup(files->paths[files->setting]);
 
-#if defined(HAVE_GLOB)
-  if (files->glob.gl_pathc) {
-    for (int i=0; i<files->glob.gl_offs; i+=1) files->glob.gl_pathv[i] = NULL;
-    globfree(&files->glob);
-    files->glob.gl_pathc = 0;
+  if (files->pathsArea) {
+    free(files->pathsArea);
+    files->pathsArea = NULL;
+    files->paths = NULL;
   }
-#elif defined(__MINGW32__)
-  if (files->names) {
-    int i;
 
-    for (i=files->offset; i<files->count; i+=1) free(files->names[i]);
-    free(files->names);
-    files->names = NULL;
+  if (files->listing) {
+    releaseFileCatalogListing(files->listing);
+    files->listing = NULL;
   }
-#endif /* glob: paradigm-specific memory deallocation */
 }
 
 static const char *
@@ -704,11 +610,27 @@ getText_files (const MenuItem *item) {
   return path;
 }
 
+static const char *
+getComment_files (const MenuItem *item) {
+  const FileData *files = item->data.files;
+  const char *name = getMenuItemValue(item);
+  const char *comment = NULL;
+
+  if (*name) {
+    if (!(comment = getFileCatalogTitle(files->catalog, name))) {
+      comment = getFileCatalogLanguage(files->catalog, name);
+    }
+  }
+
+  return comment? comment: "";
+}
+
 static const MenuItemMethods menuItemMethods_files = {
   .beginItem = beginItem_files,
   .endItem = endItem_files,
   .getValue = getValue_files,
-  .getText = getText_files
+  .getText = getText_files,
+  .getComment = getComment_files
 };
 
 MenuItem *
@@ -720,29 +642,25 @@ newFilesMenuItem (
   FileData *files;
 
   if ((files = malloc(sizeof(*files)))) {
-    char *pattern;
-
     memset(files, 0, sizeof(*files));
     files->extension = extension;
     files->none = !!none;
 
-    {
-      const char *strings[] = {"*", extension};
-      pattern = joinStrings(strings, ARRAY_COUNT(strings));
-    }
+    if ((files->initial = *initial? ensureFileExtension(initial, extension): strdup(""))) {
+      if ((files->current = strdup(files->initial))) {
+        char *path;
 
-    if (pattern) {
-      files->pattern = pattern; 
+        if (subdirectory) {
+          path = makePath(directory, subdirectory);
+        } else if (!(path = strdup(directory))) {
+          logMallocError();
+        }
 
-      if ((files->initial = *initial? ensureFileExtension(initial, extension): strdup(""))) {
-        if ((files->current = strdup(files->initial))) {
-          if (subdirectory) {
-            files->directory = makePath(directory, subdirectory);
-          } else if (!(files->directory = strdup(directory))) {
-            logMallocError();
-          }
+        if (path) {
+          files->catalog = getFileCatalog(path, extension);
+          free(path);
 
-          if (files->directory) {
+          if (files->catalog) {
             MenuItem *item = newMenuItem(menu, &files->setting, name);
 
             if (item) {
@@ -750,21 +668,15 @@ newFilesMenuItem (
               item->data.files = files;
               return item;
             }
-
-            free(files->directory);
           }
-
-          free(files->current);
-        } else {
-          logMallocError();
         }
 
-        free(files->initial);
+        free(files->current);
       } else {
         logMallocError();
       }
 
-      free(pattern);
+      free(files->initial);
     } else {
       logMallocError();
     }
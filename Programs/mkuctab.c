@@ -0,0 +1,316 @@
+/*
+ * BRLTTY - A background process providing access to the console screen (when in
+ *          text mode) for a blind person using a refreshable braille display.
+ *
+ * Copyright (C) 1995-2021 by The BRLTTY Developers.
+ *
+ * BRLTTY comes with ABSOLUTELY NO WARRANTY.
+ *
+ * This is free software, placed under the terms of the
+ * GNU Lesser General Public License, as published by the Free Software
+ * Foundation; either version 2.1 of the License, or (at your option) any
+ * later version. Please see the file LICENSE-LGPL for details.
+ *
+ * Web Page: http://brltty.app/
+ *
+ * This software is maintained by Dave Mielke <dave@mielke.cc>.
+ */
+
+/*
+ * This program writes the multi-stage Unicode lookup tables (unicode.auto.h)
+ * which unicode.c uses for character widths, base characters, and character
+ * properties. It's self-contained (rather than using the base objects)
+ * because unicode.c itself depends on its output.
+ */
+
+#include "prologue.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <locale.h>
+
+#include "unicode.h"
+#include "ascii.h"
+
+#ifdef HAVE_ICU
+#include <unicode/uversion.h>
+#include <unicode/uchar.h>
+#include <unicode/utf16.h>
+
+#ifdef HAVE_UNICODE_UNORM2_H
+#include <unicode/unorm2.h>
+#else /* unorm */
+#include <unicode/unorm.h>
+#endif /* unorm */
+#endif /* HAVE_ICU */
+
+#define CHARACTER_COUNT 0X110000
+#define BLOCK_BITS 6
+#define GROUP_BITS 6
+
+#define BLOCK_SIZE (1 << BLOCK_BITS)
+#define GROUP_SIZE (1 << GROUP_BITS)
+#define BLOCK_COUNT (CHARACTER_COUNT / BLOCK_SIZE)
+#define GROUP_COUNT (BLOCK_COUNT / GROUP_SIZE)
+
+#define WIDTH_SHIFT 6
+
+static int
+computeCharacterWidth (wchar_t character) {
+#if defined(HAVE_WCWIDTH)
+  return wcwidth(character);
+#elif defined(HAVE_ICU)
+  UCharCategory category = u_getIntPropertyValue(character, UCHAR_GENERAL_CATEGORY);
+  UEastAsianWidth width = u_getIntPropertyValue(character, UCHAR_EAST_ASIAN_WIDTH);
+
+  if (character == 0) return 0;
+  if (category == U_CONTROL_CHAR) return -1;
+
+  if (category == U_NON_SPACING_MARK) return 0;
+  if (category == U_ENCLOSING_MARK) return 0;
+
+  /* Hangul Jamo medial vowels and final consonants */
+  if ((character >= 0X1160) && (character <= 0X11FF) && (category == U_OTHER_LETTER)) return 0;
+
+  /*  */
+  if (character == 0XAD) return 1; /* soft hyphen */
+  if (category == U_FORMAT_CHAR) return 0;
+
+  if (width == U_EA_FULLWIDTH) return 2;
+  if (width == U_EA_HALFWIDTH) return 1;
+
+  if (width == U_EA_WIDE) return 2;
+  if (width == U_EA_NARROW) return 1;
+
+  if (width == U_EA_AMBIGUOUS) {
+    /* CJK Unified Ideographs block */
+    if ((character >= 0X4E00) && (character <= 0X9FFF)) return 2;
+
+    /* CJK Unified Ideographs Externsion A block */
+    if ((character >= 0X3400) && (character <= 0X4DBF)) return 2;
+
+    /* CJK Compatibility Ideographs block */
+    if ((character >= 0XF900) && (character <= 0XFAFF)) return 2;
+
+    /* Supplementary Ideographic Plane */
+  /* if ((character >= 0X20000) && (character <= 0X2FFFF)) return 2; */
+
+    /* Tertiary Ideographic Plane */
+  /* if ((character >= 0X30000) && (character <= 0X3FFFF)) return 2; */
+  }
+
+  if (category == U_UNASSIGNED) return -1;
+  return 1;
+#else /* character width */
+  if (character == NUL) return 0;
+  if (character == DEL) return -1;
+  if (!(character & 0X60)) return -1;
+  return 1;
+#endif /* character width */
+}
+
+static uint32_t
+computeCharacterProperties (wchar_t character) {
+  uint32_t properties = 0;
+
+#ifdef HAVE_ICU
+  if (u_hasBinaryProperty(character, UCHAR_IDEOGRAPHIC)) {
+    properties |= UNICODE_PROPERTY_IDEOGRAPHIC;
+  }
+
+  #if U_ICU_VERSION_MAJOR_NUM >= 57
+  if (u_hasBinaryProperty(character, UCHAR_EMOJI)) {
+    if (u_hasBinaryProperty(character, UCHAR_EMOJI_PRESENTATION)) {
+      properties |= UNICODE_PROPERTY_EMOJI;
+    }
+  }
+  #endif /* U_ICU_VERSION_MAJOR_NUM >= 57 */
+
+  if (u_getCombiningClass(character)) {
+    properties |= UNICODE_PROPERTY_COMBINING;
+  }
+
+  if (u_getIntPropertyValue(character, UCHAR_NFC_QUICK_CHECK) != UNORM_YES) {
+    properties |= UNICODE_PROPERTY_NFC_UNSTABLE;
+  }
+#endif /* HAVE_ICU */
+
+  {
+    int width = computeCharacterWidth(character);
+    if (width < -1) width = -1;
+    if (width > 2) width = 2;
+    properties |= (width + 1) << WIDTH_SHIFT;
+  }
+
+  return properties;
+}
+
+static uint32_t
+computeBaseCharacter (wchar_t character) {
+#ifdef HAVE_ICU
+  if ((character < UNICODE_SURROGATE_BEGIN) || (character > UNICODE_SURROGATE_END)) {
+    UChar source[2];
+    int32_t sourceLength = 0;
+    UBool error = 0;
+
+    U16_APPEND(source, sourceLength, ARRAY_COUNT(source), character, error);
+
+    if (!error) {
+      UChar result[0X20];
+      UErrorCode status = U_ZERO_ERROR;
+      int32_t resultLength;
+
+#ifdef HAVE_UNICODE_UNORM2_H
+      static const UNormalizer2 *normalizer = NULL;
+
+      if (!normalizer) {
+        normalizer = unorm2_getNFDInstance(&status);
+        if (!U_SUCCESS(status)) return 0;
+      }
+
+      resultLength = unorm2_normalize(normalizer,
+                                      source, sourceLength,
+                                      result, ARRAY_COUNT(result),
+                                      &status);
+#else /* unorm */
+      resultLength = unorm_normalize(source, sourceLength,
+                                     UNORM_NFD, 0,
+                                     result, ARRAY_COUNT(result),
+                                     &status);
+#endif /* unorm */
+
+      if (U_SUCCESS(status) && (resultLength > 0)) {
+        int32_t offset = 0;
+        UChar32 base;
+
+        U16_NEXT(result, offset, resultLength, base);
+        if (base != character) return base;
+      }
+    }
+  }
+#endif /* HAVE_ICU */
+
+  return 0;
+}
+
+typedef struct {
+  const char *name;
+  const char *type;
+  unsigned int width;
+  uint32_t (*compute) (wchar_t character);
+} TableDescriptor;
+
+static uint32_t values[CHARACTER_COUNT];
+
+static uint32_t blockNumbers[BLOCK_COUNT];
+static uint32_t groupNumbers[GROUP_COUNT];
+
+static int
+findDuplicate (const uint32_t *array, size_t count, size_t size, const uint32_t *item, size_t *index) {
+  for (size_t candidate=0; candidate<count; candidate+=1) {
+    if (memcmp(&array[candidate * size], item, (size * sizeof(*item))) == 0) {
+      *index = candidate;
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+static size_t
+removeDuplicates (uint32_t *array, size_t count, size_t size, uint32_t *numbers) {
+  /* Move each distinct item down to the end of the ones found so far. */
+  size_t distinct = 0;
+
+  for (size_t index=0; index<count; index+=1) {
+    const uint32_t *item = &array[index * size];
+    size_t number;
+
+    if (!findDuplicate(array, distinct, size, item, &number)) {
+      number = distinct++;
+      memmove(&array[number * size], item, (size * sizeof(*item)));
+    }
+
+    numbers[index] = number;
+  }
+
+  return distinct;
+}
+
+static void
+writeArray (const char *type, const char *name, const uint32_t *array, size_t count, unsigned int width) {
+  printf("\nstatic const %s %s[] = {", type, name);
+
+  for (size_t index=0; index<count; index+=1) {
+    if (!(index % 8)) printf("\n ");
+    printf(" 0X%0*" PRIX32 ",", width, array[index]);
+  }
+
+  printf("\n};\n");
+}
+
+static void
+writeTable (const TableDescriptor *table) {
+  for (uint32_t character=0; character<CHARACTER_COUNT; character+=1) {
+    values[character] = table->compute(character);
+  }
+
+  size_t blockCount = removeDuplicates(values, BLOCK_COUNT, BLOCK_SIZE, blockNumbers);
+  size_t groupCount = removeDuplicates(blockNumbers, GROUP_COUNT, GROUP_SIZE, groupNumbers);
+
+  char name[0X40];
+
+  snprintf(name, sizeof(name), "%sGroups", table->name);
+  writeArray("uint16_t", name, groupNumbers, GROUP_COUNT, 4);
+
+  snprintf(name, sizeof(name), "%sBlocks", table->name);
+  writeArray("uint16_t", name, blockNumbers, (groupCount * GROUP_SIZE), 4);
+
+  snprintf(name, sizeof(name), "%sValues", table->name);
+  writeArray(table->type, name, values, (blockCount * BLOCK_SIZE), table->width);
+
+  fprintf(stderr, "%s: %zu groups, %zu blocks\n", table->name, groupCount, blockCount);
+}
+
+static const TableDescriptor tables[] = {
+  { .name = "unicodeProperties",
+    .type = "uint8_t",
+    .width = 2,
+    .compute = computeCharacterProperties
+  },
+
+  { .name = "unicodeBaseCharacters",
+    .type = "uint32_t",
+    .width = 6,
+    .compute = computeBaseCharacter
+  },
+};
+
+int
+main (int argc, char *argv[]) {
+#ifdef HAVE_WCWIDTH
+  if (!setlocale(LC_CTYPE, "C.UTF-8")) {
+    if (!setlocale(LC_CTYPE, "en_US.UTF-8")) {
+      fprintf(stderr, "mkuctab: no UTF-8 locale for character widths\n");
+      return 1;
+    }
+  }
+#endif /* HAVE_WCWIDTH */
+
+  printf("/* generated by mkuctab - don't edit */\n\n");
+  printf("#define UNICODE_TABLE_CHARACTER_COUNT 0X%X\n", CHARACTER_COUNT);
+  printf("#define UNICODE_TABLE_BLOCK_BITS %d\n", BLOCK_BITS);
+  printf("#define UNICODE_TABLE_GROUP_BITS %d\n", GROUP_BITS);
+  printf("#define UNICODE_TABLE_WIDTH_SHIFT %d\n", WIDTH_SHIFT);
+
+  for (unsigned int index=0; index<ARRAY_COUNT(tables); index+=1) {
+    writeTable(&tables[index]);
+  }
+
+  if (ferror(stdout) || (fflush(stdout) == EOF)) {
+    perror("mkuctab");
+    return 1;
+  }
+
+  return 0;
+}
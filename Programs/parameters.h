@@ -29,6 +29,8 @@ extern "C" {
 #define DEFAULT_ACTIVITY_START_TIMEOUT 1000
 #define DEFAULT_ACTIVITY_STOP_TIMEOUT 1000
 
+#define STARTUP_TASK_DEFER_TIMEOUT 10000
+
 #define BRAILLE_DRIVER_START_RETRY_INTERVAL 5000
 #define BRAILLE_DRIVER_INPUT_POLL_INTERVAL 40
 
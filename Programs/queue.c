@@ -18,30 +18,15 @@
 
 #include "prologue.h"
 
+#include <string.h>
+
 #include "log.h"
 #include "queue.h"
 #include "lock.h"
+#include "thread.h"
+#include "timing.h"
 #include "program.h"
 
-static Element *discardedElements = NULL;
-
-static LockDescriptor *
-getDiscardedElementsLock (void) {
-  static LockDescriptor *lock = NULL;
-
-  return getLockDescriptor(&lock, "queue-discarded-elements");
-}
-
-static void
-lockDiscardedElements (void) {
-  obtainExclusiveLock(getDiscardedElementsLock());
-}
-
-static void
-unlockDiscardedElements (void) {
-  releaseLock(getDiscardedElementsLock());
-}
-
 struct QueueStruct {
   Element *head;
   unsigned int size;
@@ -87,29 +72,306 @@ removeItem (Element *element) {
   }
 }
 
+/* Discarded elements are cached per thread in a pair of magazines (bounded
+ * lists of elements) so that allocating and discarding them doesn't need a
+ * lock. A full magazine is exchanged with a small global depot only when
+ * both are full (discarding) or empty (allocating), and anything that
+ * doesn't fit into the depot is freed.
+ */
+#define ELEMENT_MAGAZINE_SIZE 32
+#define ELEMENT_DEPOT_SIZE 16
+#define ELEMENT_STATISTICS_FOLD 0X400
+#define ELEMENT_STATISTICS_INTERVAL 0X10000
+
+typedef struct {
+  Element *elements;
+  unsigned int count;
+} ElementMagazine;
+
+typedef struct {
+  unsigned long allocations;
+  unsigned long cacheHits;
+  unsigned long depotHits;
+  unsigned long depotDeposits;
+  unsigned long mallocs;
+  unsigned long frees;
+} ElementStatistics;
+
+typedef struct {
+  ElementMagazine loaded;
+  ElementMagazine previous;
+  ElementStatistics statistics;
+} ElementCache;
+
+static struct {
+  ElementMagazine magazines[ELEMENT_DEPOT_SIZE];
+  unsigned int count;
+
+  ElementStatistics statistics;
+  ElementStatistics reported;
+  TimeValue startTime;
+  TimeValue reportTime;
+} elementDepot;
+
+static LockDescriptor *
+getElementDepotLock (void) {
+  static LockDescriptor *lock = NULL;
+
+  return getLockDescriptor(&lock, "queue-element-depot");
+}
+
+static void
+lockElementDepot (void) {
+  obtainExclusiveLock(getElementDepotLock());
+}
+
+static void
+unlockElementDepot (void) {
+  releaseLock(getElementDepotLock());
+}
+
+static void
+freeElements (Element *element) {
+  while (element) {
+    Element *next = element->next;
+    free(element);
+    element = next;
+  }
+}
+
+static unsigned int
+getPercentage (unsigned long part, unsigned long whole) {
+  if (!whole) return 0;
+  return (part * 100) / whole;
+}
+
+static void
+logElementStatistics (const ElementStatistics *current, const ElementStatistics *previous, long int milliseconds, unsigned int depotCount) {
+  unsigned long allocations = current->allocations - previous->allocations;
+  unsigned long rate = (milliseconds > 0)? ((allocations * MSECS_PER_SEC) / milliseconds): 0;
+
+  logMessage(LOG_CATEGORY(QUEUE_EVENTS),
+             "elements: %lu allocations (%lu/s), %u%% thread cache hits, %u%% depot hits, %lu malloced, %lu freed, %lu deposited, %u magazines in depot",
+             current->allocations, rate,
+             getPercentage(current->cacheHits - previous->cacheHits, allocations),
+             getPercentage(current->depotHits - previous->depotHits, allocations),
+             current->mallocs, current->frees, current->depotDeposits,
+             depotCount);
+}
+
+static void
+foldElementStatistics (ElementCache *cache) {
+  /* The depot lock must be held. */
+  ElementStatistics *from = &cache->statistics;
+  ElementStatistics *to = &elementDepot.statistics;
+
+  to->allocations += from->allocations;
+  to->cacheHits += from->cacheHits;
+  to->depotHits += from->depotHits;
+  to->depotDeposits += from->depotDeposits;
+  to->mallocs += from->mallocs;
+  to->frees += from->frees;
+
+  memset(from, 0, sizeof(*from));
+}
+
+static void
+lockElementCache (ElementCache *cache) {
+  lockElementDepot();
+  if (cache) foldElementStatistics(cache);
+}
+
+static void
+unlockElementCache (void) {
+  int report = 0;
+  ElementStatistics current;
+  ElementStatistics previous;
+  long int milliseconds;
+  unsigned int depotCount;
+
+  if (LOG_CATEGORY_FLAG(QUEUE_EVENTS)) {
+    const ElementStatistics *statistics = &elementDepot.statistics;
+    const ElementStatistics *reported = &elementDepot.reported;
+
+    if ((statistics->allocations - reported->allocations) >= ELEMENT_STATISTICS_INTERVAL) {
+      TimeValue now;
+      getMonotonicTime(&now);
+
+      current = *statistics;
+      previous = *reported;
+      milliseconds = millisecondsBetween(&elementDepot.reportTime, &now);
+      depotCount = elementDepot.count;
+
+      elementDepot.reported = current;
+      elementDepot.reportTime = now;
+      report = 1;
+    }
+  }
+
+  unlockElementDepot();
+  if (report) logElementStatistics(&current, &previous, milliseconds, depotCount);
+}
+
+static void
+depositElements (ElementCache *cache, ElementMagazine *magazine) {
+  Element *overflow = NULL;
+
+  if (magazine->count) {
+    lockElementCache(cache);
+      if (elementDepot.count < ELEMENT_DEPOT_SIZE) {
+        elementDepot.magazines[elementDepot.count++] = *magazine;
+        elementDepot.statistics.depotDeposits += 1;
+      } else {
+        overflow = magazine->elements;
+        elementDepot.statistics.frees += magazine->count;
+      }
+    unlockElementCache();
+
+    magazine->elements = NULL;
+    magazine->count = 0;
+  }
+
+  freeElements(overflow);
+}
+
+static int
+withdrawElements (ElementCache *cache, ElementMagazine *magazine) {
+  int withdrawn = 0;
+
+  lockElementCache(cache);
+    if (elementDepot.count) {
+      *magazine = elementDepot.magazines[--elementDepot.count];
+      withdrawn = 1;
+    }
+  unlockElementCache();
+
+  return withdrawn;
+}
+
+static THREAD_SPECIFIC_DATA_NEW(tsdElementCache) {
+  ElementCache *cache;
+
+  if ((cache = malloc(sizeof(*cache)))) {
+    memset(cache, 0, sizeof(*cache));
+    cache->loaded.elements = NULL;
+    cache->previous.elements = NULL;
+    return cache;
+  } else {
+    logMallocError();
+  }
+
+  return NULL;
+}
+
+#ifdef THREAD_LOCAL
+static THREAD_LOCAL ElementCache *elementCache = NULL;
+#endif /* THREAD_LOCAL */
+
+static THREAD_SPECIFIC_DATA_DESTROY(tsdElementCache) {
+  ElementCache *cache = data;
+
+  if (cache) {
+#ifdef THREAD_LOCAL
+    if (cache == elementCache) elementCache = NULL;
+#endif /* THREAD_LOCAL */
+
+    depositElements(cache, &cache->previous);
+    depositElements(cache, &cache->loaded);
+
+    lockElementCache(cache);
+    unlockElementCache();
+
+    free(cache);
+  }
+}
+
+THREAD_SPECIFIC_DATA_CONTROL(tsdElementCache);
+
+static ElementCache *
+getElementCache (void) {
+#ifdef THREAD_LOCAL
+  if (!elementCache) elementCache = getThreadSpecificData(&tsdElementCache);
+  return elementCache;
+#else /* THREAD_LOCAL */
+  return getThreadSpecificData(&tsdElementCache);
+#endif /* THREAD_LOCAL */
+}
+
+static void
+pushElement (ElementMagazine *magazine, Element *element) {
+  element->next = magazine->elements;
+  magazine->elements = element;
+  magazine->count += 1;
+}
+
+static Element *
+popElement (ElementMagazine *magazine) {
+  Element *element = magazine->elements;
+
+  magazine->elements = element->next;
+  magazine->count -= 1;
+
+  element->next = NULL;
+  return element;
+}
+
+static void
+swapMagazines (ElementCache *cache) {
+  ElementMagazine magazine = cache->loaded;
+
+  cache->loaded = cache->previous;
+  cache->previous = magazine;
+}
+
 static void
 discardElement (Element *element) {
+  ElementCache *cache;
+
   removeItem(element);
   removeElement(element);
 
-  lockDiscardedElements();
-    element->next = discardedElements;
-    discardedElements = element;
-  unlockDiscardedElements();
+  if (!(cache = getElementCache())) {
+    free(element);
+    return;
+  }
+
+  if (cache->loaded.count == ELEMENT_MAGAZINE_SIZE) {
+    if (cache->previous.count) depositElements(cache, &cache->previous);
+    swapMagazines(cache);
+  }
+
+  pushElement(&cache->loaded, element);
 }
 
 static Element *
 retrieveElement (void) {
-  Element *element;
+  ElementCache *cache = getElementCache();
+  if (!cache) return NULL;
+
+  {
+    ElementStatistics *statistics = &cache->statistics;
 
-  lockDiscardedElements();
-    if ((element = discardedElements)) {
-      discardedElements = element->next;
-      element->next = NULL;
+    if (++statistics->allocations == ELEMENT_STATISTICS_FOLD) {
+      lockElementCache(cache);
+      unlockElementCache();
     }
-  unlockDiscardedElements();
 
-  return element;
+    if (!cache->loaded.count) {
+      if (cache->previous.count) {
+        swapMagazines(cache);
+      } else if (withdrawElements(cache, &cache->loaded)) {
+        statistics->depotHits += 1;
+        return popElement(&cache->loaded);
+      } else {
+        statistics->mallocs += 1;
+        return NULL;
+      }
+    }
+
+    statistics->cacheHits += 1;
+  }
+
+  return popElement(&cache->loaded);
 }
 
 static Element *
@@ -258,13 +520,36 @@ static int queueInitialized = 0;
 
 static void
 exitQueue (void *data) {
-  lockDiscardedElements();
-    while (discardedElements) {
-      Element *element = discardedElements;
-      discardedElements = element->next;
-      free(element);
+  ElementCache *cache = getElementCache();
+
+  if (cache) {
+    depositElements(cache, &cache->previous);
+    depositElements(cache, &cache->loaded);
+  }
+
+  {
+    ElementStatistics statistics;
+
+    lockElementCache(cache);
+      while (elementDepot.count) {
+        ElementMagazine *magazine = &elementDepot.magazines[--elementDepot.count];
+
+        freeElements(magazine->elements);
+        elementDepot.statistics.frees += magazine->count;
+      }
+
+      statistics = elementDepot.statistics;
+    unlockElementDepot();
+
+    if (LOG_CATEGORY_FLAG(QUEUE_EVENTS)) {
+      static const ElementStatistics none = { .allocations = 0 };
+      TimeValue now;
+
+      getMonotonicTime(&now);
+      logElementStatistics(&statistics, &none,
+                           millisecondsBetween(&elementDepot.startTime, &now), 0);
     }
-  unlockDiscardedElements();
+  }
 
   queueInitialized = 0;
 }
@@ -275,6 +560,8 @@ newQueue (ItemDeallocator *deallocateItem, ItemComparator *compareItems) {
 
   if (!queueInitialized) {
     queueInitialized = 1;
+    getMonotonicTime(&elementDepot.startTime);
+    elementDepot.reportTime = elementDepot.startTime;
     onProgramExit("queue", exitQueue, NULL);
   }
 
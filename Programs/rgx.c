@@ -18,6 +18,7 @@
 
 #include "prologue.h"
 
+#include <stdio.h>
 #include <string.h>
 
 #include "log.h"
@@ -49,12 +50,26 @@ struct RGX_ObjectStruct {
   void *data;
   Queue *matchers;
   RGX_OptionsType options;
+
+  struct {
+    RGX_CodeType *code;
+    RGX_DataType *data;
+
+    RGX_Matcher **matchers;
+    size_t *numbers;
+    size_t count;
+
+    unsigned isEnabled:1;
+    unsigned isStale:1;
+    unsigned isOrdered:1;
+  } combined;
 };
 
 struct RGX_MatcherStruct {
   void *data;
   RGX_MatchHandler *handler;
   RGX_OptionsType options;
+  RGX_OptionsType compileOptions;
 
   struct {
     wchar_t *characters;
@@ -86,6 +101,8 @@ rgxLogError (int error, const RGX_Matcher *matcher, RGX_OffsetType *offset) {
     STR_PRINTF(
       ": %.*"PRIws, (int)matcher->pattern.length, matcher->pattern.characters
     );
+  } else {
+    STR_PRINTF(": combined pattern");
   }
 
   STR_END;
@@ -115,6 +132,7 @@ rgxAddPatternCharacters (
     matcher->data = data;
     matcher->handler = handler;
     matcher->options = 0;
+    matcher->compileOptions = rgx->options;
 
     matcher->pattern.characters = calloc(
       (matcher->pattern.length = length) + 1,
@@ -138,6 +156,7 @@ rgxAddPatternCharacters (
 
         if (matcher->compiled.data) {
           if (enqueueItem(rgx->matchers, matcher)) {
+            rgx->combined.isStale = 1;
             return matcher;
           }
 
@@ -210,6 +229,230 @@ rgxTestMatcher (const void *item, void *data) {
   return handler(match);
 }
 
+static void
+rgxDiscardCombinedPattern (RGX_Object *rgx) {
+  if (rgx->combined.data) {
+    rgxDeallocateData(rgx->combined.data);
+    rgx->combined.data = NULL;
+  }
+
+  if (rgx->combined.code) {
+    rgxDeallocateCode(rgx->combined.code);
+    rgx->combined.code = NULL;
+  }
+
+  if (rgx->combined.matchers) {
+    free(rgx->combined.matchers);
+    rgx->combined.matchers = NULL;
+  }
+
+  if (rgx->combined.numbers) {
+    free(rgx->combined.numbers);
+    rgx->combined.numbers = NULL;
+  }
+
+  rgx->combined.count = 0;
+}
+
+static int
+rgxCanCombinePattern (const RGX_Matcher *matcher) {
+  /* Numbered references would refer to the wrong groups once the pattern
+   * is wrapped within an alternation.
+   */
+  const wchar_t *character = matcher->pattern.characters;
+  const wchar_t *end = character + matcher->pattern.length;
+
+  if (matcher->handler) return 0;
+  if (matcher->options) return 0;
+
+  while (character < end) {
+    if (*character == WC_C('\\')) {
+      if (++character == end) break;
+      if (*character == WC_C('g')) return 0;
+      if ((*character >= WC_C('1')) && (*character <= WC_C('9'))) return 0;
+    } else if ((*character == WC_C('(')) && ((end - character) > 2)) {
+      if (character[1] == WC_C('?')) {
+        const wchar_t *next = &character[2];
+
+        if (*next == WC_C('R')) return 0;
+        if ((*next == WC_C('+')) || (*next == WC_C('-'))) next += 1;
+        if ((next < end) && (*next >= WC_C('0')) && (*next <= WC_C('9'))) return 0;
+      }
+    }
+
+    character += 1;
+  }
+
+  return 1;
+}
+
+static int
+rgxAddCombinedMatcher (void *item, void *data) {
+  RGX_Matcher *matcher = item;
+  RGX_Object *rgx = data;
+
+  rgx->combined.matchers[rgx->combined.count++] = matcher;
+  return 0;
+}
+
+#define RGX_ALTERNATIVE_NAME "rgxAlternative%u"
+
+static int
+rgxMakeCombinedPattern (RGX_Object *rgx) {
+  rgxDiscardCombinedPattern(rgx);
+  rgx->combined.isStale = 0;
+
+  size_t count = getQueueSize(rgx->matchers);
+  if (count < 2) return 0;
+
+  if (!(rgx->combined.matchers = malloc(ARRAY_SIZE(rgx->combined.matchers, count)))) {
+    logMallocError();
+    return 0;
+  }
+
+  processQueue(rgx->matchers, rgxAddCombinedMatcher, rgx);
+
+  size_t size = 0;
+  RGX_OptionsType options = rgx->combined.matchers[0]->compileOptions;
+
+  for (size_t index=0; index<count; index+=1) {
+    const RGX_Matcher *matcher = rgx->combined.matchers[index];
+
+    if (matcher->compileOptions != options) goto cantCombine;
+    if (!rgxCanCombinePattern(matcher)) goto cantCombine;
+
+    size += matcher->pattern.length + 0X20;
+  }
+
+  {
+    wchar_t characters[size];
+    size_t length;
+
+    {
+      wchar_t *to = characters;
+
+      for (size_t index=0; index<count; index+=1) {
+        const RGX_Matcher *matcher = rgx->combined.matchers[index];
+
+        {
+          char prefix[0X20];
+          int prefixLength = snprintf(
+            prefix, sizeof(prefix), "%s(?<" RGX_ALTERNATIVE_NAME ">",
+            (index? "|": ""), (unsigned int)index
+          );
+
+          for (int i=0; i<prefixLength; i+=1) *to++ = prefix[i];
+        }
+
+        wmemcpy(to, matcher->pattern.characters, matcher->pattern.length);
+        to += matcher->pattern.length;
+        *to++ = WC_C(')');
+      }
+
+      length = to - characters;
+    }
+
+    {
+      RGX_CHARACTERS_TO_INTERNAL;
+      int error;
+      RGX_OffsetType offset;
+
+      rgx->combined.code = rgxCompilePattern(internal, length, options, &offset, &error);
+    }
+
+    if (!rgx->combined.code) goto cantCombine;
+  }
+
+  if (!(rgx->combined.data = rgxAllocateData(rgx->combined.code))) {
+    logMallocError();
+    goto cantCombine;
+  }
+
+  if (!(rgx->combined.numbers = malloc(ARRAY_SIZE(rgx->combined.numbers, count)))) {
+    logMallocError();
+    goto cantCombine;
+  }
+
+  for (size_t index=0; index<count; index+=1) {
+    char name[0X20];
+    size_t length = snprintf(name, sizeof(name), RGX_ALTERNATIVE_NAME, (unsigned int)index);
+    RGX_CharacterType internal[length + 1];
+
+    for (size_t i=0; i<=length; i+=1) internal[i] = name[i];
+
+    int error;
+    if (!rgxNameNumber(rgx->combined.code, internal, &rgx->combined.numbers[index], &error)) {
+      goto cantCombine;
+    }
+  }
+
+  {
+    const RGX_OptionMap *map = &rgxCompileOptionsMap;
+    RGX_OptionsType anchored = (RGX_COMPILE_ANCHOR_START < map->count)?
+                               map->array[RGX_COMPILE_ANCHOR_START]: 0;
+
+    /* When every alternative is anchored at the start of the text, the
+     * first one which matches is the first pattern which matches.
+     */
+    rgx->combined.isOrdered = anchored && (options & anchored);
+  }
+
+  logMessage(LOG_DEBUG, "regular expressions combined: %zu", count);
+  return 1;
+
+cantCombine:
+  rgxDiscardCombinedPattern(rgx);
+  return 0;
+}
+
+static int rgxTestMatcher (const void *item, void *data);
+
+static int
+rgxMatchCombinedPattern (RGX_Object *rgx, RGX_Match *match, RGX_Matcher **matcher) {
+  if (!rgx->combined.isEnabled) return 0;
+  if (rgx->combined.isStale) rgxMakeCombinedPattern(rgx);
+  if (!rgx->combined.code) return 0;
+
+  size_t count;
+  int error;
+
+  int matched = rgxMatchText(
+    match->text.internal, match->text.length,
+    rgx->combined.code, rgx->combined.data,
+    0, &count, &error
+  );
+
+  *matcher = NULL;
+
+  if (!matched) {
+    if (error == RGX_NO_MATCH) return 1;
+    rgxLogError(error, NULL, NULL);
+    return 0;
+  }
+
+  size_t index = 0;
+
+  if (rgx->combined.isOrdered) {
+    while (index < rgx->combined.count) {
+      size_t from, to;
+      if (rgxCaptureBounds(rgx->combined.data, rgx->combined.numbers[index], &from, &to)) break;
+      index += 1;
+    }
+  }
+
+  /* Rematch with the pattern's own code so that its captures are available. */
+  while (index < rgx->combined.count) {
+    RGX_Matcher *candidate = rgx->combined.matchers[index++];
+
+    if (rgxTestMatcher(candidate, match)) {
+      *matcher = candidate;
+      break;
+    }
+  }
+
+  return 1;
+}
+
 RGX_Matcher *
 rgxMatchTextCharacters (
   RGX_Object *rgx,
@@ -231,8 +474,14 @@ rgxMatchTextCharacters (
     }
   };
 
-  Element *element = findElement(rgx->matchers, rgxTestMatcher, &match);
-  if (!element) return NULL;
+  RGX_Matcher *matcher;
+
+  if (!rgxMatchCombinedPattern(rgx, &match, &matcher)) {
+    Element *element = findElement(rgx->matchers, rgxTestMatcher, &match);
+    matcher = element? getElementItem(element): NULL;
+  }
+
+  if (!matcher) return NULL;
 
   if (result) {
     typedef struct {
@@ -259,7 +508,7 @@ rgxMatchTextCharacters (
     *result = &block->match;
   }
 
-  return getElementItem(element);
+  return matcher;
 }
 
 RGX_Matcher *
@@ -367,6 +616,7 @@ rgxNewObject (void *data) {
 
 void
 rgxDestroyObject (RGX_Object *rgx) {
+  rgxDiscardCombinedPattern(rgx);
   deallocateQueue(rgx->matchers);
   free(rgx);
 }
@@ -419,3 +669,35 @@ rgxMatchOption (
 ) {
   return rgxOption(action, option, &matcher->options, &rgxMatchOptionsMap);
 }
+
+int
+rgxCombinePatterns (
+  RGX_Object *rgx,
+  RGX_OptionAction action
+) {
+  int wasSet = rgx->combined.isEnabled;
+
+  if (action == RGX_OPTION_TOGGLE) {
+    action = wasSet? RGX_OPTION_CLEAR: RGX_OPTION_SET;
+  }
+
+  switch (action) {
+    case RGX_OPTION_SET:
+      rgx->combined.isEnabled = 1;
+      rgx->combined.isStale = 1;
+      break;
+
+    case RGX_OPTION_CLEAR:
+      rgx->combined.isEnabled = 0;
+      rgxDiscardCombinedPattern(rgx);
+      break;
+
+    default:
+      logMessage(LOG_WARNING, "unimplemented regular expression option action: %d", action);
+      /* fall through */
+    case RGX_OPTION_TEST:
+      break;
+  }
+
+  return wasSet;
+}
@@ -28,9 +28,16 @@ rgxCompilePattern (
   RGX_OptionsType options, RGX_OffsetType *offset,
   int *error
 ) {
-  return pcre2_compile(
+  RGX_CodeType *code = pcre2_compile(
     characters, length, options, error, offset, NULL
   );
+
+  if (code) {
+    /* The interpreter is used if JIT compilation isn't available. */
+    pcre2_jit_compile(code, PCRE2_JIT_COMPLETE);
+  }
+
+  return code;
 }
 
 void
@@ -69,6 +69,15 @@ rgxAllocateData (RGX_CodeType *code) {
   size_t size = sizeof(*data);
 
   size_t matches = 10;
+
+  {
+    int captures;
+
+    if (pcre32_fullinfo(code, NULL, PCRE_INFO_CAPTURECOUNT, &captures) == 0) {
+      if ((size_t)captures >= matches) matches = captures + 1;
+    }
+  }
+
   size_t count = matches * 3;
   size += count * sizeof(data->offsets[0]);
 
@@ -80,7 +89,13 @@ rgxAllocateData (RGX_CodeType *code) {
 
   {
     const char *message = NULL;
-    data->study = pcre32_study(code, 0, &message);
+    int options = 0;
+
+#ifdef PCRE_STUDY_JIT_COMPILE
+    options |= PCRE_STUDY_JIT_COMPILE;
+#endif /* PCRE_STUDY_JIT_COMPILE */
+
+    data->study = pcre32_study(code, options, &message);
 
     if (message) {
       logMessage(LOG_WARNING, "pcre study error: %s", message);
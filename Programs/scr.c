@@ -31,6 +31,7 @@
 #include "unicode.h"
 #include "scr.h"
 #include "scr_real.h"
+#include "scr_snapshot.h"
 #include "driver.h"
 
 MainScreen mainScreen;
@@ -96,6 +97,7 @@ pollScreen (void) {
 
 int
 refreshScreen (void) {
+  invalidateScreenSnapshot();
   return currentScreen->refresh();
 }
 
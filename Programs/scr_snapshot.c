@@ -0,0 +1,219 @@
+/*
+ * BRLTTY - A background process providing access to the console screen (when in
+ *          text mode) for a blind person using a refreshable braille display.
+ *
+ * Copyright (C) 1995-2021 by The BRLTTY Developers.
+ *
+ * BRLTTY comes with ABSOLUTELY NO WARRANTY.
+ *
+ * This is free software, placed under the terms of the
+ * GNU Lesser General Public License, as published by the Free Software
+ * Foundation; either version 2.1 of the License, or (at your option) any
+ * later version. Please see the file LICENSE-LGPL for details.
+ *
+ * Web Page: http://brltty.app/
+ *
+ * This software is maintained by Dave Mielke <dave@mielke.cc>.
+ */
+
+#include "prologue.h"
+
+#include <string.h>
+#include <wctype.h>
+
+#include "log.h"
+#include "program.h"
+#include "scr.h"
+#include "scr_utils.h"
+#include "scr_snapshot.h"
+
+static struct {
+  ScreenCharacter *characters;
+  ScreenRowHash *hashes;
+  wchar_t *foldedText;
+  size_t size;
+
+  int columns;
+  int rows;
+
+  unsigned isValid:1;
+  unsigned hasFoldedText:1;
+  unsigned exitRegistered:1;
+} snapshot;
+
+#define SNAPSHOT_HASH_BASIS UINT32_C(0X811C9DC5)
+#define SNAPSHOT_HASH_PRIME UINT32_C(0X01000193)
+
+static void
+hashScreenRow (ScreenRowHash *hash, const ScreenCharacter *character, int count) {
+  uint32_t text = SNAPSHOT_HASH_BASIS;
+  uint32_t attributes = SNAPSHOT_HASH_BASIS;
+  const ScreenCharacter *end = character + count;
+
+  while (character < end) {
+    text ^= character->text;
+    text *= SNAPSHOT_HASH_PRIME;
+
+    attributes ^= character->attributes;
+    attributes *= SNAPSHOT_HASH_PRIME;
+
+    character += 1;
+  }
+
+  hash->text = text;
+  hash->attributes = attributes;
+}
+
+static void
+deallocateScreenSnapshot (void) {
+  if (snapshot.characters) {
+    free(snapshot.characters);
+    snapshot.characters = NULL;
+  }
+
+  if (snapshot.hashes) {
+    free(snapshot.hashes);
+    snapshot.hashes = NULL;
+  }
+
+  if (snapshot.foldedText) {
+    free(snapshot.foldedText);
+    snapshot.foldedText = NULL;
+  }
+
+  snapshot.size = 0;
+  snapshot.isValid = 0;
+}
+
+static void
+exitScreenSnapshot (void *data) {
+  deallocateScreenSnapshot();
+  snapshot.exitRegistered = 0;
+}
+
+static int
+allocateScreenSnapshot (int columns, int rows) {
+  size_t size = columns * rows;
+
+  if (size > snapshot.size) {
+    ScreenCharacter *characters = malloc(ARRAY_SIZE(characters, size));
+
+    if (!characters) {
+      logMallocError();
+      return 0;
+    }
+
+    deallocateScreenSnapshot();
+    snapshot.characters = characters;
+    snapshot.size = size;
+
+    if (!snapshot.exitRegistered) {
+      onProgramExit("screen-snapshot", exitScreenSnapshot, NULL);
+      snapshot.exitRegistered = 1;
+    }
+  }
+
+  if (!snapshot.hashes || (rows > snapshot.rows)) {
+    ScreenRowHash *hashes = realloc(snapshot.hashes, ARRAY_SIZE(hashes, rows));
+
+    if (!hashes) {
+      logMallocError();
+      return 0;
+    }
+
+    snapshot.hashes = hashes;
+  }
+
+  snapshot.columns = columns;
+  snapshot.rows = rows;
+  return 1;
+}
+
+static int
+captureScreenSnapshot (void) {
+  if (!snapshot.isValid) {
+    ScreenDescription description;
+    describeScreen(&description);
+
+    if (description.unreadable) return 0;
+    if ((description.cols <= 0) || (description.rows <= 0)) return 0;
+    if (!allocateScreenSnapshot(description.cols, description.rows)) return 0;
+
+    if (!readScreen(0, 0, snapshot.columns, snapshot.rows, snapshot.characters)) {
+      clearScreenCharacters(snapshot.characters, (snapshot.columns * snapshot.rows));
+    }
+
+    for (int row=0; row<snapshot.rows; row+=1) {
+      hashScreenRow(&snapshot.hashes[row],
+                    &snapshot.characters[row * snapshot.columns],
+                    snapshot.columns);
+    }
+
+    snapshot.hasFoldedText = 0;
+    snapshot.isValid = 1;
+  }
+
+  return 1;
+}
+
+void
+invalidateScreenSnapshot (void) {
+  snapshot.isValid = 0;
+}
+
+static int
+isWithinScreenSnapshot (int row, int width) {
+  if (!captureScreenSnapshot()) return 0;
+  if ((row < 0) || (row >= snapshot.rows)) return 0;
+  if ((width < 0) || (width > snapshot.columns)) return 0;
+  return 1;
+}
+
+const ScreenCharacter *
+getScreenSnapshotRow (int row, int width) {
+  if (!isWithinScreenSnapshot(row, width)) return NULL;
+  return &snapshot.characters[row * snapshot.columns];
+}
+
+const ScreenRowHash *
+getScreenSnapshotRowHash (int row, int width) {
+  if (!isWithinScreenSnapshot(row, width)) return NULL;
+  if (width != snapshot.columns) return NULL;
+  return &snapshot.hashes[row];
+}
+
+const wchar_t *
+getScreenSnapshotFoldedText (int width, int rows) {
+  if (!isWithinScreenSnapshot((rows - 1), width)) return NULL;
+  if (width != snapshot.columns) return NULL;
+
+  if (!snapshot.hasFoldedText) {
+    if (!snapshot.foldedText) {
+      if (!(snapshot.foldedText = malloc(ARRAY_SIZE(snapshot.foldedText, snapshot.size)))) {
+        logMallocError();
+        return NULL;
+      }
+    }
+
+    {
+      const ScreenCharacter *from = snapshot.characters;
+      const ScreenCharacter *end = from + (snapshot.columns * snapshot.rows);
+      wchar_t *to = snapshot.foldedText;
+
+      while (from < end) *to++ = towlower(from++->text);
+    }
+
+    snapshot.hasFoldedText = 1;
+  }
+
+  return snapshot.foldedText;
+}
+
+const ScreenCharacter *
+getScreenRow (int row, int width, ScreenCharacter *buffer) {
+  const ScreenCharacter *characters = getScreenSnapshotRow(row, width);
+  if (characters) return characters;
+
+  readScreenRow(row, width, buffer);
+  return buffer;
+}
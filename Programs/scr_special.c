@@ -28,6 +28,7 @@
 #include "log.h"
 #include "scr.h"
 #include "scr_special.h"
+#include "scr_snapshot.h"
 #include "update.h"
 #include "message.h"
 
@@ -163,6 +164,7 @@ setCurrentScreen (BaseScreen *screen) {
     currentScreen->onBackground();
     currentScreen = screen;
     currentScreen->onForeground();
+    invalidateScreenSnapshot();
 
     scheduleUpdate("new screen selected");
     announceCurrentScreen();
@@ -350,6 +350,79 @@ serialFlushAttributes (SerialDevice *serial) {
   return 1;
 }
 
+#define SERIAL_ROUND_TRIP_LIMIT (USECS_PER_SEC / 10)
+
+static void
+serialAddRoundTrip (SerialRoundTrip *roundTrip, const TimeValue *from, const TimeValue *to) {
+  long int microseconds = ((to->seconds - from->seconds) * USECS_PER_SEC)
+                        + ((to->nanoseconds - from->nanoseconds) / NSECS_PER_USEC);
+
+  /* a longer gap means that the other side wasn't responding */
+  if (microseconds < SERIAL_ROUND_TRIP_LIMIT) {
+    roundTrip->count += 1;
+    roundTrip->total += microseconds;
+    if (microseconds > roundTrip->maximum) roundTrip->maximum = microseconds;
+  }
+}
+
+static void
+serialNoteInput (SerialDevice *serial) {
+  if (serial->lowLatency) {
+    TimeValue now;
+    getMonotonicTime(&now);
+
+    if (serial->roundTrips.outputPending) {
+      serialAddRoundTrip(&serial->roundTrips.refresh, &serial->roundTrips.outputTime, &now);
+      serial->roundTrips.outputPending = 0;
+    }
+
+    if (!serial->roundTrips.inputPending) {
+      serial->roundTrips.inputTime = now;
+      serial->roundTrips.inputPending = 1;
+    }
+  }
+}
+
+static void
+serialNoteOutput (SerialDevice *serial) {
+  if (serial->lowLatency) {
+    TimeValue now;
+    getMonotonicTime(&now);
+
+    if (serial->roundTrips.inputPending) {
+      serialAddRoundTrip(&serial->roundTrips.key, &serial->roundTrips.inputTime, &now);
+      serial->roundTrips.inputPending = 0;
+    }
+
+    if (!serial->roundTrips.outputPending) {
+      serial->roundTrips.outputTime = now;
+      serial->roundTrips.outputPending = 1;
+    }
+  }
+}
+
+static void
+serialLogRoundTrip (SerialDevice *serial, const char *name, const SerialRoundTrip *roundTrip) {
+  if (roundTrip->count) {
+    logMessage(LOG_INFO,
+               "serial %s round trip: %s: %.3fms mean, %.3fms maximum (%lu samples)",
+               name, serial->devicePath,
+               (double)roundTrip->total / roundTrip->count / USECS_PER_MSEC,
+               (double)roundTrip->maximum / USECS_PER_MSEC,
+               roundTrip->count);
+  }
+}
+
+ssize_t
+serialGetPendingOutput (SerialDevice *serial) {
+  if (!serial->lowLatency) {
+    errno = ENOSYS;
+    return -1;
+  }
+
+  return serialGetOutputCount(serial);
+}
+
 int
 serialAwaitInput (SerialDevice *serial, int timeout) {
   if (!serialFlushAttributes(serial)) return 0;
@@ -370,6 +443,7 @@ serialReadData (
 
     if (result > 0) {
       logBytes(LOG_CATEGORY(SERIAL_IO), "input", buffer, result);
+      serialNoteInput(serial);
     }
 
     return result;
@@ -410,6 +484,7 @@ serialReadChunk (
 
   if (byte > first) {
     logBytes(LOG_CATEGORY(SERIAL_IO), "input", first, (byte - first));
+    serialNoteInput(serial);
   }
 
   return 1;
@@ -422,7 +497,13 @@ serialWriteData (
 ) {
   if (!serialFlushAttributes(serial)) return -1;
   if (size > 0) logBytes(LOG_CATEGORY(SERIAL_IO), "output", data, size);
-  return serialPutData(serial, data, size);
+
+  {
+    ssize_t result = serialPutData(serial, data, size);
+
+    if (result > 0) serialNoteOutput(serial);
+    return result;
+  }
 }
 
 static int
@@ -674,13 +755,37 @@ serialConfigureFlowControl (SerialDevice *serial, const char *string) {
   return 1;
 }
 
+static int
+serialConfigureLowLatency (SerialDevice *serial, const char *string) {
+  if (string && *string) {
+    unsigned int flag;
+
+    if (!validateYesNo(&flag, string)) {
+      logMessage(LOG_WARNING, "invalid serial low latency setting: %s", string);
+      return 0;
+    }
+
+    if (flag) {
+      if (!serialPutLowLatency(serial, 1)) {
+        logMessage(LOG_WARNING, "serial low latency not supported: %s", serial->devicePath);
+      }
+
+      /* output pacing and round trip measurement don't depend on the driver */
+      serial->lowLatency = 1;
+    }
+  }
+
+  return 1;
+}
+
 typedef enum {
   SERIAL_DEV_NAME,
   SERIAL_DEV_BAUD,
   SERIAL_DEV_DATA_BITS,
   SERIAL_DEV_STOP_BITS,
   SERIAL_DEV_PARITY,
-  SERIAL_DEV_FLOW_CONTROL
+  SERIAL_DEV_FLOW_CONTROL,
+  SERIAL_DEV_LOW_LATENCY
 } SerialDeviceParameter;
 
 static const char *const serialDeviceParameters[] = {
@@ -690,6 +795,7 @@ static const char *const serialDeviceParameters[] = {
   "stopBits",
   "parity",
   "flowControl",
+  "lowLatency",
   NULL
 };
 
@@ -727,6 +833,7 @@ serialOpenDevice (const char *identifier) {
           if (!serialConfigureStopBits(serial, parameters[SERIAL_DEV_STOP_BITS])) ok = 0;
           if (!serialConfigureParity(serial, parameters[SERIAL_DEV_PARITY])) ok = 0;
           if (!serialConfigureFlowControl(serial, parameters[SERIAL_DEV_FLOW_CONTROL])) ok = 0;
+          if (!serialConfigureLowLatency(serial, parameters[SERIAL_DEV_LOW_LATENCY])) ok = 0;
 
           deallocateStrings(parameters);
           if (ok) return serial;
@@ -755,6 +862,12 @@ serialCloseDevice (SerialDevice *serial) {
   serialStopFlowControlThread(serial);
 #endif /* HAVE_POSIX_THREADS */
 
+  if (serial->lowLatency) {
+    serialLogRoundTrip(serial, "key", &serial->roundTrips.key);
+    serialLogRoundTrip(serial, "refresh", &serial->roundTrips.refresh);
+    serialPutLowLatency(serial, 0);
+  }
+
   serialWriteAttributes(serial, &serial->originalAttributes);
 
   if (serial->stream) {
@@ -25,6 +25,7 @@
 
 #include "io_serial.h"
 #include "thread.h"
+#include "timing.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -32,6 +33,12 @@ extern "C" {
 
 typedef void SerialFlowControlProc (SerialDevice *serial);
 
+typedef struct {
+  unsigned long count;
+  long int total; /* microseconds */
+  long int maximum; /* microseconds */
+} SerialRoundTrip;
+
 struct SerialDeviceStruct {
   char *devicePath;
   int fileDescriptor;
@@ -52,6 +59,18 @@ struct SerialDeviceStruct {
   unsigned flowControlStop:1;
 #endif /* HAVE_POSIX_THREADS */
 
+  unsigned lowLatency:1;
+
+  struct {
+    TimeValue inputTime;
+    TimeValue outputTime;
+    unsigned inputPending:1;
+    unsigned outputPending:1;
+
+    SerialRoundTrip key; /* from input to the next output */
+    SerialRoundTrip refresh; /* from output to the next input */
+  } roundTrips;
+
   SerialPackageFields package;
 };
 
@@ -86,6 +105,9 @@ extern int serialCancelOutput (SerialDevice *serial);
 
 extern int serialPollInput (SerialDevice *serial, int timeout);
 extern int serialDrainOutput (SerialDevice *serial);
+extern ssize_t serialGetOutputCount (SerialDevice *serial);
+
+extern int serialPutLowLatency (SerialDevice *serial, int enabled);
 
 extern ssize_t serialGetData (
   SerialDevice *serial,
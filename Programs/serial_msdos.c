@@ -290,6 +290,18 @@ serialDrainOutput (SerialDevice *serial) {
   return 1;
 }
 
+ssize_t
+serialGetOutputCount (SerialDevice *serial) {
+  errno = ENOSYS;
+  return -1;
+}
+
+int
+serialPutLowLatency (SerialDevice *serial, int enabled) {
+  errno = ENOSYS;
+  return 0;
+}
+
 ssize_t
 serialGetData (
   SerialDevice *serial,
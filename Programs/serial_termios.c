@@ -20,11 +20,17 @@
 
 #include <string.h>
 #include <errno.h>
+#include <limits.h>
 #include <sys/stat.h>
 #include <fcntl.h>
 
+#ifdef HAVE_LINUX_SERIAL_H
+#include <linux/serial.h>
+#endif /* HAVE_LINUX_SERIAL_H */
+
 #include "log.h"
 #include "io_misc.h"
+#include "file.h"
 
 #include "serial_termios.h"
 #include "serial_internal.h"
@@ -437,6 +443,140 @@ serialDrainOutput (SerialDevice *serial) {
   return 0;
 }
 
+ssize_t
+serialGetOutputCount (SerialDevice *serial) {
+#ifdef TIOCOUTQ
+  if (!serial->package.outputCountUnsupported) {
+    int count;
+
+    if (ioctl(serial->fileDescriptor, TIOCOUTQ, &count) != -1) return count;
+
+    /* it won't start working later, so only log it once */
+    logSystemError("TIOCOUTQ");
+    serial->package.outputCountUnsupported = 1;
+  }
+
+  errno = ENOSYS;
+#else /* TIOCOUTQ */
+  errno = ENOSYS;
+#endif /* TIOCOUTQ */
+
+  return -1;
+}
+
+static int
+serialPutLowLatencyFlag (SerialDevice *serial, int enabled) {
+#if defined(TIOCGSERIAL) && defined(TIOCSSERIAL) && defined(ASYNC_LOW_LATENCY)
+  struct serial_struct settings;
+
+  if (ioctl(serial->fileDescriptor, TIOCGSERIAL, &settings) != -1) {
+    if (enabled) {
+      if (settings.flags & ASYNC_LOW_LATENCY) return 1;
+      settings.flags |= ASYNC_LOW_LATENCY;
+    } else {
+      if (!serial->package.lowLatencyFlagSet) return 1;
+      settings.flags &= ~ASYNC_LOW_LATENCY;
+    }
+
+    if (ioctl(serial->fileDescriptor, TIOCSSERIAL, &settings) != -1) {
+      serial->package.lowLatencyFlagSet = enabled;
+      return 1;
+    }
+
+    logSystemError("TIOCSSERIAL");
+  } else {
+    logMessage(LOG_CATEGORY(SERIAL_IO), "low latency flag not supported: %s", strerror(errno));
+  }
+#endif /* ASYNC_LOW_LATENCY */
+
+  return 0;
+}
+
+#define SERIAL_LATENCY_TIMER_MINIMUM 1
+
+static int
+serialMakeLatencyTimerPath (SerialDevice *serial, char *buffer, size_t size) {
+  const char *device = serial->devicePath;
+
+#if defined(HAVE_REALPATH) && defined(PATH_MAX)
+  /* the sysfs entry is named after the device node, not after a symbolic
+   * link to it (like those under /dev/serial/by-id/)
+   */
+  char resolved[PATH_MAX];
+
+  if (realpath(device, resolved)) {
+    device = resolved;
+  } else {
+    logSystemError("realpath");
+  }
+#endif /* defined(HAVE_REALPATH) && defined(PATH_MAX) */
+
+  {
+    int length = snprintf(buffer, size, "/sys/class/tty/%s/device/latency_timer",
+                          locatePathName(device));
+
+    return (length > 0) && (length < size);
+  }
+}
+
+static int
+serialPutLatencyTimer (SerialDevice *serial, int enabled) {
+  char path[0X100];
+  FILE *stream;
+
+  if (!serialMakeLatencyTimerPath(serial, path, sizeof(path))) return 0;
+  if (!enabled && (serial->package.originalLatencyTimer == -1)) return 1;
+
+  if ((stream = fopen(path, "r+"))) {
+    int ok = 0;
+    int milliseconds;
+
+    if (fscanf(stream, "%d", &milliseconds) == 1) {
+      int newValue;
+
+      if (enabled) {
+        newValue = SERIAL_LATENCY_TIMER_MINIMUM;
+        if (milliseconds != newValue) serial->package.originalLatencyTimer = milliseconds;
+      } else {
+        newValue = serial->package.originalLatencyTimer;
+        serial->package.originalLatencyTimer = -1;
+      }
+
+      if (milliseconds == newValue) {
+        ok = 1;
+      } else {
+        rewind(stream);
+
+        if ((fprintf(stream, "%d\n", newValue) > 0) && (fflush(stream) != EOF)) {
+          logMessage(LOG_CATEGORY(SERIAL_IO), "latency timer set: %d -> %dms",
+                     milliseconds, newValue);
+          ok = 1;
+        } else {
+          logSystemError("latency timer write");
+        }
+      }
+    }
+
+    fclose(stream);
+    return ok;
+  } else if (errno != ENOENT) {
+    logMessage(LOG_CATEGORY(SERIAL_IO), "latency timer not accessible: %s: %s",
+               path, strerror(errno));
+  }
+
+  return 0;
+}
+
+int
+serialPutLowLatency (SerialDevice *serial, int enabled) {
+  int ok = 0;
+
+  if (serialPutLowLatencyFlag(serial, enabled)) ok = 1;
+  if (serialPutLatencyTimer(serial, enabled)) ok = 1;
+
+  return ok;
+}
+
 ssize_t
 serialGetData (
   SerialDevice *serial,
@@ -511,6 +651,9 @@ serialMonitorWaitLines (SerialDevice *serial) {
 int
 serialConnectDevice (SerialDevice *serial, const char *device) {
   serial->package.inputMonitor = NULL;
+  serial->package.originalLatencyTimer = -1;
+  serial->package.lowLatencyFlagSet = 0;
+  serial->package.outputCountUnsupported = 0;
 
   if ((serial->fileDescriptor = open(device, O_RDWR|O_NOCTTY|O_NONBLOCK)) != -1) {
     if (isatty(serial->fileDescriptor)) {
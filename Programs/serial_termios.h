@@ -45,6 +45,10 @@ typedef int SerialLines;
 
 typedef struct {
   AsyncHandle inputMonitor;
+
+  int originalLatencyTimer;
+  unsigned lowLatencyFlagSet:1;
+  unsigned outputCountUnsupported:1;
 } SerialPackageFields;
 
 #ifdef __cplusplus
@@ -307,6 +307,22 @@ serialDrainOutput (SerialDevice *serial) {
   return 0;
 }
 
+ssize_t
+serialGetOutputCount (SerialDevice *serial) {
+  DWORD errors;
+  COMSTAT status;
+
+  if (ClearCommError(serial->package.fileHandle, &errors, &status)) return status.cbOutQue;
+  logWindowsSystemError("ClearCommError");
+  return -1;
+}
+
+int
+serialPutLowLatency (SerialDevice *serial, int enabled) {
+  errno = ENOSYS;
+  return 0;
+}
+
 ssize_t
 serialGetData (
   SerialDevice *serial,
@@ -0,0 +1,314 @@
+/*
+ * BRLTTY - A background process providing access to the console screen (when in
+ *          text mode) for a blind person using a refreshable braille display.
+ *
+ * Copyright (C) 1995-2021 by The BRLTTY Developers.
+ *
+ * BRLTTY comes with ABSOLUTELY NO WARRANTY.
+ *
+ * This is free software, placed under the terms of the
+ * GNU Lesser General Public License, as published by the Free Software
+ * Foundation; either version 2.1 of the License, or (at your option) any
+ * later version. Please see the file LICENSE-LGPL for details.
+ *
+ * Web Page: http://brltty.app/
+ *
+ * This software is maintained by Dave Mielke <dave@mielke.cc>.
+ */
+
+#include "prologue.h"
+
+#include <string.h>
+
+#include "log.h"
+#include "parameters.h"
+#include "startup.h"
+#include "timing.h"
+#include "queue.h"
+#include "report.h"
+#include "async_alarm.h"
+#include "program.h"
+
+#define STARTUP_PHASE_LIMIT 0X40
+#define STARTUP_PHASE_DEPTH 8
+
+typedef struct {
+  const char *name;
+  long int begin;
+  long int duration;
+  unsigned char depth;
+} StartupPhase;
+
+typedef struct {
+  const char *name;
+  StartupTask *task;
+  void *data;
+} DeferredStartupTask;
+
+static struct {
+  TimeValue begin;
+  long int firstWindow;
+
+  unsigned isDeferring:1;
+  unsigned isReported:1;
+
+  struct {
+    StartupPhase table[STARTUP_PHASE_LIMIT];
+    unsigned int count;
+
+    int stack[STARTUP_PHASE_DEPTH];
+    unsigned int depth;
+  } phases;
+
+  ReportListenerInstance *windowListener;
+  AsyncHandle timeoutAlarm;
+  AsyncHandle completionAlarm;
+  AsyncHandle taskAlarm;
+  Queue *tasks;
+} startup;
+
+static long int
+getStartupElapsed (void) {
+  TimeValue now;
+  getMonotonicTime(&now);
+
+  return ((now.seconds - startup.begin.seconds) * USECS_PER_SEC)
+       + ((now.nanoseconds - startup.begin.nanoseconds) / NSECS_PER_USEC);
+}
+
+#define STARTUP_MSECS_FORMAT "%ld.%03ld"
+#define STARTUP_MSECS_ARGUMENTS(usecs) ((usecs) / USECS_PER_MSEC), ((usecs) % USECS_PER_MSEC)
+
+void
+beginStartupPhase (const char *name) {
+  int index = -1;
+
+  if (!startup.isReported) {
+    if (startup.phases.count < ARRAY_COUNT(startup.phases.table)) {
+      StartupPhase *phase = &startup.phases.table[index = startup.phases.count++];
+
+      phase->name = name;
+      phase->begin = getStartupElapsed();
+      phase->duration = -1;
+      phase->depth = startup.phases.depth;
+    }
+  }
+
+  if (startup.phases.depth < ARRAY_COUNT(startup.phases.stack)) {
+    startup.phases.stack[startup.phases.depth] = index;
+  }
+
+  startup.phases.depth += 1;
+}
+
+void
+endStartupPhase (void) {
+  if (startup.phases.depth) {
+    startup.phases.depth -= 1;
+
+    if (startup.phases.depth < ARRAY_COUNT(startup.phases.stack)) {
+      int index = startup.phases.stack[startup.phases.depth];
+
+      if (index >= 0) {
+        if (!startup.isReported) {
+          StartupPhase *phase = &startup.phases.table[index];
+          phase->duration = getStartupElapsed() - phase->begin;
+        }
+      }
+    }
+  }
+}
+
+static void
+logStartupReport (const char *reason) {
+  long int elapsed = getStartupElapsed();
+  int category = LOG_CATEGORY(STARTUP_EVENTS);
+
+  logMessage(category,
+             "complete after " STARTUP_MSECS_FORMAT " ms: %s",
+             STARTUP_MSECS_ARGUMENTS(elapsed), reason);
+
+  if (startup.firstWindow >= 0) {
+    logMessage(category,
+               "first braille window at " STARTUP_MSECS_FORMAT " ms",
+               STARTUP_MSECS_ARGUMENTS(startup.firstWindow));
+  }
+
+  {
+    const StartupPhase *phase = startup.phases.table;
+    const StartupPhase *end = phase + startup.phases.count;
+
+    while (phase < end) {
+      int indent = (phase->depth + 1) * 2;
+
+      if (phase->duration < 0) {
+        logMessage(category,
+                   "%*s%s: incomplete (at " STARTUP_MSECS_FORMAT " ms)",
+                   indent, "", phase->name,
+                   STARTUP_MSECS_ARGUMENTS(phase->begin));
+      } else {
+        logMessage(category,
+                   "%*s%s: " STARTUP_MSECS_FORMAT " ms (at " STARTUP_MSECS_FORMAT " ms)",
+                   indent, "", phase->name,
+                   STARTUP_MSECS_ARGUMENTS(phase->duration),
+                   STARTUP_MSECS_ARGUMENTS(phase->begin));
+      }
+
+      phase += 1;
+    }
+  }
+
+  startup.isReported = 1;
+}
+
+static void
+cancelStartupAlarm (AsyncHandle *alarm) {
+  if (*alarm) {
+    asyncCancelRequest(*alarm);
+    *alarm = NULL;
+  }
+}
+
+static void
+stopStartupMonitoring (void) {
+  cancelStartupAlarm(&startup.timeoutAlarm);
+  cancelStartupAlarm(&startup.completionAlarm);
+
+  if (startup.windowListener) {
+    unregisterReportListener(startup.windowListener);
+    startup.windowListener = NULL;
+  }
+}
+
+ASYNC_ALARM_CALLBACK(handleStartupTaskAlarm) {
+  asyncDiscardHandle(startup.taskAlarm);
+  startup.taskAlarm = NULL;
+
+  if (startup.tasks) {
+    DeferredStartupTask *dst = dequeueItem(startup.tasks);
+
+    if (dst) {
+      long int begin = getStartupElapsed();
+      dst->task(dst->data);
+      long int duration = getStartupElapsed() - begin;
+
+      logMessage(LOG_CATEGORY(STARTUP_EVENTS),
+                 "deferred task finished: %s: " STARTUP_MSECS_FORMAT " ms",
+                 dst->name, STARTUP_MSECS_ARGUMENTS(duration));
+
+      free(dst);
+    }
+
+    if (getQueueSize(startup.tasks) > 0) {
+      asyncNewRelativeAlarm(&startup.taskAlarm, 0, handleStartupTaskAlarm, NULL);
+    }
+  }
+}
+
+void
+endStartup (const char *reason) {
+  if (startup.isDeferring) {
+    startup.isDeferring = 0;
+    stopStartupMonitoring();
+    logStartupReport(reason);
+
+    if (startup.tasks && (getQueueSize(startup.tasks) > 0)) {
+      asyncNewRelativeAlarm(&startup.taskAlarm, 0, handleStartupTaskAlarm, NULL);
+    }
+  }
+}
+
+int
+isStartupComplete (void) {
+  return !startup.isDeferring;
+}
+
+ASYNC_ALARM_CALLBACK(handleStartupCompletionAlarm) {
+  asyncDiscardHandle(startup.completionAlarm);
+  startup.completionAlarm = NULL;
+
+  endStartup("braille window written");
+}
+
+ASYNC_ALARM_CALLBACK(handleStartupTimeoutAlarm) {
+  asyncDiscardHandle(startup.timeoutAlarm);
+  startup.timeoutAlarm = NULL;
+
+  endStartup("timed out");
+}
+
+REPORT_LISTENER(handleBrailleWindowUpdated) {
+  if (startup.isDeferring && !startup.completionAlarm) {
+    startup.firstWindow = getStartupElapsed();
+
+    /* The listener can't be unregistered while reports are being delivered. */
+    asyncNewRelativeAlarm(&startup.completionAlarm, 0, handleStartupCompletionAlarm, NULL);
+  }
+}
+
+static void
+deallocateDeferredStartupTask (void *item, void *data) {
+  DeferredStartupTask *dst = item;
+
+  free(dst);
+}
+
+void
+deferStartupTask (const char *name, StartupTask *task, void *data) {
+  if (startup.isDeferring) {
+    if (!startup.tasks) {
+      startup.tasks = newQueue(deallocateDeferredStartupTask, NULL);
+    }
+
+    if (startup.tasks) {
+      DeferredStartupTask *dst;
+
+      if ((dst = malloc(sizeof(*dst)))) {
+        memset(dst, 0, sizeof(*dst));
+        dst->name = name;
+        dst->task = task;
+        dst->data = data;
+
+        if (enqueueItem(startup.tasks, dst)) {
+          logMessage(LOG_CATEGORY(STARTUP_EVENTS), "task deferred: %s", name);
+          return;
+        }
+
+        free(dst);
+      } else {
+        logMallocError();
+      }
+    }
+  }
+
+  task(data);
+}
+
+static void
+exitStartup (void *data) {
+  startup.isDeferring = 0;
+  stopStartupMonitoring();
+  cancelStartupAlarm(&startup.taskAlarm);
+
+  if (startup.tasks) {
+    deallocateQueue(startup.tasks);
+    startup.tasks = NULL;
+  }
+}
+
+void
+beginStartup (void) {
+  memset(&startup, 0, sizeof(startup));
+  getMonotonicTime(&startup.begin);
+  startup.firstWindow = -1;
+  startup.isDeferring = 1;
+
+  startup.windowListener = registerReportListener(
+    REPORT_BRAILLE_WINDOW_UPDATED, handleBrailleWindowUpdated, NULL
+  );
+
+  asyncNewRelativeAlarm(&startup.timeoutAlarm, STARTUP_TASK_DEFER_TIMEOUT,
+                        handleStartupTimeoutAlarm, NULL);
+
+  onProgramExit("startup", exitStartup, NULL);
+}
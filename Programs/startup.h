@@ -0,0 +1,42 @@
+/*
+ * BRLTTY - A background process providing access to the console screen (when in
+ *          text mode) for a blind person using a refreshable braille display.
+ *
+ * Copyright (C) 1995-2021 by The BRLTTY Developers.
+ *
+ * BRLTTY comes with ABSOLUTELY NO WARRANTY.
+ *
+ * This is free software, placed under the terms of the
+ * GNU Lesser General Public License, as published by the Free Software
+ * Foundation; either version 2.1 of the License, or (at your option) any
+ * later version. Please see the file LICENSE-LGPL for details.
+ *
+ * Web Page: http://brltty.app/
+ *
+ * This software is maintained by Dave Mielke <dave@mielke.cc>.
+ */
+
+#ifndef BRLTTY_INCLUDED_STARTUP
+#define BRLTTY_INCLUDED_STARTUP
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+extern void beginStartup (void);
+extern void endStartup (const char *reason);
+extern int isStartupComplete (void);
+
+extern void beginStartupPhase (const char *name);
+extern void endStartupPhase (void);
+
+#define STARTUP_TASK(name) void name (void *data)
+typedef STARTUP_TASK(StartupTask);
+
+extern void deferStartupTask (const char *name, StartupTask *task, void *data);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* BRLTTY_INCLUDED_STARTUP */
@@ -332,6 +332,15 @@ getMonotonicElapsed (const TimeValue *start) {
   return millisecondsBetween(start, &now);
 }
 
+int64_t
+getMonotonicNanosecondsElapsed (const TimeValue *start) {
+  TimeValue now;
+
+  getMonotonicTime(&now);
+  return ((int64_t)(now.seconds - start->seconds) * NSECS_PER_SEC)
+       + (now.nanoseconds - start->nanoseconds);
+}
+
 void
 restartTimePeriod (TimePeriod *period) {
   getMonotonicTime(&period->start);
@@ -60,6 +60,11 @@ typedef struct {
   uint32_t aliasCount;
 } TextTableHeader;
 
+#define TEXT_TABLE_LATIN_LIMIT 0X250
+#define TEXT_TABLE_BOX_DRAWING_FIRST 0X2500
+#define TEXT_TABLE_BOX_DRAWING_COUNT 0X80
+#define TEXT_TABLE_MEMO_SIZE 0X100
+
 struct TextTableStruct {
   union {
     TextTableHeader *fields;
@@ -75,6 +80,14 @@ struct TextTableStruct {
   struct {
     const unsigned char *replacementCharacter;
   } cells;
+
+  struct {
+    unsigned char latin[TEXT_TABLE_LATIN_LIMIT];
+    unsigned char boxDrawing[TEXT_TABLE_BOX_DRAWING_COUNT];
+    uint32_t memo[TEXT_TABLE_MEMO_SIZE];
+    unsigned int charsetGeneration;
+    unsigned char isPrepared;
+  } cache;
 };
 
 extern const TextTableAliasEntry *locateTextTableAlias (
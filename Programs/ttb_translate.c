@@ -106,9 +106,25 @@ getUnicodeCell (TextTable *table, wchar_t character) {
   return NULL;
 }
 
+/* Incremented whenever the dots for a character might have changed. */
+static unsigned int textTableGeneration = 0;
+
+unsigned int
+getTextTableGeneration (void) {
+  return textTableGeneration;
+}
+
+static void
+resetTextTableCache (TextTable *table) {
+  textTableGeneration += 1;
+  table->cache.isPrepared = 0;
+  memset(table->cache.memo, 0, sizeof(table->cache.memo));
+}
+
 void
 setTryBaseCharacter (TextTable *table, unsigned char yes) {
   table->options.tryBaseCharacter = yes;
+  resetTextTableCache(table);
 }
 
 static int
@@ -191,8 +207,8 @@ setBrailleRepresentation (wchar_t character, void *data) {
   return 0;
 }
 
-unsigned char
-convertCharacterToDots (TextTable *table, wchar_t character) {
+static unsigned char
+translateCharacterToDots (TextTable *table, wchar_t character) {
   wchar_t row = character & ~UNICODE_CELL_MASK;
 
   switch (row) {
@@ -237,6 +253,94 @@ convertCharacterToDots (TextTable *table, wchar_t character) {
   return BRL_DOT_1 | BRL_DOT_2 | BRL_DOT_3 | BRL_DOT_4 | BRL_DOT_5 | BRL_DOT_6 | BRL_DOT_7 | BRL_DOT_8;
 }
 
+static void
+prepareTextTableCache (TextTable *table) {
+  for (unsigned int index=0; index<TEXT_TABLE_LATIN_LIMIT; index+=1) {
+    table->cache.latin[index] = translateCharacterToDots(table, index);
+  }
+
+  for (unsigned int index=0; index<TEXT_TABLE_BOX_DRAWING_COUNT; index+=1) {
+    table->cache.boxDrawing[index] = translateCharacterToDots(
+      table, (TEXT_TABLE_BOX_DRAWING_FIRST + index)
+    );
+  }
+
+  table->cache.charsetGeneration = getCharsetGeneration();
+  table->cache.isPrepared = 1;
+}
+
+static inline void
+requireTextTableCache (TextTable *table) {
+  if (table->cache.isPrepared) {
+    if (table->cache.charsetGeneration == getCharsetGeneration()) return;
+    resetTextTableCache(table);
+  }
+
+  prepareTextTableCache(table);
+}
+
+static inline unsigned int
+getTextTableMemoIndex (wchar_t character) {
+  uint32_t hash = (uint32_t)character * UINT32_C(0X9E3779B1);
+  return (hash >> 24) & (TEXT_TABLE_MEMO_SIZE - 1);
+}
+
+static unsigned char
+getMemoizedDots (TextTable *table, wchar_t character) {
+  if ((character < 0) || (character > UNICODE_LAST_CHARACTER)) {
+    return translateCharacterToDots(table, character);
+  }
+
+  /* Characters in the private row mapped to the current charset aren't
+   * memoized since their translation depends upon the locale.
+   */
+  if ((character & ~UNICODE_CELL_MASK) == 0XF000) {
+    return translateCharacterToDots(table, character);
+  }
+
+  /* Each entry holds both the character and its dots in a single word so
+   * that a concurrent reader can never see a mismatched pair.
+   */
+  uint32_t *entry = &table->cache.memo[getTextTableMemoIndex(character)];
+  uint32_t value = *entry;
+  if (value && ((value >> 8) == (uint32_t)character)) return value & 0XFF;
+
+  unsigned char dots = translateCharacterToDots(table, character);
+  if (character) *entry = ((uint32_t)character << 8) | dots;
+  return dots;
+}
+
+static inline unsigned char
+getCachedDots (TextTable *table, wchar_t character) {
+  if ((character >= 0) && (character < TEXT_TABLE_LATIN_LIMIT)) {
+    return table->cache.latin[character];
+  }
+
+  {
+    wchar_t offset = character - TEXT_TABLE_BOX_DRAWING_FIRST;
+
+    if ((offset >= 0) && (offset < TEXT_TABLE_BOX_DRAWING_COUNT)) {
+      return table->cache.boxDrawing[offset];
+    }
+  }
+
+  return getMemoizedDots(table, character);
+}
+
+unsigned char
+convertCharacterToDots (TextTable *table, wchar_t character) {
+  requireTextTableCache(table);
+  return getCachedDots(table, character);
+}
+
+void
+convertCharactersToDots (TextTable *table, const wchar_t *characters, unsigned char *cells, size_t count) {
+  const wchar_t *end = characters + count;
+
+  requireTextTableCache(table);
+  while (characters < end) *cells++ = getCachedDots(table, *characters++);
+}
+
 wchar_t
 convertDotsToCharacter (TextTable *table, unsigned char dots) {
   const TextTableHeader *header = table->header.fields;
@@ -282,6 +386,7 @@ replaceTextTable (const char *directory, const char *name) {
     TextTable *oldTable = textTable;
 
     lockTextTable();
+      resetTextTableCache(newTable);
       textTable = newTable;
     unlockTextTable();
 
@@ -23,6 +23,7 @@
 #include "log.h"
 #include "unicode.h"
 #include "ascii.h"
+#include "unicode.auto.h"
 
 #ifdef HAVE_ICU
 #include <unicode/uversion.h>
@@ -34,13 +35,6 @@
 #include <unicode/unorm.h>
 #endif /* unorm */
 
-static int
-isUcharCompatible (wchar_t character) {
-  UChar uc = character;
-
-  return uc == character;
-}
-
 static int
 getName (wchar_t character, char *buffer, size_t size, UCharNameChoice choice) {
   UErrorCode error = U_ZERO_ERROR;
@@ -108,58 +102,36 @@ getCharacterByAlias (wchar_t *character, const char *alias) {
 #endif /* HAVE_ICU */
 }
 
-int
-getCharacterWidth (wchar_t character) {
-#if defined(HAVE_WCWIDTH)
-  return wcwidth(character);
-#elif defined(HAVE_ICU)
-  UCharCategory category = u_getIntPropertyValue(character, UCHAR_GENERAL_CATEGORY);
-  UEastAsianWidth width = u_getIntPropertyValue(character, UCHAR_EAST_ASIAN_WIDTH);
-
-  if (character == 0) return 0;
-  if (category == U_CONTROL_CHAR) return -1;
-
-  if (category == U_NON_SPACING_MARK) return 0;
-  if (category == U_ENCLOSING_MARK) return 0;
-
-  /* Hangul Jamo medial vowels and final consonants */
-  if ((character >= 0X1160) && (character <= 0X11FF) && (category == U_OTHER_LETTER)) return 0;
-
-  /*  */
-  if (character == 0XAD) return 1; /* soft hyphen */
-  if (category == U_FORMAT_CHAR) return 0;
-
-  if (width == U_EA_FULLWIDTH) return 2;
-  if (width == U_EA_HALFWIDTH) return 1;
-
-  if (width == U_EA_WIDE) return 2;
-  if (width == U_EA_NARROW) return 1;
-
-  if (width == U_EA_AMBIGUOUS) {
-    /* CJK Unified Ideographs block */
-    if ((character >= 0X4E00) && (character <= 0X9FFF)) return 2;
-
-    /* CJK Unified Ideographs Externsion A block */
-    if ((character >= 0X3400) && (character <= 0X4DBF)) return 2;
-
-    /* CJK Compatibility Ideographs block */
-    if ((character >= 0XF900) && (character <= 0XFAFF)) return 2;
+#define UNICODE_TABLE_LOOKUP(table, character) \
+  (table##Values[ \
+    (table##Blocks[ \
+      (table##Groups[(character) >> (UNICODE_TABLE_BLOCK_BITS + UNICODE_TABLE_GROUP_BITS)] \
+        << UNICODE_TABLE_GROUP_BITS) | \
+      (((character) >> UNICODE_TABLE_BLOCK_BITS) & ((1 << UNICODE_TABLE_GROUP_BITS) - 1)) \
+    ] << UNICODE_TABLE_BLOCK_BITS) | \
+    ((character) & ((1 << UNICODE_TABLE_BLOCK_BITS) - 1)) \
+  ])
+
+static inline int
+isTableCharacter (wchar_t character) {
+  return (uint32_t)character < UNICODE_TABLE_CHARACTER_COUNT;
+}
 
-    /* Supplementary Ideographic Plane */
-  //if ((character >= 0X20000) && (character <= 0X2FFFF)) return 2;
+static inline unsigned int
+getPropertyValue (wchar_t character) {
+  if (!isTableCharacter(character)) return 0;
+  return UNICODE_TABLE_LOOKUP(unicodeProperties, character);
+}
 
-    /* Tertiary Ideographic Plane */
-  //if ((character >= 0X30000) && (character <= 0X3FFFF)) return 2;
-  }
+unsigned int
+getCharacterProperties (wchar_t character) {
+  return getPropertyValue(character) & ((1 << UNICODE_TABLE_WIDTH_SHIFT) - 1);
+}
 
-  if (category == U_UNASSIGNED) return -1;
-  return 1;
-#else /* character width */
-  if (character == NUL) return 0;
-  if (character == DEL) return -1;
-  if (!(character & 0X60)) return -1;
-  return 1;
-#endif /* character width */
+int
+getCharacterWidth (wchar_t character) {
+  if (!isTableCharacter(character)) return -1;
+  return (int)(getPropertyValue(character) >> UNICODE_TABLE_WIDTH_SHIFT) - 1;
 }
 
 int
@@ -169,31 +141,18 @@ isBrailleCharacter (wchar_t character) {
 
 int
 isIdeographicCharacter (wchar_t character) {
-#ifdef HAVE_ICU
-  if (u_hasBinaryProperty(character, UCHAR_IDEOGRAPHIC)) return 1;
-#endif /* HAVE_ICU */
-
-  return 0;
+  return !!(getCharacterProperties(character) & UNICODE_PROPERTY_IDEOGRAPHIC);
 }
 
 int
 isEmojiSequence (const wchar_t *characters, size_t count) {
-#ifdef HAVE_ICU
   const wchar_t *character = characters;
   const wchar_t *end = character + count;
 
   while (character < end) {
-    #if U_ICU_VERSION_MAJOR_NUM >= 57
-    if (u_hasBinaryProperty(*character, UCHAR_EMOJI)) {
-      if (u_hasBinaryProperty(*character, UCHAR_EMOJI_PRESENTATION)) {
-        return 1;
-      }
-    }
-    #endif /* U_ICU_VERSION_MAJOR_NUM >= 57 */
-
+    if (getCharacterProperties(*character) & UNICODE_PROPERTY_EMOJI) return 1;
     character += 1;
   }
-#endif /* HAVE_ICU */
 
   return 0;
 }
@@ -207,21 +166,123 @@ getReplacementCharacter (void) {
 #endif /* HAVE_WCHAR_H */
 }
 
+static NormalizationStatistics normalizationStatistics;
+
+void
+getNormalizationStatistics (NormalizationStatistics *statistics) {
+  *statistics = normalizationStatistics;
+}
+
+#ifdef HAVE_ICU
+static inline int
+isNormalizationBoundary (wchar_t character) {
+  /* NFC never composes or reorders across a stable starter */
+  return !(getPropertyValue(character) & (UNICODE_PROPERTY_COMBINING | UNICODE_PROPERTY_NFC_UNSTABLE));
+}
+
+static const wchar_t *
+getNormalizationSegment (const wchar_t *character, const wchar_t *end, int *isUnstable) {
+  unsigned int combiningCount = 0;
+  *isUnstable = 0;
+
+  do {
+    unsigned int properties = getPropertyValue(*character);
+
+    if (properties & UNICODE_PROPERTY_NFC_UNSTABLE) *isUnstable = 1;
+
+    if (properties & UNICODE_PROPERTY_COMBINING) {
+      /* more than one mark might need to be reordered */
+      if (++combiningCount > 1) *isUnstable = 1;
+    }
+  } while ((++character < end) && !isNormalizationBoundary(*character));
+
+  return character;
+}
+
+/* every character below the combining diacritical marks is a stable starter */
+#define UNICODE_NORMALIZATION_QUICK_LIMIT 0X300
+
+static const wchar_t *
+findUnstableSegment (const wchar_t *character, const wchar_t *end) {
+  while (character < end) {
+    if ((uint32_t)*character < UNICODE_NORMALIZATION_QUICK_LIMIT) {
+      do {
+        if (++character == end) return NULL;
+      } while ((uint32_t)*character < UNICODE_NORMALIZATION_QUICK_LIMIT);
+
+      /* a following mark belongs to the segment of the last starter */
+      if (!isNormalizationBoundary(*character)) character -= 1;
+    }
+
+    {
+      int isUnstable;
+      const wchar_t *next = getNormalizationSegment(character, end, &isUnstable);
+
+      if (isUnstable) return character;
+      character = next;
+    }
+  }
+
+  return NULL;
+}
+
+static int
+normalizeSpan (
+  const UChar *source, int32_t length,
+  UChar *target, int32_t size, int32_t *count
+) {
+  UErrorCode error = U_ZERO_ERROR;
+
+#ifdef HAVE_UNICODE_UNORM2_H
+  static const UNormalizer2 *normalizer = NULL;
+
+  if (!normalizer) {
+    normalizer = unorm2_getNFCInstance(&error);
+    if (!U_SUCCESS(error)) return 0;
+  }
+
+  *count = unorm2_normalize(normalizer,
+                            source, length,
+                            target, size,
+                            &error);
+#else /* unorm */
+  *count = unorm_normalize(source, length,
+                           UNORM_NFC, 0,
+                           target, size,
+                           &error);
+#endif /* unorm */
+
+  if (!U_SUCCESS(error)) return 0;
+  normalizationStatistics.spans += 1;
+  normalizationStatistics.characters += length;
+  return 1;
+}
+#endif /* HAVE_ICU */
+
 int
 normalizeCharacters (
   size_t *length, const wchar_t *characters,
   wchar_t *buffer, unsigned int *map
 ) {
+  normalizationStatistics.calls += 1;
+
 #ifdef HAVE_ICU
   if (*length < 2) return 0;
 
+  const wchar_t *end = characters + *length;
+  const wchar_t *unstable = findUnstableSegment(characters, end);
+
+  if (!unstable) {
+    normalizationStatistics.skipped += 1;
+    return 0;
+  }
+
   UChar source[*length];
   UChar target[*length];
   int32_t count;
 
   {
     const wchar_t *src = characters;
-    const wchar_t *end = src + *length;
     UChar *trg = source;
 
     while (src < end) {
@@ -229,29 +290,48 @@ normalizeCharacters (
     }
   }
 
+  /* only the segments which might change are passed to the normalizer */
+  count = unstable - characters;
+  memcpy(target, source, (count * sizeof(target[0])));
+
   {
-    UErrorCode error = U_ZERO_ERROR;
+    const wchar_t *segment = unstable;
 
-#ifdef HAVE_UNICODE_UNORM2_H
-    static const UNormalizer2 *normalizer = NULL;
+    while (segment < end) {
+      int isUnstable;
+      const wchar_t *next = getNormalizationSegment(segment, end, &isUnstable);
 
-    if (!normalizer) {
-      normalizer = unorm2_getNFCInstance(&error);
-      if (!U_SUCCESS(error)) return 0;
-    }
+      if (isUnstable) {
+        while (next < end) {
+          const wchar_t *after = getNormalizationSegment(next, end, &isUnstable);
 
-    count = unorm2_normalize(normalizer,
-                             source, ARRAY_COUNT(source),
-                             target, ARRAY_COUNT(target),
-                             &error);
-#else /* unorm */
-    count = unorm_normalize(source, ARRAY_COUNT(source),
-                            UNORM_NFC, 0,
-                            target, ARRAY_COUNT(target),
-                            &error);
-#endif /* unorm */
+          if (!isUnstable) break;
+          next = after;
+        }
 
-    if (!U_SUCCESS(error)) return 0;
+        {
+          int32_t from = segment - characters;
+          int32_t spanCount;
+
+          if (!normalizeSpan(&source[from], (next - segment),
+                             &target[count], (ARRAY_COUNT(target) - count),
+                             &spanCount)) {
+            return 0;
+          }
+
+          count += spanCount;
+        }
+      } else {
+        int32_t from = segment - characters;
+        int32_t spanLength = next - segment;
+
+        if (spanLength > (ARRAY_COUNT(target) - count)) return 0;
+        memcpy(&target[count], &source[from], (spanLength * sizeof(target[0])));
+        count += spanLength;
+      }
+
+      segment = next;
+    }
   }
 
   if (count == *length) {
@@ -278,6 +358,7 @@ normalizeCharacters (
   }
 
   *length = count;
+  normalizationStatistics.changed += 1;
   return 1;
 #else /* HAVE_ICU */
   return 0;
@@ -287,32 +368,11 @@ normalizeCharacters (
 wchar_t
 getBaseCharacter (wchar_t character) {
 #ifdef HAVE_ICU
-  if (isUcharCompatible(character)) {
-    UChar source[] = {character};
-    const unsigned int resultLength = 0X10;
-    UChar resultBuffer[resultLength];
-    UErrorCode error = U_ZERO_ERROR;
-
-#ifdef HAVE_UNICODE_UNORM2_H
-    static const UNormalizer2 *normalizer = NULL;
-
-    if (!normalizer) {
-      normalizer = unorm2_getNFDInstance(&error);
-      if (!U_SUCCESS(error)) return 0;
-    }
-
-    unorm2_normalize(normalizer,
-                     source, ARRAY_COUNT(source),
-                     resultBuffer, resultLength,
-                     &error);
-#else /* unorm */
-    unorm_normalize(source, ARRAY_COUNT(source),
-                    UNORM_NFD, 0,
-                    resultBuffer, resultLength,
-                    &error);
-#endif /* unorm */
+  if (isTableCharacter(character)) {
+    wchar_t base = UNICODE_TABLE_LOOKUP(unicodeBaseCharacters, character);
 
-    if (U_SUCCESS(error)) return resultBuffer[0];
+    /* characters which are their own base aren't stored */
+    return base? base: character;
   }
 #endif /* HAVE_ICU */
 
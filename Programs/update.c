@@ -728,7 +728,7 @@ writeBrailleWindow (BrailleDisplay *brl, const wchar_t *text, unsigned char qual
   }
 
   brl->quality = quality;
-  return braille->writeWindow(brl, text);
+  return writeBrailleRows(brl, text);
 }
 
 static void
@@ -782,69 +782,69 @@ readBrailleWindow (ScreenCharacter *characters, size_t count) {
   }
 }
 
-typedef void ScreenCharacterTranslator (
-  const ScreenCharacter *character, unsigned char *cell, wchar_t *text
-);
-
 static void
-translateScreenCharacterText (
-  const ScreenCharacter *character, unsigned char *cell, wchar_t *text
+translateScreenRowText (
+  const ScreenCharacter *characters, unsigned char *cells, wchar_t *text,
+  unsigned int count
 ) {
-  *cell = convertCharacterToDots(textTable, character->text);
-  *text = character->text;
+  for (unsigned int index=0; index<count; index+=1) {
+    text[index] = characters[index].text;
+  }
 
-  {
+  convertCharactersToDots(textTable, text, cells, count);
+
+  if (isSixDotComputerBraille()) {
     const unsigned char dots = BRL_DOT_7 | BRL_DOT_8;
 
-    if (*cell & dots) {
-      if (isSixDotComputerBraille()) {
-        *cell &= ~dots;
-      }
+    for (unsigned int index=0; index<count; index+=1) {
+      cells[index] &= ~dots;
     }
   }
 
   if (prefs.showAttributes) {
-    overlayAttributesUnderline(cell, character->attributes);
+    for (unsigned int index=0; index<count; index+=1) {
+      overlayAttributesUnderline(&cells[index], characters[index].attributes);
+    }
   }
 
   {
     BlinkDescriptor *blink = &uppercaseLettersBlinkDescriptor;
 
     if (isBlinkEnabled(blink)) {
-      if (iswupper(character->text)) {
-        requireBlinkDescriptor(blink);
-        if (!isBlinkVisible(blink)) *cell = 0;
+      for (unsigned int index=0; index<count; index+=1) {
+        if (iswupper(text[index])) {
+          requireBlinkDescriptor(blink);
+          if (!isBlinkVisible(blink)) cells[index] = 0;
+        }
       }
     }
   }
 }
 
 static void
-translateScreenCharacterAttributes (
-  const ScreenCharacter *character, unsigned char *cell, wchar_t *text
+translateScreenRowAttributes (
+  const ScreenCharacter *characters, unsigned char *cells, wchar_t *text,
+  unsigned int count
 ) {
-  *text = UNICODE_BRAILLE_ROW | (*cell = convertAttributesToDots(attributesTable, character->attributes));
+  for (unsigned int index=0; index<count; index+=1) {
+    text[index] = UNICODE_BRAILLE_ROW | (cells[index] = convertAttributesToDots(attributesTable, characters[index].attributes));
+  }
 }
 
 static void
 translateBrailleWindow (
   const ScreenCharacter *characters, wchar_t *textBuffer
 ) {
-  ScreenCharacterTranslator *translateScreenCharacter =
-    ses->displayMode?
-    translateScreenCharacterAttributes:
-    translateScreenCharacterText;
-
   for (unsigned int row=0; row<brl.textRows; row+=1) {
-    const ScreenCharacter *character = &characters[row * textCount];
-    const ScreenCharacter *end = character + textCount;
-
     unsigned int start = (row * brl.textColumns) + textStart;
-    unsigned char *cell = &brl.buffer[start];
+    const ScreenCharacter *from = &characters[row * textCount];
+    unsigned char *cells = &brl.buffer[start];
     wchar_t *text = &textBuffer[start];
 
-    while (character < end) {
-      translateScreenCharacter(character++, cell++, text++);
+    if (ses->displayMode) {
+      translateScreenRowAttributes(from, cells, text, textCount);
+    } else {
+      translateScreenRowText(from, cells, text, textCount);
     }
   }
 }
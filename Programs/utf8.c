@@ -21,10 +21,12 @@
 #include <stdio.h>
 #include <string.h>
 
-#include "log.h"
 #include "utf8.h"
 #include "unicode.h"
 
+#ifndef UTF8_CONVERSIONS_ONLY
+#include "log.h"
+
 wchar_t *
 allocateCharacters (size_t count) {
   {
@@ -35,6 +37,7 @@ allocateCharacters (size_t count) {
   logMallocError();
   return NULL;
 }
+#endif /* UTF8_CONVERSIONS_ONLY */
 
 size_t
 convertCodepointToUtf8 (uint32_t codepoint, Utf8Buffer utf8) {
@@ -165,26 +168,155 @@ convertUtf8ToWchars (const char **utf8, wchar_t **characters, size_t count) {
   if (count) **characters = 0;
 }
 
+typedef uint64_t Utf8Word;
+#define UTF8_WORD_HIGH_BITS UINT64_C(0X8080808080808080)
+
+static inline int
+isUtf8Continuation (unsigned char byte) {
+  return (byte & 0XC0) == 0X80;
+}
+
+static inline int
+isUtf8Codepoint (uint32_t codepoint, size_t length) {
+  /* reject overlong forms, UTF-16 surrogates, and values beyond U+10FFFF */
+  static const uint32_t minimums[] = {0, 0, 0X80, 0X800, 0X10000};
+
+  if (codepoint < minimums[length]) return 0;
+  if (codepoint > 0X10FFFF) return 0;
+
+  if ((codepoint >= UNICODE_SURROGATE_BEGIN) &&
+      (codepoint <= UNICODE_SURROGATE_END)) {
+    return 0;
+  }
+
+  return 1;
+}
+
+int
+convertUtf8TextToWchars (
+  const char **utf8, size_t *utfs,
+  wchar_t **characters, size_t *count
+) {
+  const unsigned char *byte = (const unsigned char *)*utf8;
+  const unsigned char *end = byte + *utfs;
+  wchar_t *character = *characters;
+  wchar_t *stop = character + *count;
+  int ok = 1;
+
+  while ((byte < end) && (character < stop)) {
+    if (!(*byte & 0X80)) {
+      /* a run of ASCII is copied eight bytes at a time */
+      while (((end - byte) >= sizeof(Utf8Word)) &&
+             ((stop - character) >= sizeof(Utf8Word))) {
+        Utf8Word word;
+        memcpy(&word, byte, sizeof(word));
+        if (word & UTF8_WORD_HIGH_BITS) break;
+
+        for (unsigned int index=0; index<sizeof(word); index+=1) {
+          character[index] = byte[index];
+        }
+
+        byte += sizeof(word);
+        character += sizeof(word);
+      }
+
+      while ((byte < end) && (character < stop) && !(*byte & 0X80)) {
+        *character++ = *byte++;
+      }
+
+      if ((byte < end) && isUtf8Continuation(*byte)) {
+        /* a stray continuation byte invalidates the preceding character */
+        ok = 0;
+        break;
+      }
+
+      continue;
+    }
+
+    {
+      size_t left = end - byte;
+      const unsigned char *next = NULL;
+      uint32_t codepoint = 0;
+
+      if (((*byte & 0XE0) == 0XC0) && (left >= 2) &&
+          isUtf8Continuation(byte[1])) {
+        codepoint = ((byte[0] & 0X1F) << 6) | (byte[1] & 0X3F);
+        next = byte + 2;
+      } else if (((*byte & 0XF0) == 0XE0) && (left >= 3) &&
+                 isUtf8Continuation(byte[1]) && isUtf8Continuation(byte[2])) {
+        codepoint = ((byte[0] & 0X0F) << 12) | ((byte[1] & 0X3F) << 6) | (byte[2] & 0X3F);
+        next = byte + 3;
+      } else if (((*byte & 0XF8) == 0XF0) && (left >= 4) &&
+                 isUtf8Continuation(byte[1]) && isUtf8Continuation(byte[2]) &&
+                 isUtf8Continuation(byte[3])) {
+        codepoint = ((byte[0] & 0X07) << 18) | ((byte[1] & 0X3F) << 12)
+                  | ((byte[2] & 0X3F) << 6) | (byte[3] & 0X3F);
+        next = byte + 4;
+      }
+
+      if (!next || ((next != end) && isUtf8Continuation(*next)) ||
+          !isUtf8Codepoint(codepoint, (next - byte))) {
+        /* a truncated, malformed, or non-shortest sequence */
+        ok = 0;
+        break;
+      }
+
+      if (codepoint > WCHAR_MAX) codepoint = UNICODE_REPLACEMENT_CHARACTER;
+      *character++ = codepoint;
+      byte = next;
+    }
+  }
+
+  *utfs -= (const char *)byte - *utf8;
+  *utf8 = (const char *)byte;
+
+  *count -= character - *characters;
+  *characters = character;
+
+  return ok;
+}
+
 size_t
 makeUtf8FromWchars (const wchar_t *characters, unsigned int count, char *buffer, size_t size) {
   char *byte = buffer;
   const char *end = byte + size;
+  const wchar_t *character = characters;
+  const wchar_t *stop = character + count;
+
+  while (character < stop) {
+    uint32_t codepoint = *character;
+
+    if (!(codepoint & ~0X7F)) {
+      if ((byte + 1) >= end) break;
+      *byte++ = codepoint;
+    } else if (!(codepoint & ~0X7FF)) {
+      if ((byte + 2) >= end) break;
+      *byte++ = 0XC0 | (codepoint >> 6);
+      *byte++ = 0X80 | (codepoint & 0X3F);
+    } else if (!(codepoint & ~0XFFFF)) {
+      if ((byte + 3) >= end) break;
+      *byte++ = 0XE0 | (codepoint >> 12);
+      *byte++ = 0X80 | ((codepoint >> 6) & 0X3F);
+      *byte++ = 0X80 | (codepoint & 0X3F);
+    } else {
+      Utf8Buffer utf8;
+      size_t utfs = convertWcharToUtf8(codepoint, utf8);
 
-  for (unsigned int i=0; i<count; i+=1) {
-    Utf8Buffer utf8;
-    size_t utfs = convertWcharToUtf8(characters[i], utf8);
+      char *next = byte + utfs;
+      if (next >= end) break;
 
-    char *next = byte + utfs;
-    if (next >= end) break;
+      memcpy(byte, utf8, utfs);
+      byte = next;
+    }
 
-    memcpy(byte, utf8, utfs);
-    byte = next;
+    character += 1;
   }
 
   *byte = 0;
   return byte - buffer;
 }
 
+#ifndef UTF8_CONVERSIONS_ONLY
 char *
 getUtf8FromWchars (const wchar_t *characters, unsigned int count, size_t *length) {
   size_t size = (count * UTF8_LEN_MAX) + 1;
@@ -200,6 +332,7 @@ getUtf8FromWchars (const wchar_t *characters, unsigned int count, size_t *length
 
   return text;
 }
+#endif /* UTF8_CONVERSIONS_ONLY */
 
 size_t
 makeWcharsFromUtf8 (const char *text, wchar_t *characters, size_t size) {
@@ -233,6 +366,7 @@ countUtf8Characters (const char *text) {
   return makeWcharsFromUtf8(text, NULL, 0);
 }
 
+#ifndef UTF8_CONVERSIONS_ONLY
 int
 writeUtf8Character (FILE *stream, wchar_t character) {
   Utf8Buffer utf8;
@@ -269,6 +403,7 @@ int
 writeUtf8ByteOrderMark (FILE *stream) {
   return writeUtf8Character(stream, UNICODE_BYTE_ORDER_MARK);
 }
+#endif /* UTF8_CONVERSIONS_ONLY */
 
 int
 isCharsetUTF8 (const char *name) {
@@ -0,0 +1,260 @@
+/*
+ * BRLTTY - A background process providing access to the console screen (when in
+ *          text mode) for a blind person using a refreshable braille display.
+ *
+ * Copyright (C) 1995-2021 by The BRLTTY Developers.
+ *
+ * BRLTTY comes with ABSOLUTELY NO WARRANTY.
+ *
+ * This is free software, placed under the terms of the
+ * GNU Lesser General Public License, as published by the Free Software
+ * Foundation; either version 2.1 of the License, or (at your option) any
+ * later version. Please see the file LICENSE-LGPL for details.
+ *
+ * Web Page: http://brltty.app/
+ *
+ * This software is maintained by Dave Mielke <dave@mielke.cc>.
+ */
+
+#include "prologue.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "log.h"
+#include "program.h"
+#include "options.h"
+#include "utf8.h"
+
+BEGIN_OPTION_TABLE(programOptions)
+END_OPTION_TABLE
+
+#define TEXT_LIMIT 0X100
+
+static const wchar_t asciiCharacters[] = {
+  'a', 'e', 'n', 't', ' ', '.', 'Q', '7'
+};
+
+static const wchar_t latinCharacters[] = {
+  'a', 'e', 'n', ' ', 0XE9, 0XE8, 0XFC, 0XDF, 0X153
+};
+
+static const wchar_t cjkCharacters[] = {
+  0X4E00, 0X4E2D, 0X6587, 0X3042, 0X30AB, 0XAC00, 0X3002
+};
+
+typedef struct {
+  const char *name;
+  const wchar_t *characters;
+  unsigned int count;
+} CharacterSet;
+
+static const CharacterSet characterSets[] = {
+  { .name = "ASCII", .characters = asciiCharacters, .count = ARRAY_COUNT(asciiCharacters) },
+  { .name = "Latin", .characters = latinCharacters, .count = ARRAY_COUNT(latinCharacters) },
+  { .name = "CJK", .characters = cjkCharacters, .count = ARRAY_COUNT(cjkCharacters) },
+};
+
+static unsigned int
+randomInteger (unsigned int limit) {
+  return rand() % limit;
+}
+
+static void
+fillCharacters (wchar_t *characters, unsigned int count, const CharacterSet *set) {
+  for (unsigned int index=0; index<count; index+=1) {
+    characters[index] = set->characters[randomInteger(set->count)];
+  }
+}
+
+static int
+isShortestUtf8 (uint32_t codepoint, size_t length) {
+  size_t shortest = (codepoint < 0X80)? 1:
+                    (codepoint < 0X800)? 2:
+                    (codepoint < 0X10000)? 3:
+                    4;
+
+  if (length != shortest) return 0;
+  if ((codepoint >= 0XD800) && (codepoint <= 0XDFFF)) return 0;
+  return codepoint <= 0X10FFFF;
+}
+
+static int
+decodeReference (const char **utf8, size_t *utfs, wchar_t **characters, size_t *count) {
+  while ((*count > 0) && (*utfs > 0)) {
+    const char *start = *utf8;
+    uint32_t codepoint;
+
+    if (!convertUtf8ToCodepoint(&codepoint, utf8, utfs)) return 0;
+    if (!isShortestUtf8(codepoint, (*utf8 - start))) return 0;
+
+    *(*characters)++ = codepoint;
+    *count -= 1;
+  }
+
+  return 1;
+}
+
+static size_t
+encodeReference (const wchar_t *characters, unsigned int count, char *buffer, size_t size) {
+  char *byte = buffer;
+  const char *end = byte + size;
+
+  for (unsigned int i=0; i<count; i+=1) {
+    Utf8Buffer utf8;
+    size_t utfs = convertWcharToUtf8(characters[i], utf8);
+
+    char *next = byte + utfs;
+    if (next >= end) break;
+
+    memcpy(byte, utf8, utfs);
+    byte = next;
+  }
+
+  *byte = 0;
+  return byte - buffer;
+}
+
+static int
+testDecoding (const char *text, size_t length, size_t limit) {
+  wchar_t expected[limit];
+  wchar_t actual[limit];
+
+  const char *expectedText = text;
+  const char *actualText = text;
+  size_t expectedLength = length;
+  size_t actualLength = length;
+  wchar_t *expectedCharacter = expected;
+  wchar_t *actualCharacter = actual;
+  size_t expectedCount = limit;
+  size_t actualCount = limit;
+
+  int expectedOK = decodeReference(&expectedText, &expectedLength, &expectedCharacter, &expectedCount);
+  int actualOK = convertUtf8TextToWchars(&actualText, &actualLength, &actualCharacter, &actualCount);
+
+  if (expectedOK != actualOK) {
+    logBytes(LOG_ERR, "decode status mismatch", text, length);
+    return 0;
+  }
+
+  if (!expectedOK) return 1;
+
+  if ((actualText != expectedText) || (actualLength != expectedLength) ||
+      (actualCount != expectedCount) ||
+      (wmemcmp(actual, expected, (limit - expectedCount)) != 0)) {
+    logBytes(LOG_ERR, "decode result mismatch", text, length);
+    return 0;
+  }
+
+  return 1;
+}
+
+static int
+testEncoding (const wchar_t *characters, unsigned int count, size_t size) {
+  char expected[size];
+  char actual[size];
+
+  size_t expectedLength = encodeReference(characters, count, expected, size);
+  size_t actualLength = makeUtf8FromWchars(characters, count, actual, size);
+
+  if ((actualLength != expectedLength) || (memcmp(actual, expected, (expectedLength + 1)) != 0)) {
+    logMessage(LOG_ERR, "encode mismatch: count=%u size=%zu", count, size);
+    return 0;
+  }
+
+  return 1;
+}
+
+typedef struct {
+  const char *name;
+  const char *text;
+  unsigned char valid;
+} DecodingCase;
+
+static const DecodingCase decodingCases[] = {
+  { .name = "overlong NUL", .text = "\xC0\x80" },
+  { .name = "overlong two-byte", .text = "\xC1\xBF" },
+  { .name = "overlong three-byte", .text = "\xE0\x9F\xBF" },
+  { .name = "overlong four-byte", .text = "\xF0\x8F\xBF\xBF" },
+  { .name = "high surrogate", .text = "\xED\xA0\x80" },
+  { .name = "low surrogate", .text = "\xED\xBF\xBF" },
+  { .name = "beyond U+10FFFF", .text = "\xF4\x90\x80\x80" },
+  { .name = "largest four-byte", .text = "\xF7\xBF\xBF\xBF" },
+  { .name = "five-byte", .text = "\xF8\x88\x80\x80\x80" },
+  { .name = "truncated", .text = "a\xE2\x82" },
+  { .name = "stray continuation", .text = "a\x80" },
+
+  { .name = "smallest two-byte", .text = "\xC2\x80", .valid = 1 },
+  { .name = "before the surrogates", .text = "\xED\x9F\xBF", .valid = 1 },
+  { .name = "after the surrogates", .text = "\xEE\x80\x80", .valid = 1 },
+  { .name = "U+10FFFF", .text = "\xF4\x8F\xBF\xBF", .valid = 1 },
+};
+
+static int
+verifyDecodingCases (void) {
+  for (unsigned int index=0; index<ARRAY_COUNT(decodingCases); index+=1) {
+    const DecodingCase *dc = &decodingCases[index];
+    const char *utf8 = dc->text;
+    size_t utfs = strlen(utf8);
+    wchar_t characters[utfs];
+    wchar_t *character = characters;
+    size_t count = utfs;
+
+    if (convertUtf8TextToWchars(&utf8, &utfs, &character, &count) != dc->valid) {
+      logMessage(LOG_ERR, "UTF-8 sequence %s: %s",
+                 (dc->valid? "rejected": "accepted"), dc->name);
+      return 0;
+    }
+  }
+
+  return 1;
+}
+
+static int
+verifyConversions (void) {
+  for (unsigned int iteration=0; iteration<0X4000; iteration+=1) {
+    const CharacterSet *set = &characterSets[randomInteger(ARRAY_COUNT(characterSets))];
+    unsigned int count = randomInteger(TEXT_LIMIT) + 1;
+    wchar_t characters[count];
+    char text[(count * UTF8_LEN_MAX) + 1];
+    size_t length;
+
+    fillCharacters(characters, count, set);
+    if (!randomInteger(4)) characters[randomInteger(count)] = randomInteger(0X110000);
+
+    if (!testEncoding(characters, count, sizeof(text))) return 0;
+    if (!testEncoding(characters, count, randomInteger(sizeof(text)) + 1)) return 0;
+
+    length = makeUtf8FromWchars(characters, count, text, sizeof(text));
+    if (!testDecoding(text, length, count)) return 0;
+    if (!testDecoding(text, length, randomInteger(count) + 1)) return 0;
+
+    {
+      unsigned int changes = randomInteger(3);
+
+      while (changes--) text[randomInteger(length)] = rand();
+      if (!testDecoding(text, length, count)) return 0;
+    }
+  }
+
+  return 1;
+}
+
+int
+main (int argc, char *argv[]) {
+  {
+    static const OptionsDescriptor descriptor = {
+      OPTION_TABLE(programOptions),
+      .applicationName = "utf8test",
+      .argumentsSummary = ""
+    };
+
+    PROCESS_OPTIONS(descriptor, argc, argv);
+  }
+
+  srand(1);
+  if (!verifyDecodingCases()) return PROG_EXIT_FATAL;
+  if (!verifyConversions()) return PROG_EXIT_FATAL;
+
+  return PROG_EXIT_SUCCESS;
+}